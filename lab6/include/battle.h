@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "npc.h"
+
+//Плотное битовое множество по индексам NPC
+class KilledSet {
+private:
+    std::vector<std::uint64_t> words;
+    std::size_t bits;
+
+public:
+    explicit KilledSet(std::size_t size = 0) : words((size + 63) / 64, 0), bits(size) {}
+
+    bool test(std::size_t i) const { return (words[i / 64] >> (i % 64)) & 1; }
+    void set(std::size_t i) { words[i / 64] |= std::uint64_t(1) << (i % 64); }
+    std::size_t size() const { return bits; }
+    std::size_t count() const;
+
+    //f(i) для каждого выставленного бита по возрастанию
+    template<typename F>
+    void forEach(F&& f) const {
+        for (std::size_t w = 0; w < words.size(); ++w) {
+            std::uint64_t word = words[w];
+            while (word) {
+                f(w * 64 + static_cast<std::size_t>(__builtin_ctzll(word)));
+                word &= word - 1;
+            }
+        }
+    }
+};
+
+//Один раунд боя. Атакующие перебираются в порядке npcs, защитники каждого
+//атакующего - тоже в порядке npcs, как в прямом двойном цикле; бой идет,
+//если оба живы и расстояние не больше distance. Правила - FightVisitor,
+//дракон, напавший на рыцаря, погибает вместе с ним.
+//Кандидаты ищутся по сетке с ячейкой не меньше distance, поэтому
+//проверяются только соседние ячейки. Возвращает убитых по индексам npcs.
+KilledSet battleRound(const std::vector<std::shared_ptr<NPC>>& npcs, int distance);
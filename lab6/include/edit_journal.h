@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include "npc.h"
+
+//Итог воспроизведения журнала правок
+struct JournalReplay {
+    std::size_t records = 0; //применено записей
+    bool truncated = false;  //хвост оборван или поврежден и отброшен
+    bool stale = false;      //журнал от другой версии файла или без заголовка, не применялся
+};
+
+//Журнал правок редактора, только дописываемый. Лежит рядом с файлом
+//сохранения: FILE.journal. Сам FILE остается в формате saveNPCs.
+//
+//Первая строка "E 1 <размер FILE в байтах> <FNV-1a FILE>", дальше правки. Позиции - номера
+//в списке редактора с нуля, как в SlotMap после всех предыдущих правок:
+//  A              затем запись NPC::save (добавление в конец)
+//  D <p> <p>...   удаление, позиции по возрастанию, до удаления
+//  R <p>          затем строка с новым именем
+//  C              очистка
+//Правки копятся в буфере и дописываются в журнал на commit(), поэтому
+//сохранение после нескольких правок стоит только этих правок. Когда журнал
+//разрастается больше двух файлов, редактор переписывает FILE целиком и
+//начинает журнал заново (start). Размер и контрольная сумма FILE в заголовке
+//отсекают журнал, оставшийся от другой версии файла, даже той же длины:
+//правки адресуют позиции и на чужом содержимом задели бы не тех NPC.
+class EditJournal {
+public:
+    static constexpr std::size_t MIN_COMPACT_BYTES = 1 << 20;
+
+    explicit EditJournal(std::size_t minCompactBytes = MIN_COMPACT_BYTES);
+
+    //Путь журнала для файла сохранения
+    static std::string pathFor(const std::string& filename);
+
+    //Правки копятся, только пока журнал привязан к файлу
+    void add(const NPC& npc);
+    void remove(const std::vector<std::size_t>& positions);
+    void rename(std::size_t position, const std::string& name);
+    void clear();
+
+    //FILE только что записан целиком: журнал начинается заново.
+    //Бросает std::runtime_error, если журнал не записался
+    void start(const std::string& filename);
+    //Редактор пуст и загрузил FILE вместе с журналом: правки дописываются к нему
+    void attach(const std::string& filename);
+    //Состояние редактора больше не совпадает ни с одним файлом
+    void detach();
+
+    //Файл, к которому привязан журнал; пусто - ни к какому
+    const std::string& target() const;
+    //Правок больше, чем стоит переписать FILE целиком
+    bool needsCompaction() const;
+    //Дописывает правки из буфера, возвращает их число.
+    //Бросает std::runtime_error, если журнал не записался
+    std::size_t commit();
+
+    //Применяет журнал FILE к npcs, загруженным из FILE. Нет журнала - ничего не делает.
+    //Бросает std::runtime_error только на журнале другой версии формата
+    static JournalReplay replay(const std::string& filename, std::vector<std::shared_ptr<NPC>>& npcs);
+
+private:
+    std::string file;
+    std::string buffer;
+    std::size_t pending;
+    std::size_t snapshotBytes;
+    std::size_t journalBytes;
+    std::size_t minCompactBytes;
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include "npc.h"
+
+//Правила боя на этапе компиляции: кто кого может убить
+//(рыцарь убивает дракона, дракон ест пегаса). Повторяет FightVisitor;
+//battle() по таблице отбрасывает пары, в которых боя заведомо не будет,
+//и вызывает Visitor только для остальных.
+namespace fight_rules {
+
+constexpr std::size_t TYPE_COUNT = 4;
+
+//KILLS[атакующий][защитник], индексы - значения NpcType
+constexpr bool KILLS[TYPE_COUNT][TYPE_COUNT] = {
+    //           Unknown Dragon Knight Pegasus
+    /* Unknown */ {false, false, false, false},
+    /* Dragon  */ {false, false, false, true },
+    /* Knight  */ {false, true,  false, false},
+    /* Pegasus */ {false, false, false, false},
+};
+
+constexpr std::size_t index(NpcType type) {
+    return static_cast<std::size_t>(type) < TYPE_COUNT ? static_cast<std::size_t>(type) : 0;
+}
+
+constexpr bool canKill(NpcType attacker, NpcType defender) {
+    return KILLS[index(attacker)][index(defender)];
+}
+
+//Может ли тип вообще кого-то атаковать
+constexpr bool canAttack(NpcType attacker) {
+    for (std::size_t defender = 0; defender < TYPE_COUNT; ++defender) {
+        if (KILLS[index(attacker)][defender]) return true;
+    }
+    return false;
+}
+
+static_assert(canKill(NpcType::Knight, NpcType::Dragon), "Knight kills Dragon");
+static_assert(canKill(NpcType::Dragon, NpcType::Pegasus), "Dragon eats Pegasus");
+static_assert(!canAttack(NpcType::Pegasus), "Pegasus never attacks");
+
+} //namespace fight_rules
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "npc.h"
+
+//Результат загрузки: NPC в порядке записей файла
+struct LoadResult {
+    std::vector<std::shared_ptr<NPC>> npcs;
+    std::size_t declared = 0; //количество из первой строки файла
+    std::size_t failed = 0;   //записи, которые не удалось разобрать
+};
+
+//Быстрый загрузчик текстового формата NPC::save.
+//Файл отображается в память и режется на куски по пустым строкам-разделителям
+//записей; куски разбираются параллельно через std::from_chars и склеиваются
+//в исходном порядке. Формат файла тот же, что у saveNPCs/NPCFactory::loadNPC.
+class NPCLoader {
+public:
+    //Куски меньше этого размера не выделяются в отдельный поток
+    static constexpr std::size_t MIN_CHUNK_BYTES = 1 << 20;
+
+    //threads == 0 - по числу ядер. Бросает std::runtime_error,
+    //если файл не открылся или в первой строке нет количества
+    static LoadResult loadFile(const std::string& filename, unsigned threads = 0);
+
+    //Разбор уже прочитанного текста файла
+    static LoadResult parse(std::string_view text, unsigned threads = 0,
+                            std::size_t minChunk = MIN_CHUNK_BYTES);
+};
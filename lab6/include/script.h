@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+//Память процесса в байтах: текущий и наибольший размер резидентной части
+struct MemoryUsage {
+    std::size_t rss = 0;
+    std::size_t peak = 0;
+};
+
+MemoryUsage memoryUsage();
+
+//Пакетный режим: по одной команде на строку, слова через пробелы,
+//пустые строки и строки с '#' в начале пропускаются. После каждой
+//команды в отчет пишется время ее выполнения и память процесса.
+//Встроенные команды: time - время с начала сценария, help - список команд.
+class ScriptRunner {
+public:
+    using Args = std::vector<std::string>;
+    using Handler = std::function<void(const Args& args)>;
+
+    //minArgs - сколько слов после имени команды обязательно
+    void addCommand(const std::string& name, std::size_t minArgs,
+                    const std::string& usage, Handler handler);
+
+    //Возвращает число выполненных команд. Бросает std::runtime_error
+    //с номером строки на неизвестной команде или ошибке обработчика
+    std::size_t run(std::istream& script, std::ostream& report);
+
+    void printHelp(std::ostream& os) const;
+
+private:
+    struct Command {
+        std::size_t minArgs;
+        std::string usage;
+        Handler handler;
+    };
+
+    std::map<std::string, Command> commands;
+};
+
+//Пока объект жив, все, что пишется в поток, отбрасывается
+class ScopedSilence {
+private:
+    class NullBuffer : public std::streambuf {
+    protected:
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+    };
+
+    NullBuffer null;
+    std::ostream& stream;
+    std::streambuf* saved;
+
+public:
+    explicit ScopedSilence(std::ostream& os) : stream(os), saved(os.rdbuf(&null)) {}
+    ~ScopedSilence() { stream.rdbuf(saved); }
+
+    ScopedSilence(const ScopedSilence&) = delete;
+    ScopedSilence& operator=(const ScopedSilence&) = delete;
+};
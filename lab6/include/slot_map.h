@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+//Слот-карта: значения лежат подряд в одном векторе, доступ снаружи - по
+//дескрипторам (индекс слота + поколение). Вставка - O(1). Удаление
+//сохраняет порядок остальных значений (номера в списке редактора не
+//перескакивают), поэтому сдвигает хвост - O(n); пачку удалений removeIf
+//делает за один проход. Дескриптор удаленного элемента перестает
+//действовать, даже если его слот занят заново.
+//Порядок обхода определяется только последовательностью операций.
+template<typename T>
+class SlotMap {
+public:
+    struct Handle {
+        std::uint32_t index = UINT32_MAX;
+        std::uint32_t generation = 0;
+
+        bool operator==(const Handle& other) const {
+            return index == other.index && generation == other.generation;
+        }
+        bool operator!=(const Handle& other) const { return !(*this == other); }
+    };
+
+private:
+    struct Slot {
+        std::uint32_t dense;      //позиция значения или следующий свободный слот
+        std::uint32_t generation;
+    };
+
+    static constexpr std::uint32_t NO_SLOT = UINT32_MAX;
+
+    std::vector<T> values;
+    std::vector<std::uint32_t> owners;  //слот каждого значения
+    std::vector<Slot> slots;
+    std::uint32_t freeHead = NO_SLOT;
+
+    //Слот удаленного значения уходит в список свободных
+    void release(std::uint32_t index) {
+        Slot& slot = slots[index];
+        slot.generation++;
+        slot.dense = freeHead;
+        freeHead = index;
+    }
+
+    const Slot* find(Handle handle) const {
+        if (handle.index >= slots.size()) return nullptr;
+        const Slot& slot = slots[handle.index];
+        //Нечетное поколение - слот занят
+        if (slot.generation != handle.generation || (slot.generation & 1) == 0) return nullptr;
+        return &slot;
+    }
+
+public:
+    using iterator = typename std::vector<T>::iterator;
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+    Handle insert(T value) {
+        std::uint32_t index;
+        if (freeHead != NO_SLOT) {
+            index = freeHead;
+            freeHead = slots[index].dense;
+        } else {
+            if (slots.size() >= NO_SLOT) {
+                throw std::length_error("SlotMap: too many slots");
+            }
+            index = static_cast<std::uint32_t>(slots.size());
+            slots.push_back({0, 0});
+        }
+        Slot& slot = slots[index];
+        slot.dense = static_cast<std::uint32_t>(values.size());
+        slot.generation++;
+        values.push_back(std::move(value));
+        owners.push_back(index);
+        return {index, slot.generation};
+    }
+
+    //false, если дескриптор уже недействителен
+    bool erase(Handle handle) {
+        if (!find(handle)) return false;
+        eraseAt(slots[handle.index].dense);
+        return true;
+    }
+
+    //Удаление по позиции в порядке обхода; следующие сдвигаются на одну
+    void eraseAt(std::size_t position) {
+        if (position >= values.size()) {
+            throw std::out_of_range("SlotMap: position out of range");
+        }
+        std::uint32_t index = owners[position];
+        values.erase(values.begin() + static_cast<std::ptrdiff_t>(position));
+        owners.erase(owners.begin() + static_cast<std::ptrdiff_t>(position));
+        for (std::size_t p = position; p < owners.size(); ++p) {
+            slots[owners[p]].dense = static_cast<std::uint32_t>(p);
+        }
+        release(index);
+    }
+
+    //Удаляет значения, для которых pred(позиция, значение) истинно, за один
+    //проход; порядок остальных сохраняется. Возвращает число удаленных
+    template<typename Pred>
+    std::size_t removeIf(Pred&& pred) {
+        std::size_t kept = 0;
+        for (std::size_t p = 0; p < values.size(); ++p) {
+            if (pred(p, static_cast<const T&>(values[p]))) {
+                release(owners[p]);
+                continue;
+            }
+            if (kept != p) {
+                values[kept] = std::move(values[p]);
+                owners[kept] = owners[p];
+            }
+            slots[owners[kept]].dense = static_cast<std::uint32_t>(kept);
+            ++kept;
+        }
+        std::size_t removed = values.size() - kept;
+        values.erase(values.begin() + static_cast<std::ptrdiff_t>(kept), values.end());
+        owners.resize(kept);
+        return removed;
+    }
+
+    bool contains(Handle handle) const { return find(handle) != nullptr; }
+
+    //nullptr, если дескриптор недействителен
+    T* get(Handle handle) {
+        const Slot* slot = find(handle);
+        return slot ? &values[slot->dense] : nullptr;
+    }
+    const T* get(Handle handle) const {
+        const Slot* slot = find(handle);
+        return slot ? &values[slot->dense] : nullptr;
+    }
+
+    Handle handleAt(std::size_t position) const {
+        std::uint32_t index = owners.at(position);
+        return {index, slots[index].generation};
+    }
+
+    T& operator[](std::size_t position) { return values[position]; }
+    const T& operator[](std::size_t position) const { return values[position]; }
+
+    //Все значения подряд, в порядке обхода
+    const std::vector<T>& data() const { return values; }
+
+    std::size_t size() const { return values.size(); }
+    bool empty() const { return values.empty(); }
+
+    void reserve(std::size_t count) {
+        values.reserve(count);
+        owners.reserve(count);
+        slots.reserve(count);
+    }
+
+    //Все дескрипторы становятся недействительными
+    void clear() {
+        for (std::uint32_t index : owners) {
+            release(index);
+        }
+        values.clear();
+        owners.clear();
+    }
+
+    iterator begin() { return values.begin(); }
+    iterator end() { return values.end(); }
+    const_iterator begin() const { return values.begin(); }
+    const_iterator end() const { return values.end(); }
+};
@@ -1,18 +1,25 @@
 #include <iostream>
 #include <memory>
 #include <vector>
-#include <set>
 #include <fstream>
 #include <limits>
 #include <cstdlib>
+#include <cstdio>
 #include <ctime>
+#include <algorithm>
 
 #include "npc.h"
 #include "factory.h"
 #include "visitor.h"
 #include "observer.h"
+#include "battle.h"
+#include "loader.h"
+#include "slot_map.h"
+#include "script.h"
+#include "edit_journal.h"
 
-using NPCSet = std::set<std::shared_ptr<NPC>>;
+//NPC подряд в памяти, порядок обхода зависит только от операций
+using NPCSet = SlotMap<std::shared_ptr<NPC>>;
 
 
 //Глобальные observers (или можно сделать их статическими в классе)
@@ -20,8 +27,23 @@ static auto consoleObserver = std::make_shared<ConsoleObserver>();
 static auto fileObserver = std::make_shared<FileObserver>("battle_log.txt");
 
 
-//Сохранение всех NPC в файл
-void saveNPCs(const NPCSet& npcs, const std::string& filename) {
+//Сохранение всех NPC в файл. В файл, к которому привязан журнал,
+//дописываются только правки с прошлого сохранения
+void saveNPCs(const NPCSet& npcs, const std::string& filename, EditJournal& journal) {
+    if (journal.target() == filename && !journal.needsCompaction()) {
+        try {
+            std::size_t changes = journal.commit();
+            std::cout << "Successfully saved " << changes << " changes to "
+                      << EditJournal::pathFor(filename) << std::endl;
+            return;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << ", saving the whole file" << std::endl;
+        }
+    }
+    
+    //Старый журнал к новому файлу не относится
+    journal.detach();
+    std::remove(EditJournal::pathFor(filename).c_str());
     std::ofstream file(filename);
     if (!file.is_open()) {
         std::cerr << "Error: Cannot open file " << filename << " for writing" << std::endl;
@@ -38,92 +60,107 @@ void saveNPCs(const NPCSet& npcs, const std::string& filename) {
     
     file.close();
     std::cout << "Successfully saved " << npcs.size() << " NPCs to " << filename << std::endl;
-}
-
-//Загрузка NPC из файла
-NPCSet loadNPCs(const std::string& filename) {
-    NPCSet npcs;
-    std::ifstream file(filename);
     
-    if (!file.is_open()) {
-        std::cerr << "Error: Cannot open file " << filename << " for reading" << std::endl;
-        return npcs;
-    }
-    
-    //Читаем количество NPC
-    std::string line;
-    if (!std::getline(file, line)) {
-        std::cerr << "Error reading NPC count from file" << std::endl;
-        return npcs;
+    try {
+        journal.start(filename);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
     }
-    
-    line.erase(0, line.find_first_not_of(" \t"));
-    line.erase(line.find_last_not_of(" \t") + 1);
-    
-    int count;
+}
+
+//Загрузка NPC из файла вместе с его журналом правок, новые NPC добавляются к npcs
+std::size_t loadNPCs(const std::string& filename, NPCSet& npcs, EditJournal& journal) {
+    LoadResult result;
+    JournalReplay replayed;
     try {
-        count = std::stoi(line);
+        result = NPCLoader::loadFile(filename);
+        replayed = EditJournal::replay(filename, result.npcs);
     } catch (const std::exception& e) {
-        std::cerr << "Error parsing NPC count: '" << line << "'" << std::endl;
-        return npcs;
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 0;
     }
     
-    //Пропускаем пустую строку после количества
-    std::getline(file, line);
+    std::cout << "Loading " << result.declared << " NPCs from " << filename << "..." << std::endl;
+    if (replayed.stale) {
+        std::cerr << "  Ignoring " << EditJournal::pathFor(filename)
+                  << ": it is damaged or was written for another version of the file" << std::endl;
+    } else if (replayed.records > 0 || replayed.truncated) {
+        std::cout << "  Applied " << replayed.records << " changes from "
+                  << EditJournal::pathFor(filename)
+                  << (replayed.truncated ? " (damaged tail dropped)" : "") << std::endl;
+    }
     
-    std::cout << "Loading " << count << " NPCs from " << filename << "..." << std::endl;
+    //Пустой редактор совпадает с файлом, и правки можно дописывать к его журналу
+    bool wasEmpty = npcs.empty();
+    if (wasEmpty && !replayed.truncated) {
+        try {
+            journal.attach(filename);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            journal.detach();
+        }
+    } else if (wasEmpty) {
+        journal.detach();
+    }
     
-    //Загружаем каждого NPC
-    int loadedCount = 0;
-    for (int i = 0; i < count; ++i) {
-        auto npc = NPCFactory::loadNPC(file);
-        if (npc) {
-            //Подписываем на observers
-            npc->subscribe(consoleObserver);
-            npc->subscribe(fileObserver);
-            npcs.insert(npc);
-            loadedCount++;
+    //Подробный вывод только для небольших файлов, иначе печать дольше загрузки
+    bool verbose = result.npcs.size() <= 100;
+    npcs.reserve(npcs.size() + result.npcs.size());
+    for (auto& npc : result.npcs) {
+        //Подписываем на observers
+        npc->subscribe(consoleObserver);
+        npc->subscribe(fileObserver);
+        if (!wasEmpty) {
+            journal.add(*npc);
+        }
+        npcs.insert(npc);
+        if (verbose) {
             std::cout << "  Loaded: " << *npc << std::endl;
-        } else {
-            std::cerr << "  Failed to load NPC #" << (i + 1) << std::endl;
         }
     }
     
-    file.close();
-    std::cout << "Successfully loaded " << loadedCount << " out of " << count << " NPCs" << std::endl;
-    return npcs;
+    if (result.failed > 0) {
+        std::cerr << "  Failed to load " << result.failed << " NPCs" << std::endl;
+    }
+    std::cout << "Successfully loaded " << result.npcs.size() << " out of " << result.declared << " NPCs" << std::endl;
+    return result.npcs.size();
 }
 
-//Боевой режим с использованием Visitor
-NPCSet battle(NPCSet& npcs, int distance) {
-    NPCSet killed;
-    auto visitor = std::make_shared<FightVisitor>();
+//Боевой режим с использованием Visitor, убитые удаляются из npcs.
+//Возвращает количество убитых
+std::size_t battle(NPCSet& npcs, int distance, EditJournal& journal) {
+    KilledSet killed = battleRound(npcs.data(), distance);
+    if (!journal.target().empty()) {
+        std::vector<std::size_t> positions;
+        killed.forEach([&positions](std::size_t i) { positions.push_back(i); });
+        journal.remove(positions);
+    }
     
-    for (const auto& attacker : npcs) {
-        for (const auto& defender : npcs) {
-            if (attacker != defender && 
-                attacker->isClose(defender, distance) &&
-                killed.find(defender) == killed.end() &&
-                killed.find(attacker) == killed.end()) {
-                
-                bool result = defender->accept(visitor, attacker);
-                if (result) {
-                    //Уведомляем о победе
-                    attacker->notifyFight(defender, true);
-                    killed.insert(defender);
-                    
-                    //Проверяем, может ли атакующий тоже погибнуть
-                    if (attacker->getType() == NpcType::Dragon && 
-                        defender->getType() == NpcType::Knight) {
-                        //Если дракон атаковал рыцаря, дракон тоже умирает
-                        killed.insert(attacker);
-                    }
-                }
-            }
+    //Убитые удаляются одним проходом, выжившие остаются в прежнем порядке
+    return npcs.removeIf([&killed](std::size_t i, const std::shared_ptr<NPC>&) {
+        return killed.test(i);
+    });
+}
+
+//Генерация случайных NPC
+void generateNPCs(NPCSet& npcs, int count, EditJournal& journal) {
+    npcs.reserve(npcs.size() + static_cast<std::size_t>(std::max(count, 0)));
+    for (int i = 0; i < count; ++i) {
+        NpcType type = static_cast<NpcType>((std::rand() % 3) + 1);
+        int x = std::rand() % 501;
+        int y = std::rand() % 501;
+        
+        std::string name = NPCFactory::getStringFromType(type) + 
+                          "_" + std::to_string(i+1);
+        
+        auto npc = NPCFactory::createNPC(type, x, y, name);
+        if (npc) {
+            npc->subscribe(consoleObserver);
+            npc->subscribe(fileObserver);
+            journal.add(*npc);
+            npcs.insert(npc);
         }
     }
-    
-    return killed;
 }
 
 //Печать всех NPC
@@ -146,14 +183,129 @@ void showMenu() {
     std::cout << "6. Start battle mode" << std::endl;
     std::cout << "7. Generate random NPCs" << std::endl;
     std::cout << "8. Clear all NPCs" << std::endl;
+    std::cout << "9. Rename NPC" << std::endl;
     std::cout << "0. Exit" << std::endl;
     std::cout << "Choice: ";
 }
 
-int main() {
-    std::srand(std::time(nullptr));
+//Пакетный режим: команды из файла или stdin ("-"), без вопросов
+int runScript(const std::string& path) {
+    std::ifstream file;
+    if (path != "-") {
+        file.open(path);
+        if (!file.is_open()) {
+            std::cerr << "Error: Cannot open script " << path << std::endl;
+            return 1;
+        }
+    }
+    std::istream& script = path == "-" ? std::cin : file;
+    
     NPCSet npcs;
+    EditJournal journal;
+    //Сообщения о боях в консоль при миллионах NPC дольше самих боев
+    bool quiet = true;
+    ScriptRunner runner;
+    
+    runner.addCommand("gen", 1, "gen COUNT", [&](const ScriptRunner::Args& args) {
+        int count = std::stoi(args[0]);
+        generateNPCs(npcs, count, journal);
+        std::cout << "Generated " << count << " random NPCs." << std::endl;
+    });
+    runner.addCommand("add", 3, "add TYPE X Y [NAME]", [&](const ScriptRunner::Args& args) {
+        NpcType type = NPCFactory::getTypeFromString(args[0]);
+        if (type == NpcType::Unknown) {
+            throw std::invalid_argument("unknown NPC type " + args[0]);
+        }
+        std::string name;
+        for (std::size_t i = 3; i < args.size(); ++i) {
+            name += (i > 3 ? " " : "") + args[i];
+        }
+        auto npc = NPCFactory::createNPC(type, std::stoi(args[1]), std::stoi(args[2]), name);
+        npc->subscribe(consoleObserver);
+        npc->subscribe(fileObserver);
+        journal.add(*npc);
+        npcs.insert(npc);
+    });
+    runner.addCommand("remove", 1, "remove INDEX", [&](const ScriptRunner::Args& args) {
+        int index = std::stoi(args[0]);
+        if (index <= 0 || static_cast<std::size_t>(index) > npcs.size()) {
+            throw std::out_of_range("no NPC with index " + args[0]);
+        }
+        npcs.eraseAt(index - 1);
+        journal.remove({static_cast<std::size_t>(index - 1)});
+    });
+    runner.addCommand("rename", 2, "rename INDEX NAME", [&](const ScriptRunner::Args& args) {
+        int index = std::stoi(args[0]);
+        if (index <= 0 || static_cast<std::size_t>(index) > npcs.size()) {
+            throw std::out_of_range("no NPC with index " + args[0]);
+        }
+        std::string name;
+        for (std::size_t i = 1; i < args.size(); ++i) {
+            name += (i > 1 ? " " : "") + args[i];
+        }
+        npcs[index - 1]->setName(name);
+        journal.rename(index - 1, name);
+    });
+    runner.addCommand("battle", 1, "battle DISTANCE", [&](const ScriptRunner::Args& args) {
+        int distance = std::stoi(args[0]);
+        std::size_t killed;
+        if (quiet) {
+            ScopedSilence silence(std::cout);
+            killed = battle(npcs, distance, journal);
+        } else {
+            killed = battle(npcs, distance, journal);
+        }
+        std::cout << "Battle finished. " << killed << " NPCs killed, "
+                  << npcs.size() << " NPCs survived." << std::endl;
+    });
+    runner.addCommand("save", 1, "save FILE", [&](const ScriptRunner::Args& args) {
+        saveNPCs(npcs, args[0], journal);
+    });
+    runner.addCommand("load", 1, "load FILE", [&](const ScriptRunner::Args& args) {
+        loadNPCs(args[0], npcs, journal);
+    });
+    runner.addCommand("print", 0, "print", [&](const ScriptRunner::Args&) {
+        printNPCs(npcs);
+    });
+    runner.addCommand("count", 0, "count", [&](const ScriptRunner::Args&) {
+        std::cout << npcs.size() << " NPCs" << std::endl;
+    });
+    runner.addCommand("clear", 0, "clear", [&](const ScriptRunner::Args&) {
+        npcs.clear();
+        journal.clear();
+    });
+    runner.addCommand("seed", 1, "seed N", [&](const ScriptRunner::Args& args) {
+        std::srand(static_cast<unsigned>(std::stoul(args[0])));
+    });
+    runner.addCommand("quiet", 1, "quiet on|off", [&](const ScriptRunner::Args& args) {
+        if (args[0] != "on" && args[0] != "off") {
+            throw std::invalid_argument("expected on or off");
+        }
+        quiet = args[0] == "on";
+    });
+    
+    try {
+        runner.run(script, std::cout);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    std::srand(std::time(nullptr));
     
+    if (argc == 3 && std::string(argv[1]) == "--script") {
+        return runScript(argv[2]);
+    }
+    if (argc != 1) {
+        std::cerr << "Usage: " << argv[0] << " [--script FILE|-]" << std::endl;
+        return 1;
+    }
+    
+    NPCSet npcs;
+    EditJournal journal;
     
     int choice;
     
@@ -190,6 +342,7 @@ int main() {
                     // Подписываемся на observers
                     npc->subscribe(consoleObserver);
                     npc->subscribe(fileObserver);
+                    journal.add(*npc);
                     npcs.insert(npc);
                     std::cout << "NPC added successfully!" << std::endl;
                 }
@@ -208,10 +361,9 @@ int main() {
                 int index;
                 std::cin >> index;
                 
-                if (index > 0 && index <= npcs.size()) {
-                    auto it = npcs.begin();
-                    std::advance(it, index - 1);
-                    npcs.erase(it);
+                if (index > 0 && static_cast<std::size_t>(index) <= npcs.size()) {
+                    npcs.eraseAt(index - 1);
+                    journal.remove({static_cast<std::size_t>(index - 1)});
                     std::cout << "NPC removed." << std::endl;
                 } else {
                     std::cout << "Invalid index!" << std::endl;
@@ -227,7 +379,7 @@ int main() {
                 std::cout << "\nEnter filename to save: ";
                 std::string filename;
                 std::getline(std::cin, filename);
-                saveNPCs(npcs, filename);
+                saveNPCs(npcs, filename, journal);
                 break;
             }
             
@@ -236,13 +388,7 @@ int main() {
                 std::string filename;
                 std::getline(std::cin, filename);
                 
-                auto loaded = loadNPCs(filename);
-                //Подписываем новых NPC на observers
-                for (auto& npc : loaded) {
-                    npc->subscribe(consoleObserver);
-                    npc->subscribe(fileObserver);
-                }
-                npcs.insert(loaded.begin(), loaded.end());
+                loadNPCs(filename, npcs, journal);
                 break;
             }
             
@@ -258,14 +404,9 @@ int main() {
                 std::cin >> distance;
                 
                 std::cout << "\nStarting battle with " << npcs.size() << " NPCs..." << std::endl;
-                auto killed = battle(npcs, distance);
+                std::size_t killed = battle(npcs, distance, journal);
                 
-                //Удаляем убитых
-                for (const auto& dead : killed) {
-                    npcs.erase(dead);
-                }
-                
-                std::cout << "Battle finished. " << killed.size() << " NPCs killed." << std::endl;
+                std::cout << "Battle finished. " << killed << " NPCs killed." << std::endl;
                 std::cout << npcs.size() << " NPCs survived." << std::endl;
                 break;
             }
@@ -275,30 +416,43 @@ int main() {
                 int count;
                 std::cin >> count;
                 
-                for (int i = 0; i < count; ++i) {
-                    NpcType type = static_cast<NpcType>((std::rand() % 3) + 1);
-                    int x = std::rand() % 501;
-                    int y = std::rand() % 501;
-                    
-                    std::string name = NPCFactory::getStringFromType(type) + 
-                                      "_" + std::to_string(i+1);
-                    
-                    auto npc = NPCFactory::createNPC(type, x, y, name);
-                    if (npc) {
-                        npc->subscribe(consoleObserver);
-                        npc->subscribe(fileObserver);
-                        npcs.insert(npc);
-                    }
-                }
+                generateNPCs(npcs, count, journal);
                 std::cout << "Generated " << count << " random NPCs." << std::endl;
                 break;
             }
             
             case 8: //Очистить всех NPC
                 npcs.clear();
+                journal.clear();
                 std::cout << "All NPCs cleared." << std::endl;
                 break;
                 
+            case 9: { //Переименовать NPC
+                std::cout << "\nRename NPC" << std::endl;
+                if (npcs.empty()) {
+                    std::cout << "No NPCs to rename." << std::endl;
+                    break;
+                }
+                
+                printNPCs(npcs);
+                std::cout << "Enter NPC index to rename (1-" << npcs.size() << "): ";
+                int index;
+                std::cin >> index;
+                std::cin.ignore();
+                
+                if (index > 0 && static_cast<std::size_t>(index) <= npcs.size()) {
+                    std::cout << "Enter new name: ";
+                    std::string name;
+                    std::getline(std::cin, name);
+                    npcs[index - 1]->setName(name);
+                    journal.rename(index - 1, name);
+                    std::cout << "NPC renamed." << std::endl;
+                } else {
+                    std::cout << "Invalid index!" << std::endl;
+                }
+                break;
+            }
+                
             case 0: //Выход
                 std::cout << "Goodbye!" << std::endl;
                 break;
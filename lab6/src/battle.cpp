@@ -0,0 +1,188 @@
+#include "battle.h"
+#include "visitor.h"
+#include "fight_rules.h"
+#include "proximity.h"
+#include <algorithm>
+#include <cstdlib>
+
+std::size_t KilledSet::count() const {
+    std::size_t total = 0;
+    for (std::uint64_t word : words) {
+        total += static_cast<std::size_t>(__builtin_popcountll(word));
+    }
+    return total;
+}
+
+namespace {
+
+//Сетка в виде сжатых списков, отдельный список на каждую пару
+//(тип, ячейка): индексы NPC лежат в ids[starts[b]..ends[b]) по возрастанию.
+//Убитые вычищаются из списка при проходе, поэтому повторные проходы
+//видят только живых.
+struct Grid {
+    long long minX = 0;
+    long long minY = 0;
+    long long cell = 1;
+    long long cols = 1;
+    long long rows = 1;
+    std::vector<std::size_t> starts;
+    std::vector<std::size_t> ends;
+    std::vector<std::size_t> ids;
+
+    long long column(int x) const { return (x - minX) / cell; }
+    long long row(int y) const { return (y - minY) / cell; }
+    std::size_t cellCount() const { return static_cast<std::size_t>(cols * rows); }
+    std::size_t bucket(NpcType type, std::size_t cellIndex) const {
+        return fight_rules::index(type) * cellCount() + cellIndex;
+    }
+};
+
+Grid buildGrid(const std::vector<int>& xs, const std::vector<int>& ys,
+               const std::vector<NpcType>& types, long long radius) {
+    Grid grid;
+    auto [minX, maxX] = std::minmax_element(xs.begin(), xs.end());
+    auto [minY, maxY] = std::minmax_element(ys.begin(), ys.end());
+    grid.minX = *minX;
+    grid.minY = *minY;
+
+    //Ячейка не меньше радиуса; на редкой карте укрупняем ее,
+    //чтобы пустые ячейки не занимали память
+    const long long limit = std::max<long long>(1024, 4 * static_cast<long long>(xs.size()));
+    grid.cell = std::max<long long>(radius, 1);
+    for (;;) {
+        grid.cols = (*maxX - grid.minX) / grid.cell + 1;
+        grid.rows = (*maxY - grid.minY) / grid.cell + 1;
+        if (grid.cols * grid.rows <= limit) break;
+        grid.cell *= 2;
+    }
+
+    std::vector<std::size_t> bucketOf(xs.size());
+    grid.starts.assign(fight_rules::TYPE_COUNT * grid.cellCount() + 1, 0);
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        std::size_t cellIndex = static_cast<std::size_t>(grid.row(ys[i]) * grid.cols + grid.column(xs[i]));
+        bucketOf[i] = grid.bucket(types[i], cellIndex);
+        grid.starts[bucketOf[i] + 1]++;
+    }
+    for (std::size_t b = 1; b < grid.starts.size(); ++b) {
+        grid.starts[b] += grid.starts[b - 1];
+    }
+    grid.ids.resize(xs.size());
+    grid.ends.assign(grid.starts.begin(), grid.starts.end() - 1);
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        grid.ids[grid.ends[bucketOf[i]]++] = i;
+    }
+    return grid;
+}
+
+//Один бой пары: правила через Visitor, убитые попадают в killed
+void fightPair(const std::shared_ptr<NPC>& attacker, const std::shared_ptr<NPC>& defender,
+               std::size_t attackerIndex, std::size_t defenderIndex,
+               const std::shared_ptr<FightVisitor>& visitor, KilledSet& killed) {
+    if (killed.test(defenderIndex) || killed.test(attackerIndex)) {
+        return;
+    }
+    if (defender->accept(visitor, attacker)) {
+        //Уведомляем о победе
+        attacker->notifyFight(defender, true);
+        killed.set(defenderIndex);
+        
+        //Если дракон атаковал рыцаря, дракон тоже умирает
+        if (attacker->getType() == NpcType::Dragon &&
+            defender->getType() == NpcType::Knight) {
+            killed.set(attackerIndex);
+        }
+    }
+}
+
+} //namespace
+
+KilledSet battleRound(const std::vector<std::shared_ptr<NPC>>& npcs, int distance) {
+    const std::size_t n = npcs.size();
+    KilledSet killed(n);
+    if (n < 2) {
+        return killed;
+    }
+    auto visitor = std::make_shared<FightVisitor>();
+    
+    //Координаты и типы колонками
+    std::vector<int> xs(n);
+    std::vector<int> ys(n);
+    std::vector<NpcType> types(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        xs[i] = npcs[i]->getX();
+        ys[i] = npcs[i]->getY();
+        types[i] = npcs[i]->getType();
+    }
+    
+    //NPC::isClose сравнивает квадраты, знак дистанции не важен
+    const long long radius = std::llabs(static_cast<long long>(distance));
+    const long long radiusSq = radius * radius;
+    Grid grid = buildGrid(xs, ys, types, radius);
+    
+    //Разности координат соседних ячеек меньше двух ячеек;
+    //векторное ядро точно, пока они не больше MAX_SPAN
+    const bool vectorized = 2 * grid.cell - 1 <= proximity::MAX_SPAN;
+    
+    std::vector<std::size_t> candidates;
+    std::vector<int> candidateXs;
+    std::vector<int> candidateYs;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (killed.test(i) || !fight_rules::canAttack(types[i])) {
+            continue;
+        }
+        
+        //Живые защитники из соседних ячеек, которых этот тип может убить
+        candidates.clear();
+        long long column = grid.column(xs[i]);
+        long long row = grid.row(ys[i]);
+        for (std::size_t t = 0; t < fight_rules::TYPE_COUNT; ++t) {
+            NpcType defenderType = static_cast<NpcType>(t);
+            if (!fight_rules::canKill(types[i], defenderType)) continue;
+            for (long long r = std::max(0LL, row - 1); r <= std::min(grid.rows - 1, row + 1); ++r) {
+                for (long long c = std::max(0LL, column - 1); c <= std::min(grid.cols - 1, column + 1); ++c) {
+                    std::size_t b = grid.bucket(defenderType, static_cast<std::size_t>(r * grid.cols + c));
+                    std::size_t live = grid.starts[b];
+                    for (std::size_t k = grid.starts[b]; k < grid.ends[b]; ++k) {
+                        std::size_t j = grid.ids[k];
+                        if (killed.test(j)) continue;
+                        grid.ids[live++] = j;
+                        if (j != i) candidates.push_back(j);
+                    }
+                    grid.ends[b] = live;
+                }
+            }
+        }
+        //Тот же порядок защитников, что в прямом обходе
+        std::sort(candidates.begin(), candidates.end());
+        
+        if (!vectorized) {
+            for (std::size_t j : candidates) {
+                long long dx = static_cast<long long>(xs[i]) - xs[j];
+                long long dy = static_cast<long long>(ys[i]) - ys[j];
+                if (dx * dx + dy * dy <= radiusSq) {
+                    fightPair(npcs[i], npcs[j], i, j, visitor, killed);
+                }
+            }
+            continue;
+        }
+        
+        candidateXs.resize(candidates.size());
+        candidateYs.resize(candidates.size());
+        for (std::size_t k = 0; k < candidates.size(); ++k) {
+            candidateXs[k] = xs[candidates[k]];
+            candidateYs[k] = ys[candidates[k]];
+        }
+        for (std::size_t block = 0; block < candidates.size(); block += proximity::BLOCK_SIZE) {
+            std::size_t count = std::min(proximity::BLOCK_SIZE, candidates.size() - block);
+            std::uint64_t mask = proximity::withinRadius(xs[i], ys[i], static_cast<int>(radius),
+                                                         candidateXs.data() + block,
+                                                         candidateYs.data() + block, count);
+            proximity::forEachBit(mask, [&](std::size_t k) {
+                std::size_t j = candidates[block + k];
+                fightPair(npcs[i], npcs[j], i, j, visitor, killed);
+            });
+        }
+    }
+    
+    return killed;
+}
@@ -0,0 +1,259 @@
+#include "edit_journal.h"
+#include "factory.h"
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <sys/stat.h>
+
+namespace {
+
+constexpr int VERSION = 1;
+
+//Размер файла в байтах, -1 - файла нет
+long long fileSize(const std::string& path) {
+    struct stat info;
+    if (::stat(path.c_str(), &info) != 0) return -1;
+    return static_cast<long long>(info.st_size);
+}
+
+//Содержимое FILE, к которому относится журнал: размер и FNV-1a всех байт
+struct Fingerprint {
+    long long size = -1;
+    std::uint64_t hash = 0;
+
+    bool operator==(const Fingerprint& other) const {
+        return size == other.size && hash == other.hash;
+    }
+};
+
+//size == -1, если файл не читается
+Fingerprint fingerprint(const std::string& path) {
+    Fingerprint result;
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) return result;
+
+    std::uint64_t hash = 14695981039346656037ull;
+    long long size = 0;
+    char chunk[1 << 16];
+    while (in.read(chunk, sizeof(chunk)) || in.gcount() > 0) {
+        std::streamsize count = in.gcount();
+        for (std::streamsize i = 0; i < count; ++i) {
+            hash = (hash ^ static_cast<unsigned char>(chunk[i])) * 1099511628211ull;
+        }
+        size += count;
+    }
+    if (in.bad()) return result;
+    result.size = size;
+    result.hash = hash;
+    return result;
+}
+
+//Как в NPC::load: пробелы и табуляции по краям не входят в значение
+std::string trim(const std::string& line) {
+    std::size_t first = line.find_first_not_of(" \t");
+    if (first == std::string::npos) return "";
+    std::size_t last = line.find_last_not_of(" \t");
+    return line.substr(first, last - first + 1);
+}
+
+//Отпечаток FILE из заголовка журнала; false - заголовка нет или он поврежден.
+//Бросает std::runtime_error на журнале другой версии
+bool readHeader(const std::string& line, Fingerprint& recorded) {
+    std::istringstream fields(line);
+    std::string op;
+    int version = 0;
+    if (!(fields >> op >> version) || op != "E") return false;
+    if (version != VERSION) {
+        throw std::runtime_error("Unsupported editor journal version " + std::to_string(version));
+    }
+    return static_cast<bool>(fields >> recorded.size >> recorded.hash);
+}
+
+} //namespace
+
+EditJournal::EditJournal(std::size_t minCompact)
+    : pending(0), snapshotBytes(0), journalBytes(0), minCompactBytes(minCompact) {}
+
+std::string EditJournal::pathFor(const std::string& filename) {
+    return filename + ".journal";
+}
+
+void EditJournal::add(const NPC& npc) {
+    if (file.empty()) return;
+    std::ostringstream record;
+    record << "A" << std::endl;
+    npc.save(record);
+    buffer += record.str();
+    ++pending;
+}
+
+void EditJournal::remove(const std::vector<std::size_t>& positions) {
+    if (file.empty() || positions.empty()) return;
+    buffer += "D";
+    for (std::size_t position : positions) {
+        buffer += " " + std::to_string(position);
+    }
+    buffer += "\n";
+    ++pending;
+}
+
+void EditJournal::rename(std::size_t position, const std::string& name) {
+    if (name.find('\n') != std::string::npos) {
+        throw std::invalid_argument("NPC name must be a single line");
+    }
+    if (file.empty()) return;
+    buffer += "R " + std::to_string(position) + "\n" + name + "\n";
+    ++pending;
+}
+
+void EditJournal::clear() {
+    if (file.empty()) return;
+    buffer += "C\n";
+    ++pending;
+}
+
+void EditJournal::start(const std::string& filename) {
+    detach();
+    Fingerprint current = fingerprint(filename);
+    if (current.size < 0) {
+        throw std::runtime_error("Cannot read file " + filename);
+    }
+    std::string header = "E " + std::to_string(VERSION) + " " + std::to_string(current.size) +
+                         " " + std::to_string(current.hash) + "\n";
+    std::ofstream out(pathFor(filename), std::ios::binary | std::ios::trunc);
+    out << header;
+    out.flush();
+    if (!out) {
+        throw std::runtime_error("Cannot write journal " + pathFor(filename));
+    }
+    file = filename;
+    snapshotBytes = static_cast<std::size_t>(current.size);
+    journalBytes = header.size();
+}
+
+void EditJournal::attach(const std::string& filename) {
+    long long journalSize = fileSize(pathFor(filename));
+    std::ifstream in(pathFor(filename), std::ios::binary);
+    std::string line;
+    Fingerprint recorded;
+    if (in.is_open() && std::getline(in, line) && readHeader(line, recorded) &&
+        recorded.size >= 0 && recorded == fingerprint(filename)) {
+        detach();
+        file = filename;
+        snapshotBytes = static_cast<std::size_t>(recorded.size);
+        journalBytes = static_cast<std::size_t>(journalSize);
+        return;
+    }
+    //Журнала нет, заголовок поврежден или журнал от другой версии файла
+    start(filename);
+}
+
+void EditJournal::detach() {
+    file.clear();
+    buffer.clear();
+    pending = 0;
+    snapshotBytes = 0;
+    journalBytes = 0;
+}
+
+const std::string& EditJournal::target() const {
+    return file;
+}
+
+bool EditJournal::needsCompaction() const {
+    return journalBytes + buffer.size() > std::max(minCompactBytes, 2 * snapshotBytes);
+}
+
+std::size_t EditJournal::commit() {
+    if (file.empty() || buffer.empty()) return 0;
+    std::ofstream out(pathFor(file), std::ios::binary | std::ios::app);
+    out << buffer;
+    out.flush();
+    if (!out) {
+        throw std::runtime_error("Cannot write journal " + pathFor(file));
+    }
+    journalBytes += buffer.size();
+    buffer.clear();
+    std::size_t written = pending;
+    pending = 0;
+    return written;
+}
+
+JournalReplay EditJournal::replay(const std::string& filename, std::vector<std::shared_ptr<NPC>>& npcs) {
+    JournalReplay result;
+    std::ifstream journal(pathFor(filename), std::ios::binary);
+    if (!journal.is_open()) {
+        return result;
+    }
+    std::string content((std::istreambuf_iterator<char>(journal)), std::istreambuf_iterator<char>());
+
+    //Строка без перевода строки в конце - оборванная запись
+    if (!content.empty() && content.back() != '\n') {
+        std::size_t last = content.rfind('\n');
+        content.erase(last == std::string::npos ? 0 : last + 1);
+        result.truncated = true;
+    }
+
+    std::istringstream in(content);
+    std::string line;
+    Fingerprint recorded;
+    //Журнал без заголовка не привязан ни к какому файлу, как и устаревший
+    if (!std::getline(in, line) || !readHeader(line, recorded) || recorded.size < 0 ||
+        !(recorded == fingerprint(filename))) {
+        result.stale = true;
+        result.truncated = false;
+        return result;
+    }
+
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string op;
+        //Пустые строки - разделители записей NPC::save
+        if (!(fields >> op)) continue;
+
+        bool ok = true;
+        std::size_t position = 0;
+        if (op == "A") {
+            auto npc = NPCFactory::loadNPC(in);
+            ok = npc != nullptr;
+            if (ok) npcs.push_back(npc);
+        } else if (op == "D") {
+            std::vector<std::size_t> positions;
+            while (fields >> position) {
+                //По возрастанию и в пределах списка
+                ok = ok && position < npcs.size() && (positions.empty() || position > positions.back());
+                positions.push_back(position);
+            }
+            ok = ok && fields.eof() && !positions.empty();
+            if (ok) {
+                //Одним проходом, оставшиеся сохраняют порядок
+                std::size_t next = 0;
+                std::size_t kept = 0;
+                for (std::size_t i = 0; i < npcs.size(); ++i) {
+                    if (next < positions.size() && positions[next] == i) {
+                        ++next;
+                        continue;
+                    }
+                    npcs[kept++] = std::move(npcs[i]);
+                }
+                npcs.resize(kept);
+            }
+        } else if (op == "R" && (fields >> position)) {
+            ok = position < npcs.size() && static_cast<bool>(std::getline(in, line));
+            if (ok) npcs[position]->setName(trim(line));
+        } else if (op == "C") {
+            npcs.clear();
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            result.truncated = true;
+            break;
+        }
+        ++result.records;
+    }
+    return result;
+}
@@ -0,0 +1,239 @@
+#include "loader.h"
+#include "factory.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+//Курсор по строкам куска текста
+struct Lines {
+    const char* pos;
+    const char* end;
+
+    bool done() const { return pos >= end; }
+
+    //Следующая строка без '\n'; false, если строк больше нет
+    bool next(std::string_view& line) {
+        if (pos >= end) return false;
+        const char* stop = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+        if (!stop) stop = end;
+        line = std::string_view(pos, stop - pos);
+        pos = stop < end ? stop + 1 : end;
+        return true;
+    }
+};
+
+//Как в NPC::load: убираем пробелы и табуляции по краям
+std::string_view trim(std::string_view line) {
+    std::size_t first = line.find_first_not_of(" \t");
+    if (first == std::string_view::npos) return {};
+    std::size_t last = line.find_last_not_of(" \t");
+    return line.substr(first, last - first + 1);
+}
+
+bool isBlank(std::string_view line) {
+    return line.find_first_not_of(" \t") == std::string_view::npos;
+}
+
+//Число в начале строки, как std::stoi: знак и цифры, хвост игнорируется
+bool parseInt(std::string_view text, int& value) {
+    const char* first = text.data();
+    const char* last = first + text.size();
+    if (first != last && *first == '+') {
+        ++first;
+        if (first != last && *first == '-') return false;
+    }
+    auto [ptr, ec] = std::from_chars(first, last, value);
+    return ec == std::errc() && ptr != first;
+}
+
+//Разбор одной записи. nullptr - запись повреждена, курсор стоит за ней
+std::shared_ptr<NPC> parseRecord(Lines& lines, std::string_view typeLine) {
+    std::string_view xLine, yLine, nameLine;
+    int typeInt = 0, x = 0, y = 0;
+    bool ok = parseInt(typeLine, typeInt) &&
+              lines.next(xLine) && parseInt(trim(xLine), x) &&
+              lines.next(yLine) && parseInt(trim(yLine), y) &&
+              lines.next(nameLine);
+
+    NpcType type = static_cast<NpcType>(typeInt);
+    if (!ok || (type != NpcType::Dragon && type != NpcType::Knight && type != NpcType::Pegasus)) {
+        //Пропускаем остаток записи до разделителя
+        std::string_view line;
+        while (lines.next(line) && !isBlank(line)) {}
+        return nullptr;
+    }
+
+    std::string name(trim(nameLine));
+    auto npc = NPCFactory::createNPC(type, x, y, name);
+    if (name.empty()) {
+        //createNPC подставляет имя по умолчанию, а файл хранит пустое
+        npc->setName(name);
+    }
+
+    //Пустая строка-разделитель после записи
+    Lines peek = lines;
+    std::string_view separator;
+    if (peek.next(separator) && isBlank(separator)) {
+        lines = peek;
+    }
+    return npc;
+}
+
+//Разбор куска, начинающегося с начала записи. Поврежденные записи - nullptr
+void parseChunk(const char* begin, const char* end, std::vector<std::shared_ptr<NPC>>& out) {
+    Lines lines{begin, end};
+    std::string_view line;
+    while (lines.next(line)) {
+        std::string_view typeLine = trim(line);
+        if (typeLine.empty()) {
+            //Одна пустая строка перед записью допустима, как в NPCFactory::loadNPC
+            if (!lines.next(line)) break;
+            typeLine = trim(line);
+        }
+        out.push_back(parseRecord(lines, typeLine));
+    }
+}
+
+//Начало первой записи не раньше from: непустая строка после пустой
+const char* nextRecordStart(const char* from, const char* begin, const char* end) {
+    if (from <= begin) return begin;
+    //Встаем на начало следующей строки
+    const char* stop = static_cast<const char*>(std::memchr(from, '\n', end - from));
+    if (!stop) return end;
+
+    Lines lines{stop + 1, end};
+    bool previousBlank = false;
+    const char* start = lines.pos;
+    std::string_view line;
+    while (lines.next(line)) {
+        bool blank = isBlank(line);
+        if (previousBlank && !blank) return start;
+        previousBlank = blank;
+        start = lines.pos;
+    }
+    return end;
+}
+
+//Отображение файла только для чтения
+class MappedFile {
+private:
+    const char* data = nullptr;
+    std::size_t length = 0;
+
+public:
+    explicit MappedFile(const std::string& filename) {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open file " + filename + " for reading");
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot read file " + filename);
+        }
+        length = static_cast<std::size_t>(info.st_size);
+        if (length > 0) {
+            void* mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Cannot map file " + filename);
+            }
+            //Файл читается подряд
+            ::madvise(mapped, length, MADV_SEQUENTIAL);
+            data = static_cast<const char*>(mapped);
+        }
+        ::close(fd);
+    }
+
+    ~MappedFile() {
+        if (data) {
+            ::munmap(const_cast<char*>(data), length);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::string_view text() const { return std::string_view(data, length); }
+};
+
+} //namespace
+
+LoadResult NPCLoader::loadFile(const std::string& filename, unsigned threads) {
+    MappedFile file(filename);
+    return parse(file.text(), threads);
+}
+
+LoadResult NPCLoader::parse(std::string_view text, unsigned threads, std::size_t minChunk) {
+    LoadResult result;
+    Lines lines{text.data(), text.data() + text.size()};
+
+    //Количество NPC и пустая строка после него
+    std::string_view line;
+    if (!lines.next(line)) {
+        throw std::runtime_error("Error reading NPC count from file");
+    }
+    int count = 0;
+    if (!parseInt(trim(line), count)) {
+        throw std::runtime_error("Error parsing NPC count: '" + std::string(trim(line)) + "'");
+    }
+    lines.next(line);
+    if (count <= 0) {
+        return result;
+    }
+    result.declared = static_cast<std::size_t>(count);
+
+    //Режем тело на куски по границам записей
+    const char* begin = lines.pos;
+    const char* end = lines.end;
+    std::size_t size = static_cast<std::size_t>(end - begin);
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::size_t chunks = std::max<std::size_t>(1, std::min<std::size_t>(threads, size / std::max<std::size_t>(1, minChunk)));
+
+    std::vector<const char*> bounds{begin};
+    for (std::size_t i = 1; i < chunks; ++i) {
+        const char* start = nextRecordStart(begin + size * i / chunks, begin, end);
+        if (start > bounds.back() && start < end) {
+            bounds.push_back(start);
+        }
+    }
+    bounds.push_back(end);
+
+    //Первый кусок разбирает текущий поток, остальные - свои потоки
+    std::vector<std::vector<std::shared_ptr<NPC>>> parts(bounds.size() - 1);
+    std::vector<std::thread> workers;
+    for (std::size_t i = 1; i < parts.size(); ++i) {
+        workers.emplace_back(parseChunk, bounds[i], bounds[i + 1], std::ref(parts[i]));
+    }
+    parseChunk(bounds[0], bounds[1], parts[0]);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    //Склеиваем в порядке файла; записи сверх количества игнорируются
+    std::size_t total = 0;
+    for (const auto& part : parts) total += part.size();
+    result.npcs.reserve(std::min(total, result.declared));
+    for (auto& part : parts) {
+        for (auto& npc : part) {
+            if (result.npcs.size() + result.failed >= result.declared) break;
+            if (npc) {
+                result.npcs.push_back(std::move(npc));
+            } else {
+                result.failed++;
+            }
+        }
+    }
+    result.failed = result.declared - result.npcs.size();
+    return result;
+}
@@ -0,0 +1,117 @@
+#include "script.h"
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <sys/resource.h>
+#include <unistd.h>
+
+MemoryUsage memoryUsage() {
+    MemoryUsage usage;
+    
+    //Текущий размер - из /proc, в страницах
+    if (std::FILE* statm = std::fopen("/proc/self/statm", "r")) {
+        unsigned long size = 0;
+        unsigned long resident = 0;
+        if (std::fscanf(statm, "%lu %lu", &size, &resident) == 2) {
+            usage.rss = resident * static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        }
+        std::fclose(statm);
+    }
+    
+    //Пиковый - от ядра, в килобайтах
+    struct rusage info;
+    if (::getrusage(RUSAGE_SELF, &info) == 0) {
+        usage.peak = static_cast<std::size_t>(info.ru_maxrss) * 1024;
+    }
+    if (usage.peak < usage.rss) {
+        usage.peak = usage.rss;
+    }
+    return usage;
+}
+
+void ScriptRunner::addCommand(const std::string& name, std::size_t minArgs,
+                              const std::string& usage, Handler handler) {
+    commands[name] = Command{minArgs, usage, std::move(handler)};
+}
+
+void ScriptRunner::printHelp(std::ostream& os) const {
+    os << "Commands:" << std::endl;
+    for (const auto& [name, command] : commands) {
+        os << "  " << command.usage << std::endl;
+    }
+    os << "  time" << std::endl;
+    os << "  help" << std::endl;
+}
+
+//Форматирование через свой поток: флаги report (часто std::cout) не меняются
+static std::string fixed1(double value) {
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(1) << value;
+    return ss.str();
+}
+
+static std::string megabytes(std::size_t bytes) {
+    return fixed1(bytes / (1024.0 * 1024.0)) + " MB";
+}
+
+std::size_t ScriptRunner::run(std::istream& script, std::ostream& report) {
+    using Clock = std::chrono::steady_clock;
+    const auto started = Clock::now();
+    
+    std::size_t executed = 0;
+    std::size_t lineNumber = 0;
+    std::string line;
+    while (std::getline(script, line)) {
+        ++lineNumber;
+        std::istringstream words(line);
+        std::string name;
+        if (!(words >> name) || name[0] == '#') {
+            continue;
+        }
+        Args args;
+        for (std::string word; words >> word;) {
+            args.push_back(word);
+        }
+        
+        auto error = [&](const std::string& what) {
+            return std::runtime_error("line " + std::to_string(lineNumber) + ": " + what);
+        };
+        
+        auto begin = Clock::now();
+        if (name == "time") {
+            std::chrono::duration<double, std::milli> total = begin - started;
+            report << "total " << fixed1(total.count()) << " ms" << std::endl;
+            ++executed;
+            continue;
+        }
+        if (name == "help") {
+            printHelp(report);
+            ++executed;
+            continue;
+        }
+        
+        auto found = commands.find(name);
+        if (found == commands.end()) {
+            throw error("unknown command '" + name + "'");
+        }
+        const Command& command = found->second;
+        if (args.size() < command.minArgs) {
+            throw error("usage: " + command.usage);
+        }
+        try {
+            command.handler(args);
+        } catch (const std::exception& e) {
+            throw error(name + ": " + e.what());
+        }
+        
+        std::chrono::duration<double, std::milli> elapsed = Clock::now() - begin;
+        MemoryUsage memory = memoryUsage();
+        report << "> " << line.substr(line.find_first_not_of(" \t")) << ": "
+               << fixed1(elapsed.count()) << " ms, rss "
+               << megabytes(memory.rss) << ", peak " << megabytes(memory.peak) << std::endl;
+        ++executed;
+    }
+    return executed;
+}
@@ -3,6 +3,8 @@
 #include "factory.h"
 #include "visitor.h"
 #include "observer.h"
+#include "battle.h"
+#include <random>
 
 class BattleTest : public ::testing::Test {
 protected:
@@ -200,4 +202,87 @@ TEST_F(BattleTest, AlreadyKilledNotAttacked) {
     //Драконы не должны атаковать друг друга или рыцаря после смерти
     //(это проверяется логикой в simulateBattle)
     EXPECT_GT(killed.size(), 0);
-}
\ No newline at end of file
+}
+
+//Прямой двойной цикл старого battle() - эталон для сетки
+static std::vector<bool> referenceBattle(const std::vector<std::shared_ptr<NPC>>& npcs, int distance) {
+    auto visitor = std::make_shared<FightVisitor>();
+    std::vector<bool> killed(npcs.size(), false);
+    for (std::size_t i = 0; i < npcs.size(); ++i) {
+        for (std::size_t j = 0; j < npcs.size(); ++j) {
+            if (i != j && npcs[i]->isClose(npcs[j], distance) && !killed[i] && !killed[j] &&
+                npcs[j]->accept(visitor, npcs[i])) {
+                killed[j] = true;
+                if (npcs[i]->getType() == NpcType::Dragon && npcs[j]->getType() == NpcType::Knight) {
+                    killed[i] = true;
+                }
+            }
+        }
+    }
+    return killed;
+}
+
+static std::vector<std::shared_ptr<NPC>> randomNPCs(std::size_t count, int span, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> type(1, 3);
+    std::uniform_int_distribution<int> coord(0, span);
+    std::vector<std::shared_ptr<NPC>> npcs;
+    for (std::size_t i = 0; i < count; ++i) {
+        npcs.push_back(NPCFactory::createNPC(static_cast<NpcType>(type(rng)),
+                                             coord(rng), coord(rng), "NPC_" + std::to_string(i)));
+    }
+    return npcs;
+}
+
+TEST(BattleRoundTest, MatchesDirectLoop) {
+    struct Case { std::size_t count; int span; int distance; };
+    //Разброс координат такой, чтобы квадраты в isClose не переполняли int
+    const Case cases[] = {
+        {300, 500, 10}, {300, 500, 0}, {300, 500, -25}, {300, 500, 600},
+        {200, 50, 5}, {200, 32000, 20000}, {150, 32000, 3},
+    };
+    unsigned seed = 1;
+    for (const auto& c : cases) {
+        auto npcs = randomNPCs(c.count, c.span, seed++);
+        auto expected = referenceBattle(npcs, c.distance);
+        auto killed = battleRound(npcs, c.distance);
+        
+        ASSERT_EQ(killed.size(), npcs.size());
+        std::size_t expectedCount = 0;
+        for (std::size_t i = 0; i < npcs.size(); ++i) {
+            EXPECT_EQ(killed.test(i), expected[i]) << "distance " << c.distance << ", NPC " << i;
+            expectedCount += expected[i];
+        }
+        EXPECT_EQ(killed.count(), expectedCount);
+    }
+}
+
+TEST(BattleRoundTest, OrderDecidesChains) {
+    //Рыцарь первым убивает дракона, и дракон уже не ест пегаса
+    auto knight = NPCFactory::createNPC(NpcType::Knight, 0, 0, "Knight");
+    auto dragon = NPCFactory::createNPC(NpcType::Dragon, 1, 0, "Dragon");
+    auto pegasus = NPCFactory::createNPC(NpcType::Pegasus, 2, 0, "Pegasus");
+    
+    auto killed = battleRound({knight, dragon, pegasus}, 5);
+    EXPECT_TRUE(killed.test(1));
+    EXPECT_FALSE(killed.test(2));
+    
+    //Дракон ходит первым и успевает съесть пегаса
+    killed = battleRound({dragon, knight, pegasus}, 5);
+    EXPECT_TRUE(killed.test(0));
+    EXPECT_TRUE(killed.test(2));
+}
+
+TEST(BattleRoundTest, KilledSetBits) {
+    KilledSet set(130);
+    set.set(0);
+    set.set(64);
+    set.set(129);
+    EXPECT_EQ(set.count(), 3u);
+    EXPECT_TRUE(set.test(64));
+    EXPECT_FALSE(set.test(65));
+    
+    std::vector<std::size_t> bits;
+    set.forEach([&](std::size_t i) { bits.push_back(i); });
+    EXPECT_EQ(bits, (std::vector<std::size_t>{0, 64, 129}));
+}
@@ -0,0 +1,231 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include "edit_journal.h"
+#include "factory.h"
+#include "loader.h"
+
+class EditJournalTest : public ::testing::Test {
+protected:
+    const std::string path = "test_edit_journal.txt";
+    std::vector<std::shared_ptr<NPC>> npcs;
+
+    void SetUp() override {
+        for (int i = 0; i < 4; ++i) {
+            NpcType type = static_cast<NpcType>(i % 3 + 1);
+            npcs.push_back(NPCFactory::createNPC(type, i * 10, i * 20, "NPC_" + std::to_string(i)));
+        }
+        writeFile();
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+        std::remove(EditJournal::pathFor(path).c_str());
+    }
+
+    //Полная запись в формате saveNPCs
+    void writeFile() {
+        std::ofstream file(path);
+        file << npcs.size() << std::endl << std::endl;
+        for (const auto& npc : npcs) {
+            npc->save(file);
+        }
+    }
+
+    std::vector<std::shared_ptr<NPC>> load(JournalReplay* replayed = nullptr) {
+        LoadResult result = NPCLoader::loadFile(path);
+        JournalReplay applied = EditJournal::replay(path, result.npcs);
+        if (replayed) *replayed = applied;
+        return result.npcs;
+    }
+
+    static std::vector<std::string> names(const std::vector<std::shared_ptr<NPC>>& list) {
+        std::vector<std::string> result;
+        for (const auto& npc : list) {
+            result.push_back(npc->getName());
+        }
+        return result;
+    }
+
+    static std::size_t fileSize(const std::string& file) {
+        std::ifstream in(file, std::ios::binary | std::ios::ate);
+        return static_cast<std::size_t>(in.tellg());
+    }
+};
+
+TEST_F(EditJournalTest, SaveWritesOnlyEdits) {
+    EditJournal journal;
+    journal.start(path);
+    std::size_t snapshot = fileSize(path);
+
+    auto knight = NPCFactory::createNPC(NpcType::Knight, 7, 8, "Late Knight");
+    journal.add(*knight);
+    journal.remove({0, 2});
+    journal.rename(2, "  Renamed ");
+    EXPECT_EQ(journal.commit(), 3u);
+    EXPECT_EQ(journal.commit(), 0u);
+
+    //Файл сохранения не переписывался
+    EXPECT_EQ(fileSize(path), snapshot);
+
+    JournalReplay replayed;
+    auto loaded = load(&replayed);
+    EXPECT_EQ(replayed.records, 3u);
+    EXPECT_FALSE(replayed.truncated);
+    EXPECT_FALSE(replayed.stale);
+    EXPECT_EQ(names(loaded), (std::vector<std::string>{"NPC_1", "NPC_3", "Renamed"}));
+    EXPECT_EQ(loaded[2]->getType(), NpcType::Knight);
+    EXPECT_EQ(loaded[2]->getX(), 7);
+    EXPECT_EQ(loaded[2]->getY(), 8);
+}
+
+TEST_F(EditJournalTest, AttachContinuesJournal) {
+    {
+        EditJournal journal;
+        journal.start(path);
+        journal.remove({3});
+        journal.commit();
+    }
+    EditJournal journal;
+    journal.attach(path);
+    EXPECT_EQ(journal.target(), path);
+    journal.clear();
+    journal.add(*npcs[0]);
+    journal.commit();
+
+    EXPECT_EQ(names(load()), (std::vector<std::string>{"NPC_0"}));
+}
+
+TEST_F(EditJournalTest, DetachedJournalKeepsNothing) {
+    EditJournal journal;
+    journal.add(*npcs[0]);
+    journal.clear();
+    EXPECT_TRUE(journal.target().empty());
+    EXPECT_EQ(journal.commit(), 0u);
+
+    JournalReplay replayed;
+    EXPECT_EQ(load(&replayed).size(), 4u);
+    EXPECT_EQ(replayed.records, 0u);
+}
+
+TEST_F(EditJournalTest, JournalOfOtherFileIsIgnored) {
+    EditJournal journal;
+    journal.start(path);
+    journal.clear();
+    journal.commit();
+
+    //Файл переписан в обход журнала
+    npcs.pop_back();
+    writeFile();
+    JournalReplay replayed;
+    EXPECT_EQ(load(&replayed).size(), 3u);
+    EXPECT_TRUE(replayed.stale);
+
+    //Привязка к такому файлу начинает журнал заново
+    journal.attach(path);
+    EXPECT_EQ(load(&replayed).size(), 3u);
+    EXPECT_FALSE(replayed.stale);
+}
+
+TEST_F(EditJournalTest, JournalOfSameSizeFileIsIgnored) {
+    EditJournal journal;
+    journal.start(path);
+    journal.remove({1});
+    journal.rename(0, "First");
+    journal.commit();
+
+    //Другое содержимое той же длины: правки по позициям к нему не относятся
+    std::size_t size = fileSize(path);
+    npcs[1]->setName("NPC_9");
+    npcs[2]->setPosition(20, 60);
+    writeFile();
+    ASSERT_EQ(fileSize(path), size);
+
+    JournalReplay replayed;
+    auto loaded = load(&replayed);
+    EXPECT_TRUE(replayed.stale);
+    EXPECT_EQ(replayed.records, 0u);
+    EXPECT_EQ(names(loaded), (std::vector<std::string>{"NPC_0", "NPC_9", "NPC_2", "NPC_3"}));
+
+    //Привязка не продолжает чужой журнал, а начинает новый
+    journal.attach(path);
+    journal.clear();
+    journal.commit();
+    EXPECT_TRUE(load(&replayed).empty());
+    EXPECT_FALSE(replayed.stale);
+}
+
+TEST_F(EditJournalTest, DamagedTailIsDropped) {
+    EditJournal journal;
+    journal.start(path);
+    journal.rename(0, "First");
+    journal.commit();
+    {
+        std::ofstream out(EditJournal::pathFor(path), std::ios::app | std::ios::binary);
+        out << "D 9\nC\n";
+    }
+    JournalReplay replayed;
+    auto loaded = load(&replayed);
+    EXPECT_TRUE(replayed.truncated);
+    EXPECT_EQ(replayed.records, 1u);
+    EXPECT_EQ(loaded.size(), 4u);
+    EXPECT_EQ(loaded[0]->getName(), "First");
+
+    //Позиции удаления не по возрастанию
+    std::string header;
+    {
+        std::ifstream in(EditJournal::pathFor(path), std::ios::binary);
+        std::getline(in, header);
+    }
+    {
+        std::ofstream out(EditJournal::pathFor(path), std::ios::trunc | std::ios::binary);
+        out << header << "\nD 1 0\n";
+    }
+    EXPECT_EQ(load(&replayed).size(), 4u);
+    EXPECT_TRUE(replayed.truncated);
+
+}
+
+TEST_F(EditJournalTest, DamagedHeaderIsIgnored) {
+    std::string sized = "E 1 " + std::to_string(fileSize(path)) + "\nC\n";
+    for (std::string header : {std::string(), std::string("4\n\n"), std::string("E 1\nC\n"),
+                               std::string("E 1 x\nC\n"), sized}) {
+        {
+            std::ofstream out(EditJournal::pathFor(path), std::ios::trunc | std::ios::binary);
+            out << header;
+        }
+        JournalReplay replayed;
+        EXPECT_EQ(load(&replayed).size(), 4u) << header;
+        EXPECT_TRUE(replayed.stale) << header;
+        EXPECT_EQ(replayed.records, 0u) << header;
+    }
+
+    //Привязка начинает такой журнал заново
+    EditJournal journal;
+    journal.attach(path);
+    journal.clear();
+    journal.commit();
+    EXPECT_TRUE(load().empty());
+
+    //Другая версия формата - не повреждение, а ошибка
+    {
+        std::ofstream out(EditJournal::pathFor(path), std::ios::trunc | std::ios::binary);
+        out << "E 9 " << fileSize(path) << "\n";
+    }
+    EXPECT_THROW(load(), std::runtime_error);
+}
+
+TEST_F(EditJournalTest, GrowsUntilCompaction) {
+    EditJournal journal(64);
+    EXPECT_FALSE(journal.needsCompaction());
+    journal.start(path);
+    for (int i = 0; i < 100 && !journal.needsCompaction(); ++i) {
+        journal.rename(0, "Name_" + std::to_string(i));
+        journal.commit();
+    }
+    EXPECT_TRUE(journal.needsCompaction());
+    EXPECT_GT(fileSize(EditJournal::pathFor(path)), 2 * fileSize(path));
+    EXPECT_THROW(journal.rename(0, "two\nlines"), std::invalid_argument);
+}
@@ -0,0 +1,29 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include "fight_rules.h"
+#include "factory.h"
+#include "visitor.h"
+
+//Матрица правил должна совпадать с FightVisitor для всех пар типов
+TEST(FightRulesTest, MatchesVisitor) {
+    const NpcType types[] = {NpcType::Dragon, NpcType::Knight, NpcType::Pegasus};
+    auto visitor = std::make_shared<FightVisitor>();
+
+    for (NpcType attackerType : types) {
+        for (NpcType defenderType : types) {
+            auto attacker = NPCFactory::createNPC(attackerType, 0, 0, "A");
+            auto defender = NPCFactory::createNPC(defenderType, 0, 0, "D");
+            EXPECT_EQ(fight_rules::canKill(attackerType, defenderType),
+                      defender->accept(visitor, attacker))
+                << NPCFactory::getStringFromType(attackerType) << " vs "
+                << NPCFactory::getStringFromType(defenderType);
+        }
+    }
+}
+
+TEST(FightRulesTest, AttackerTypes) {
+    EXPECT_TRUE(fight_rules::canAttack(NpcType::Dragon));
+    EXPECT_TRUE(fight_rules::canAttack(NpcType::Knight));
+    EXPECT_FALSE(fight_rules::canAttack(NpcType::Pegasus));
+    EXPECT_FALSE(fight_rules::canAttack(NpcType::Unknown));
+}
@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include "loader.h"
+#include "factory.h"
+
+//Текст в формате saveNPCs
+static std::string saveText(const std::vector<std::shared_ptr<NPC>>& npcs) {
+    std::stringstream ss;
+    ss << npcs.size() << std::endl << std::endl;
+    for (const auto& npc : npcs) {
+        npc->save(ss);
+    }
+    return ss.str();
+}
+
+static std::vector<std::shared_ptr<NPC>> makeNPCs(int count) {
+    std::vector<std::shared_ptr<NPC>> npcs;
+    for (int i = 0; i < count; ++i) {
+        NpcType type = static_cast<NpcType>(i % 3 + 1);
+        npcs.push_back(NPCFactory::createNPC(type, (i * 37) % 501, (i * 91) % 501,
+                                             NPCFactory::getStringFromType(type) + "_" + std::to_string(i)));
+    }
+    return npcs;
+}
+
+static void expectSame(const std::vector<std::shared_ptr<NPC>>& expected,
+                       const std::vector<std::shared_ptr<NPC>>& actual) {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(expected[i]->getType(), actual[i]->getType());
+        EXPECT_EQ(expected[i]->getX(), actual[i]->getX());
+        EXPECT_EQ(expected[i]->getY(), actual[i]->getY());
+        EXPECT_EQ(expected[i]->getName(), actual[i]->getName());
+    }
+}
+
+TEST(LoaderTest, MatchesFactoryLoader) {
+    auto npcs = makeNPCs(50);
+    std::string text = saveText(npcs);
+
+    //Старый последовательный разбор
+    std::stringstream ss(text);
+    std::string line;
+    std::getline(ss, line);
+    std::getline(ss, line);
+    std::vector<std::shared_ptr<NPC>> sequential;
+    for (std::size_t i = 0; i < npcs.size(); ++i) {
+        sequential.push_back(NPCFactory::loadNPC(ss));
+    }
+
+    auto result = NPCLoader::parse(text, 1);
+    EXPECT_EQ(result.declared, 50u);
+    EXPECT_EQ(result.failed, 0u);
+    expectSame(sequential, result.npcs);
+}
+
+TEST(LoaderTest, ChunksGiveSameOrder) {
+    auto npcs = makeNPCs(1000);
+    std::string text = saveText(npcs);
+
+    //Маленький размер куска, чтобы разбор шел в несколько потоков
+    for (unsigned threads : {2u, 3u, 8u}) {
+        auto result = NPCLoader::parse(text, threads, 1);
+        EXPECT_EQ(result.failed, 0u);
+        expectSame(npcs, result.npcs);
+    }
+}
+
+TEST(LoaderTest, KeepsNamesWithSpacesAndEmptyNames) {
+    std::vector<std::shared_ptr<NPC>> npcs = {
+        NPCFactory::createNPC(NpcType::Dragon, 1, 2, "Old Red Dragon"),
+        NPCFactory::createNPC(NpcType::Knight, 3, 4, "Knight"),
+        NPCFactory::createNPC(NpcType::Pegasus, 5, 6, "Pegasus"),
+    };
+    npcs[1]->setName("");
+    std::string text = saveText(npcs);
+
+    for (unsigned threads : {1u, 3u}) {
+        auto result = NPCLoader::parse(text, threads, 1);
+        expectSame(npcs, result.npcs);
+    }
+}
+
+TEST(LoaderTest, CountLimitsRecords) {
+    auto npcs = makeNPCs(10);
+    std::string text = saveText(npcs);
+    text.replace(0, 2, "4\n");
+
+    auto result = NPCLoader::parse(text, 2, 1);
+    EXPECT_EQ(result.declared, 4u);
+    EXPECT_EQ(result.npcs.size(), 4u);
+    EXPECT_EQ(result.npcs[3]->getName(), npcs[3]->getName());
+}
+
+TEST(LoaderTest, SkipsBrokenRecords) {
+    std::string text =
+        "3\n\n"
+        "1\n10\n20\nSmaug\n\n"
+        "7\n1\n2\nUnknown\n\n"
+        "2\nabc\n40\nBroken\n\n";
+    auto result = NPCLoader::parse(text, 1);
+    EXPECT_EQ(result.npcs.size(), 1u);
+    EXPECT_EQ(result.failed, 2u);
+    EXPECT_EQ(result.npcs[0]->getName(), "Smaug");
+}
+
+TEST(LoaderTest, MissingRecordsAreFailures) {
+    auto result = NPCLoader::parse("5\n\n3\n1\n1\nPeg\n\n", 1);
+    EXPECT_EQ(result.npcs.size(), 1u);
+    EXPECT_EQ(result.failed, 4u);
+}
+
+TEST(LoaderTest, BadCountThrows) {
+    EXPECT_THROW(NPCLoader::parse("", 1), std::runtime_error);
+    EXPECT_THROW(NPCLoader::parse("many\n\n", 1), std::runtime_error);
+    EXPECT_EQ(NPCLoader::parse("0\n\n", 1).npcs.size(), 0u);
+}
+
+TEST(LoaderTest, LoadsFile) {
+    const std::string filename = "test_loader_npcs.txt";
+    auto npcs = makeNPCs(20);
+    {
+        std::ofstream file(filename);
+        file << saveText(npcs);
+    }
+    auto result = NPCLoader::loadFile(filename);
+    expectSame(npcs, result.npcs);
+    std::remove(filename.c_str());
+
+    EXPECT_THROW(NPCLoader::loadFile("missing_file.txt"), std::runtime_error);
+}
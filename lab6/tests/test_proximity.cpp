@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+#include "proximity.h"
+
+namespace {
+
+std::uint64_t reference(int x, int y, int radius, const int* xs, const int* ys, std::size_t count) {
+    std::uint64_t mask = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        long long dx = xs[i] - x;
+        long long dy = ys[i] - y;
+        if (dx * dx + dy * dy <= static_cast<long long>(radius) * radius) {
+            mask |= std::uint64_t(1) << i;
+        }
+    }
+    return mask;
+}
+
+const proximity::Isa allIsa[] = {
+    proximity::Isa::Scalar, proximity::Isa::Sse2, proximity::Isa::Avx2
+};
+
+} //namespace
+
+TEST(ProximityTest, ScalarAlwaysSupported) {
+    EXPECT_TRUE(proximity::isSupported(proximity::Isa::Scalar));
+    EXPECT_NE(proximity::kernelFor(proximity::Isa::Scalar), nullptr);
+    EXPECT_NE(proximity::kernelFor(proximity::activeIsa()), nullptr);
+}
+
+TEST(ProximityTest, BoundaryIsInclusive) {
+    //Ровно на дистанции - цель в радиусе, как в NPC::isClose
+    int xs[] = {3, 4, 0, 10, 100, 6, 0, 5, 3};
+    int ys[] = {4, 4, 5, 0, 100, 8, 0, 0, 3};
+    for (auto isa : allIsa) {
+        auto kernel = proximity::kernelFor(isa);
+        if (!kernel) continue;
+        EXPECT_EQ(kernel(0, 0, 5, xs, ys, 9), reference(0, 0, 5, xs, ys, 9))
+            << proximity::isaName(isa);
+        EXPECT_EQ(kernel(0, 0, 5, xs, ys, 9), 0b111000101u) << proximity::isaName(isa);
+    }
+}
+
+TEST(ProximityTest, KernelsMatchReference) {
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int> coord(0, 10000);
+    std::uniform_int_distribution<int> nearCoord(-60, 60);
+    std::uniform_int_distribution<int> radiusDist(0, 60);
+
+    std::vector<int> xs(proximity::BLOCK_SIZE), ys(proximity::BLOCK_SIZE);
+    for (int round = 0; round < 500; ++round) {
+        int x = coord(gen);
+        int y = coord(gen);
+        int radius = radiusDist(gen);
+        for (std::size_t i = 0; i < xs.size(); ++i) {
+            //Половина точек рядом с атакующим, остальные по всей карте
+            bool near = (i + round) % 2 == 0;
+            xs[i] = near ? x + nearCoord(gen) : coord(gen);
+            ys[i] = near ? y + nearCoord(gen) : coord(gen);
+        }
+        //Все длины блока, включая хвосты короче ширины вектора
+        std::size_t count = static_cast<std::size_t>(round) % (proximity::BLOCK_SIZE + 1);
+        std::uint64_t expected = reference(x, y, radius, xs.data(), ys.data(), count);
+
+        for (auto isa : allIsa) {
+            auto kernel = proximity::kernelFor(isa);
+            if (!kernel) continue;
+            ASSERT_EQ(kernel(x, y, radius, xs.data(), ys.data(), count), expected)
+                << proximity::isaName(isa) << " count=" << count;
+        }
+        ASSERT_EQ(proximity::withinRadius(x, y, radius, xs.data(), ys.data(), count), expected);
+    }
+}
+
+TEST(ProximityTest, ForEachBitInOrder) {
+    std::vector<std::size_t> bits;
+    proximity::forEachBit((std::uint64_t(1) << 63) | 0b1010u, [&](std::size_t i) { bits.push_back(i); });
+    EXPECT_EQ(bits, (std::vector<std::size_t>{1, 3, 63}));
+}
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include <stdexcept>
+#include "script.h"
+
+class ScriptTest : public ::testing::Test {
+protected:
+    ScriptRunner runner;
+    std::vector<std::string> calls;
+    
+    void SetUp() override {
+        runner.addCommand("gen", 1, "gen COUNT", [this](const ScriptRunner::Args& args) {
+            calls.push_back("gen " + args[0]);
+        });
+        runner.addCommand("print", 0, "print", [this](const ScriptRunner::Args&) {
+            calls.push_back("print");
+        });
+        runner.addCommand("fail", 0, "fail", [](const ScriptRunner::Args&) {
+            throw std::invalid_argument("broken");
+        });
+    }
+};
+
+TEST_F(ScriptTest, RunsCommandsInOrder) {
+    std::istringstream script("# комментарий\ngen 10\n\n   print\ngen 5 extra\n");
+    std::ostringstream report;
+    
+    EXPECT_EQ(runner.run(script, report), 3u);
+    EXPECT_EQ(calls, (std::vector<std::string>{"gen 10", "print", "gen 5"}));
+}
+
+TEST_F(ScriptTest, ReportsTimeAndMemory) {
+    std::istringstream script("gen 1\ntime\n");
+    std::ostringstream report;
+    runner.run(script, report);
+    
+    std::string text = report.str();
+    EXPECT_NE(text.find("> gen 1: "), std::string::npos);
+    EXPECT_NE(text.find(" ms, rss "), std::string::npos);
+    EXPECT_NE(text.find("peak"), std::string::npos);
+    EXPECT_NE(text.find("total "), std::string::npos);
+}
+
+TEST_F(ScriptTest, KeepsReportFormatting) {
+    std::istringstream script("gen 1\ntime\n");
+    std::ostringstream report;
+    runner.run(script, report);
+    
+    //Замеры не меняют формат чисел для следующих выводов в тот же поток
+    std::ostringstream after;
+    after.copyfmt(report);
+    after << 2.25;
+    EXPECT_EQ(after.str(), "2.25");
+    EXPECT_EQ(report.precision(), 6);
+}
+
+TEST_F(ScriptTest, ErrorsHaveLineNumbers) {
+    std::ostringstream report;
+    
+    std::istringstream unknown("gen 1\nfly 3\n");
+    try {
+        runner.run(unknown, report);
+        FAIL() << "unknown command accepted";
+    } catch (const std::runtime_error& e) {
+        EXPECT_NE(std::string(e.what()).find("line 2"), std::string::npos);
+    }
+    
+    std::istringstream missing("gen\n");
+    EXPECT_THROW(runner.run(missing, report), std::runtime_error);
+    
+    std::istringstream failing("print\nfail\nprint\n");
+    calls.clear();
+    EXPECT_THROW(runner.run(failing, report), std::runtime_error);
+    EXPECT_EQ(calls.size(), 1u);
+}
+
+TEST(MemoryUsageTest, ReportsResidentSize) {
+    MemoryUsage usage = memoryUsage();
+    EXPECT_GT(usage.rss, 0u);
+    EXPECT_GE(usage.peak, usage.rss);
+}
+
+TEST(ScopedSilenceTest, RestoresStream) {
+    std::ostringstream out;
+    {
+        ScopedSilence silence(out);
+        out << "hidden";
+    }
+    out << "shown";
+    EXPECT_EQ(out.str(), "shown");
+}
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include "slot_map.h"
+#include "factory.h"
+
+TEST(SlotMapTest, InsertAndGet) {
+    SlotMap<std::string> map;
+    auto a = map.insert("a");
+    auto b = map.insert("b");
+    
+    EXPECT_EQ(map.size(), 2u);
+    EXPECT_TRUE(map.contains(a));
+    EXPECT_EQ(*map.get(a), "a");
+    EXPECT_EQ(*map.get(b), "b");
+    EXPECT_NE(a, b);
+}
+
+TEST(SlotMapTest, EraseInvalidatesHandle) {
+    SlotMap<std::string> map;
+    auto a = map.insert("a");
+    auto b = map.insert("b");
+    
+    EXPECT_TRUE(map.erase(a));
+    EXPECT_FALSE(map.contains(a));
+    EXPECT_EQ(map.get(a), nullptr);
+    EXPECT_FALSE(map.erase(a));
+    EXPECT_EQ(*map.get(b), "b");
+    
+    //Слот используется заново, но старый дескриптор остается недействительным
+    auto c = map.insert("c");
+    EXPECT_EQ(c.index, a.index);
+    EXPECT_FALSE(map.contains(a));
+    EXPECT_EQ(*map.get(c), "c");
+}
+
+TEST(SlotMapTest, DenseOrderAfterErase) {
+    SlotMap<int> map;
+    std::vector<SlotMap<int>::Handle> handles;
+    for (int i = 0; i < 5; ++i) {
+        handles.push_back(map.insert(i));
+    }
+    
+    //Остальные сдвигаются, порядок сохраняется
+    map.erase(handles[1]);
+    EXPECT_EQ(map.data(), (std::vector<int>{0, 2, 3, 4}));
+    EXPECT_EQ(map.handleAt(1), handles[2]);
+    EXPECT_EQ(*map.get(handles[4]), 4);
+    
+    map.eraseAt(0);
+    EXPECT_EQ(map.data(), (std::vector<int>{2, 3, 4}));
+    EXPECT_FALSE(map.contains(handles[0]));
+    EXPECT_EQ(map.handleAt(0), handles[2]);
+    EXPECT_EQ(*map.get(handles[3]), 3);
+    EXPECT_THROW(map.eraseAt(3), std::out_of_range);
+}
+
+TEST(SlotMapTest, RemoveIfKeepsOrder) {
+    SlotMap<int> map;
+    std::vector<SlotMap<int>::Handle> handles;
+    for (int i = 0; i < 8; ++i) {
+        handles.push_back(map.insert(i * 10));
+    }
+    
+    std::size_t removed = map.removeIf([](std::size_t position, int value) {
+        return position == 0 || value % 30 == 0;
+    });
+    EXPECT_EQ(removed, 3u);
+    EXPECT_EQ(map.data(), (std::vector<int>{10, 20, 40, 50, 70}));
+    EXPECT_FALSE(map.contains(handles[0]));
+    EXPECT_FALSE(map.contains(handles[3]));
+    EXPECT_FALSE(map.contains(handles[6]));
+    for (int i : {1, 2, 4, 5, 7}) {
+        EXPECT_EQ(*map.get(handles[i]), i * 10);
+    }
+    EXPECT_EQ(map.handleAt(2), handles[4]);
+    
+    //Освобожденные слоты занимаются снова, старые дескрипторы не оживают
+    auto reused = map.insert(99);
+    EXPECT_EQ(map.data().back(), 99);
+    EXPECT_EQ(*map.get(reused), 99);
+    EXPECT_FALSE(map.contains(handles[6]));
+}
+
+TEST(SlotMapTest, ClearInvalidatesAll) {
+    SlotMap<int> map;
+    auto a = map.insert(1);
+    auto b = map.insert(2);
+    map.clear();
+    
+    EXPECT_TRUE(map.empty());
+    EXPECT_FALSE(map.contains(a));
+    EXPECT_FALSE(map.contains(b));
+    
+    auto c = map.insert(3);
+    EXPECT_TRUE(map.contains(c));
+    EXPECT_EQ(map.size(), 1u);
+}
+
+TEST(SlotMapTest, SameOperationsSameOrder) {
+    //Порядок не зависит от адресов объектов, в отличие от std::set указателей
+    auto build = [] {
+        SlotMap<std::shared_ptr<NPC>> map;
+        std::vector<SlotMap<std::shared_ptr<NPC>>::Handle> handles;
+        for (int i = 0; i < 100; ++i) {
+            handles.push_back(map.insert(NPCFactory::createNPC(NpcType::Knight, i, i, "K" + std::to_string(i))));
+        }
+        for (int i = 0; i < 100; i += 7) {
+            map.erase(handles[i]);
+        }
+        std::vector<std::string> names;
+        for (const auto& npc : map) {
+            names.push_back(npc->getName());
+        }
+        return names;
+    };
+    EXPECT_EQ(build(), build());
+}
@@ -0,0 +1,52 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include "game.h"
+
+// Замер тактов движения в секунду на карте 500x500.
+// Очередь боёв опустошает отдельный поток, чтобы мерить только
+// перемещение и поиск соседей.
+static double measureTicksPerSecond(int npcCount, double minSeconds) {
+    Game game;
+    game.initialize(npcCount);
+
+    std::atomic<bool> done(false);
+    std::thread drain([&]() {
+        while (!done) {
+            game.clearBattleTasks();
+            std::this_thread::yield();
+        }
+    });
+
+    game.setSeed(42);
+    std::size_t fights = 0;
+    int ticks = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+    do {
+        fights += game.movementTick();
+        ++ticks;
+        elapsed = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < minSeconds);
+
+    done = true;
+    drain.join();
+
+    std::cout << std::setw(8) << npcCount
+              << std::setw(8) << ticks
+              << std::setw(14) << std::fixed << std::setprecision(2) << ticks / elapsed
+              << std::setw(16) << fights / ticks << std::endl;
+    return ticks / elapsed;
+}
+
+int main() {
+    std::cout << "     NPC   ticks     ticks/sec  fights/tick" << std::endl;
+    for (int npcCount : {1000, 10000, 100000}) {
+        measureTicksPerSecond(npcCount, 2.0);
+    }
+    return 0;
+}
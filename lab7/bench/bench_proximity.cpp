@@ -0,0 +1,81 @@
+#include <iostream>
+#include <iomanip>
+#include <bitset>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <vector>
+#include "proximity.h"
+#include "dragon.h"
+
+// Микробенчмарк проверки дистанции: один атакующий против блоков по 64
+// кандидата. Сравниваются NPC::isClose (две блокировки на пару),
+// скалярный цикл по колонкам и векторные ядра.
+static constexpr std::size_t POSITIONS = 1 << 16;
+static constexpr int ROUNDS = 200;
+static constexpr int RADIUS = 30;
+
+static void report(const char* name, double seconds, std::uint64_t hits, double baseline) {
+    double checks = static_cast<double>(POSITIONS) * ROUNDS;
+    std::cout << std::setw(10) << name
+              << std::setw(14) << std::fixed << std::setprecision(1) << checks / seconds / 1e6
+              << std::setw(10) << std::setprecision(2) << baseline / seconds << "x"
+              << std::setw(12) << hits << std::endl;
+}
+
+int main() {
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> coord(0, 500);
+    std::vector<int> xs(POSITIONS), ys(POSITIONS);
+    for (std::size_t i = 0; i < POSITIONS; ++i) {
+        xs[i] = coord(gen);
+        ys[i] = coord(gen);
+    }
+
+    std::cout << "Active kernel: " << proximity::isaName(proximity::activeIsa()) << std::endl;
+    std::cout << "    kernel  Mchecks/sec vs isClose        hits" << std::endl;
+
+    // Эталон: NPC::isClose на объектах
+    double isCloseSeconds = 0.0;
+    {
+        std::vector<std::shared_ptr<NPC>> npcs;
+        npcs.reserve(POSITIONS);
+        for (std::size_t i = 0; i < POSITIONS; ++i) {
+            npcs.push_back(std::make_shared<Dragon>(xs[i], ys[i], "D"));
+        }
+        auto attacker = std::make_shared<Dragon>(250, 250, "A");
+        std::uint64_t hits = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < ROUNDS; ++r) {
+            attacker->setPosition(200 + r % 100, 250);
+            for (const auto& npc : npcs) {
+                hits += attacker->isClose(npc, RADIUS);
+            }
+        }
+        isCloseSeconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+        report("isClose", isCloseSeconds, hits, isCloseSeconds);
+    }
+
+    for (auto isa : {proximity::Isa::Scalar, proximity::Isa::Sse2, proximity::Isa::Avx2}) {
+        auto kernel = proximity::kernelFor(isa);
+        if (!kernel) {
+            std::cout << std::setw(10) << proximity::isaName(isa) << "  not supported" << std::endl;
+            continue;
+        }
+        std::uint64_t hits = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < ROUNDS; ++r) {
+            int x = 200 + r % 100;
+            for (std::size_t i = 0; i < POSITIONS; i += proximity::BLOCK_SIZE) {
+                std::uint64_t mask = kernel(x, 250, RADIUS, xs.data() + i, ys.data() + i,
+                                            proximity::BLOCK_SIZE);
+                hits += std::bitset<64>(mask).count();
+            }
+        }
+        double seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+        report(proximity::isaName(isa), seconds, hits, isCloseSeconds);
+    }
+    return 0;
+}
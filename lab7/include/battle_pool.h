@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "npc.h"
+#include "lock_free_queue.h"
+
+struct BattleTask {
+    std::shared_ptr<NPC> attacker;
+    std::shared_ptr<NPC> defender;
+    std::uint32_t tick = 0;  // такт, на котором бой найден
+};
+
+// Пул потоков для разрешения боёв.
+// У каждого потока своя lock-free очередь; задача попадает в очередь по id
+// защищающегося, а освободившийся поток забирает работу из чужих очередей
+// (work stealing). Простаивающие потоки спят на общей condition_variable.
+class BattlePool {
+public:
+    using Handler = std::function<void(const BattleTask&)>;
+
+private:
+    std::vector<std::unique_ptr<LockFreeQueue<BattleTask>>> queues;
+    std::vector<std::thread> workers;
+    Handler handler;
+
+    std::atomic<bool> closed;
+    std::atomic<std::size_t> roundRobin;
+
+    std::atomic<int> idle;
+    std::mutex parkMutex;
+    std::condition_variable parkCV;
+
+    // Поставленные, но еще не обработанные задачи
+    std::atomic<std::size_t> inFlight;
+    std::mutex idleMutex;
+    std::condition_variable idleCV;
+
+    void workerLoop(std::size_t index);
+    bool nextTask(std::size_t index, BattleTask& task);
+    bool takeTask(std::size_t index, BattleTask& task);
+    void wakeWorker();
+    void finishTask();
+
+public:
+    // workerCount == 0 - по числу ядер
+    BattlePool(std::size_t workerCount, std::size_t queueCapacity);
+    ~BattlePool();
+
+    BattlePool(const BattlePool&) = delete;
+    BattlePool& operator=(const BattlePool&) = delete;
+
+    void start(Handler taskHandler);
+    void stop();
+
+    // Ставит задачу в очередь; false если пул остановлен
+    bool submit(const BattleTask& task);
+
+    // Ждет, пока все поставленные задачи будут обработаны (или пул остановлен)
+    void waitIdle();
+
+    std::size_t pending() const;
+    void clear();
+    std::size_t workerCount() const;
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "npc.h"
+
+// Бинарный снимок мира для сохранения и восстановления.
+//
+// Файл: заголовок, затем колонки (SoA), каждая с границы 8 байт:
+//   ids      uint32[count]
+//   types    uint8[count]
+//   x, y     int32[count]
+//   alive    uint8[count]
+//   nameOffsets uint32[count + 1] - начала имен в таблице строк
+//   names    char[namesSize]      - имена подряд, без разделителей
+// Запись - один вызов writev, чтение - mmap без разбора полей.
+// Порядок байт - порядок писателя, проверяется по endianTag.
+namespace snapshot {
+
+constexpr char MAGIC[8] = {'D', 'N', 'G', 'S', 'N', 'A', 'P', '\0'};
+constexpr std::uint32_t VERSION = 1;
+constexpr std::uint32_t ENDIAN_TAG = 0x01020304;
+
+struct Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t headerSize;
+    std::uint32_t endianTag;
+    std::uint32_t tick;
+    std::uint64_t seed;
+    std::int32_t mapWidth;
+    std::int32_t mapHeight;
+    std::uint64_t count;
+    std::uint64_t namesSize;
+
+    // Смещения колонок от начала файла
+    std::uint64_t idsOffset;
+    std::uint64_t typesOffset;
+    std::uint64_t xOffset;
+    std::uint64_t yOffset;
+    std::uint64_t aliveOffset;
+    std::uint64_t nameOffsetsOffset;
+    std::uint64_t namesOffset;
+    std::uint64_t fileSize;
+};
+
+static_assert(std::is_trivially_copyable_v<Header>, "Header is written as raw bytes");
+
+// Колонки для записи
+struct Columns {
+    std::uint64_t seed = 0;
+    std::uint32_t tick = 0;
+    int mapWidth = 500;
+    int mapHeight = 500;
+
+    std::vector<std::uint32_t> ids;
+    std::vector<std::uint8_t> types;
+    std::vector<std::int32_t> x;
+    std::vector<std::int32_t> y;
+    std::vector<std::uint8_t> alive;
+    std::vector<std::uint32_t> nameOffsets{0};
+    std::string names;
+
+    void reserve(std::size_t count);
+    void add(std::uint32_t id, NpcType type, int px, int py, bool isAlive, const std::string& name);
+    std::size_t size() const;
+};
+
+// Бросает std::runtime_error при ошибке записи
+void write(const std::string& path, const Columns& columns);
+
+// Снимок, отображенный в память только для чтения.
+// Колонки - указатели прямо в отображение, действительны, пока жив объект.
+class MappedSnapshot {
+private:
+    const char* data;
+    std::size_t length;
+    const Header* head;
+
+    template<typename T>
+    const T* column(std::uint64_t offset) const {
+        return reinterpret_cast<const T*>(data + offset);
+    }
+
+public:
+    // Бросает std::runtime_error, если файл не открылся, поврежден или
+    // в нем есть NPC за пределами карты из заголовка
+    explicit MappedSnapshot(const std::string& path);
+    ~MappedSnapshot();
+
+    MappedSnapshot(MappedSnapshot&& other) noexcept;
+    MappedSnapshot(const MappedSnapshot&) = delete;
+    MappedSnapshot& operator=(const MappedSnapshot&) = delete;
+    MappedSnapshot& operator=(MappedSnapshot&&) = delete;
+
+    const Header& header() const { return *head; }
+    std::size_t size() const { return static_cast<std::size_t>(head->count); }
+
+    const std::uint32_t* ids() const { return column<std::uint32_t>(head->idsOffset); }
+    const std::uint8_t* types() const { return column<std::uint8_t>(head->typesOffset); }
+    const std::int32_t* x() const { return column<std::int32_t>(head->xOffset); }
+    const std::int32_t* y() const { return column<std::int32_t>(head->yOffset); }
+    const std::uint8_t* alive() const { return column<std::uint8_t>(head->aliveOffset); }
+    NpcType type(std::size_t i) const { return static_cast<NpcType>(types()[i]); }
+    std::string_view name(std::size_t i) const;
+};
+
+// Читает записи текстового формата NPC::save (с необязательной строкой
+// количества и пустой строкой в начале, как в сохранениях редактора)
+// и пишет их бинарным снимком. Возвращает число перенесенных NPC.
+// Бросает std::runtime_error на нечитаемой записи или NPC вне карты.
+std::size_t convertText(std::istream& text, const std::string& binaryPath,
+                        int mapWidth = 500, int mapHeight = 500);
+
+} // namespace snapshot
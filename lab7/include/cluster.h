@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <sys/types.h>
+#include <vector>
+#include "game.h"
+#include "recording.h"
+#include "shm_ring.h"
+
+// Ускоренный прогон игры несколькими процессами одной машины.
+//
+// Карта режется на горизонтальные полосы, у каждой полосы свой процесс
+// (регион): он хранит только свои NPC, двигает их и разрешает бои, в
+// которых защищается его NPC. Процессы обмениваются через кольца в
+// разделяемой памяти (shm_ring.h): NPC, перешедшими границу, копиями
+// NPC у границы (призраки) и заявками на бой с чужим защищающимся.
+// Координатор (процесс, вызвавший run()) задает такты барьером и
+// собирает итоги боев.
+//
+// Правила те же, что у Game: мир создается из seed, движение и броски -
+// функции от (seed, такт, id), бои такта одновременны. Поэтому запись
+// прогона (recording.h) совпадает с записью Game при том же seed.
+namespace cluster {
+
+struct Options {
+    std::size_t processes = 2;
+    std::size_t ringCapacity = 1 << 14;  // сообщений в каждом кольце
+};
+
+class Coordinator {
+public:
+    // Бросает std::invalid_argument при недопустимых настройках
+    Coordinator(const GameConfig& config, const Options& options);
+    ~Coordinator();
+
+    Coordinator(const Coordinator&) = delete;
+    Coordinator& operator=(const Coordinator&) = delete;
+
+    // Порождает процессы регионов через fork(), проводит config.tickLimit()
+    // тактов и ждет завершения процессов. Вызывать до запуска других потоков
+    // процесса. Бросает std::runtime_error, если процесс региона упал.
+    SimulationStats run();
+
+    // Бои всех тактов последнего run()
+    Recording recording() const;
+    std::uint64_t getSeed() const;
+
+private:
+    GameConfig config;
+    Options options;
+    std::uint64_t seed;
+    std::vector<pid_t> children;
+    Recording fights;
+
+    void stopChildren();
+};
+
+} // namespace cluster
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "npc.h"
+#include "lock_free_queue.h"
+
+// Событие боя фиксированного размера: все нужное для строки лога
+// копируется в момент боя, поэтому потоку лога не нужны объекты NPC
+struct FightEvent {
+    static constexpr std::size_t NAME_SIZE = 32;
+
+    std::uint32_t channel = 0;
+    std::uint32_t tick = 0;
+    NpcType attackerType = NpcType::Unknown;
+    NpcType defenderType = NpcType::Unknown;
+    int attackerX = 0;
+    int attackerY = 0;
+    int defenderX = 0;
+    int defenderY = 0;
+    int attackPower = 0;
+    int defensePower = 0;
+    bool win = false;
+    char attackerName[NAME_SIZE] = {};
+    char defenderName[NAME_SIZE] = {};
+
+    // Заполняет поля NPC; длинные имена обрезаются
+    static FightEvent make(const NPC& attacker, const NPC& defender, bool win);
+};
+
+// Общий мьютекс консоли: под ним пишут и Game, и лог боёв
+std::mutex& consoleMutex();
+void writeConsole(const std::string& text);
+
+// Асинхронный лог боёв.
+// Потоки боя только кладут события в lock-free очередь. Один фоновый поток
+// форматирует их в буферы приемников и пишет большими блоками: когда буфер
+// вырос или прошел интервал сброса. Скорость диска и терминала не влияет
+// на потоки боя: если очередь переполнена, событие отбрасывается и
+// учитывается в dropped().
+class FightLog {
+public:
+    // Дописывает текст события в буфер приемника
+    using Formatter = void (*)(const FightEvent& event, std::string& out);
+    // Пишет накопленный блок текста
+    using Writer = std::function<void(const std::string& block)>;
+
+    static constexpr std::size_t DEFAULT_CAPACITY = 1 << 14;
+    // Приемник std::cout, создается всегда
+    static constexpr std::uint32_t CONSOLE_SINK = 0;
+
+    explicit FightLog(std::chrono::milliseconds flushInterval = std::chrono::milliseconds(100),
+                      std::size_t capacity = DEFAULT_CAPACITY);
+    ~FightLog();
+
+    FightLog(const FightLog&) = delete;
+    FightLog& operator=(const FightLog&) = delete;
+
+    // Приемник - место записи (консоль, файл). Канал - формат событий
+    // и приемник; каналы с общим приемником сохраняют порядок событий.
+    std::uint32_t addSink(Writer writer);
+    // Возвращает номер канала для FightEvent::channel
+    std::uint32_t addChannel(Formatter formatter, std::uint32_t sink);
+
+    // Не блокирует; false, если очередь переполнена или лог остановлен
+    bool push(const FightEvent& event);
+
+    // Ждет, пока все уже поставленные события будут записаны
+    void flush();
+    // Записывает оставшиеся события и останавливает поток
+    void stop();
+
+    std::size_t dropped() const;
+    std::chrono::milliseconds getFlushInterval() const;
+
+private:
+    static constexpr std::size_t BATCH_BYTES = 64 * 1024;
+
+    struct Sink {
+        Writer writer;
+        std::string buffer;
+    };
+
+    struct Channel {
+        Formatter formatter;
+        std::uint32_t sink;
+    };
+
+    std::chrono::milliseconds flushInterval;
+    LockFreeQueue<FightEvent> queue;
+    std::atomic<std::size_t> droppedCount;
+    std::atomic<std::size_t> pushed;
+
+    // Каналы, приемники и счетчик записанных событий защищены мьютексом:
+    // поток лога берет его один раз на пачку событий
+    std::mutex channelMutex;
+    std::condition_variable writtenCV;
+    std::vector<Sink> sinks;
+    std::vector<Channel> channels;
+    std::size_t written;
+    bool finished;
+
+    std::atomic<bool> flushRequested;
+    std::thread worker;
+
+    void run();
+    // Вызываются под channelMutex
+    std::size_t format(const std::vector<FightEvent>& batch);
+    void writeAll(std::size_t events);
+};
+
+// Стандартные форматы строк для консоли и файла
+namespace fight_format {
+void console(const FightEvent& event, std::string& out);
+void file(const FightEvent& event, std::string& out);
+void battle(const FightEvent& event, std::string& out);
+}
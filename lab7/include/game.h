@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+#include <functional>
 #include <memory>
 #include <vector>
 #include <thread>
@@ -8,52 +10,253 @@
 #include <mutex>
 #include <string>
 #include "npc.h"
+#include "spatial_grid.h"
+#include "battle_pool.h"
+#include "shard_pool.h"
+#include "world_snapshot.h"
+#include "world.h"
+#include "fight_rules.h"
+#include "philox.h"
+#include "fight_log.h"
+#include "observer.h"
+#include "journal.h"
+#include "recording.h"
+#include "map_renderer.h"
+#include "metrics.h"
 
-struct BattleTask {
-    std::shared_ptr<NPC> attacker;
-    std::shared_ptr<NPC> defender;
+// Параметры игры, задаются при запуске
+struct GameConfig {
+    int mapWidth = 500;
+    int mapHeight = 500;
+    int npcCount = 50;
+    int duration = 30;              // секунды игрового времени
+    int tickMillis = 100;           // логический шаг движения
+    std::size_t battleWorkers = 0;  // 0 - по числу ядер
+    std::size_t movementShards = 0; // полосы карты для движения, 0 - по числу ядер
+    int rebalanceTicks = 50;        // окно балансировки шардов, 0 - полосы не меняются
+    std::uint64_t seed = 0;         // 0 - случайный
+    bool headless = false;          // без карты и вывода каждого боя
+    long long maxTicks = 0;         // 0 - duration * 1000 / tickMillis
+    int logFlushMillis = 100;       // интервал сброса лога боёв
+    std::string journalPath;        // журнал изменений, пусто - без журнала
+    bool record = false;            // запоминать бои для recording()
+    int viewColumns = 10;           // разрешение карты в консоли
+    int viewRows = 10;
+    bool ansiMap = false;           // перерисовывать только изменившиеся клетки
+    std::string metricsPath;        // выгрузка метрик (metrics.h), пусто - без выгрузки
+    int metricsMillis = 1000;       // интервал выгрузки метрик
+
+    static constexpr int MAX_MAP_SIZE = 10000;
+
+    // Бросает std::invalid_argument при недопустимых значениях
+    void validate() const;
+    long long tickLimit() const;
+};
+
+// Итоги прогона в ускоренном режиме
+struct SimulationStats {
+    long long ticks = 0;
+    std::size_t fights = 0;
+    std::size_t kills = 0;
+    std::size_t survivors = 0;
+    double seconds = 0.0;
+    double shardImbalance = 1.0;    // за последнее окно балансировки
+};
+
+// Нагрузка шардов движения за последнее окно балансировки
+struct ShardBalance {
+    double imbalance = 1.0;          // время самого долгого шарда / среднее
+    std::size_t rebalances = 0;      // сколько раз полосы перестраивались
+    std::vector<double> millis;      // процессорное время шардов за окно, мс
+    std::vector<std::size_t> npcs;   // NPC шардов в конце окна
+    std::vector<int> firstRows;      // первая строка ячеек каждого шарда сейчас
+};
+
+// Цена шарда за окно балансировки: cost(шард, NPC шарда в конце окна)
+using ShardCost = std::function<double(std::size_t shard, std::size_t npcs)>;
+
+// Кандидат в бой, найденный за такт (строки World)
+struct BattleCandidate {
+    std::uint32_t defender;
+    std::uint32_t attacker;
+};
+
+// Шард движения: горизонтальная полоса строк ячеек карты и NPC в ней.
+// Шард сам перемещает своих NPC и ищет для них бои; NPC, ушедший в чужую
+// полосу, передается через ящик получателя. Сетки хранят еще по строке
+// ячеек с каждой стороны (призраки): копии пограничных строк соседей,
+// чтобы искать цели у границы без обращения к чужим данным.
+struct MovementShard {
+    int rowBegin = 0;  // свои строки ячеек [rowBegin, rowEnd)
+    int rowEnd = 0;
+    std::vector<std::uint32_t> owned;  // строки World живых NPC полосы
+    std::array<SpatialGrid, fight_rules::TYPE_COUNT> grids;
+    std::vector<std::vector<std::uint32_t>> outbox;  // по шарду-получателю
+    std::vector<BattleCandidate> candidates;
+    std::uint64_t busyNanos = 0;  // процессорное время шарда за окно
+    // Для журнала: погибшие и сдвинувшиеся за такт (строки World)
+    std::vector<std::uint32_t> died;
+    std::vector<std::uint32_t> moved;
 };
 
 class Game {
 private:
+    GameConfig config;
     std::vector<std::shared_ptr<NPC>> npcs;
+    // Позиции, флаги жизни и дистанции NPC колонками; строка i - это npcs[i]
+    World world;
     std::vector<std::thread> threads;
     std::atomic<bool> running;
-    
+
     // Потоки
     std::thread movementThread;
-    std::thread battleThread;
     std::thread mapThread;
-    
-    // Очередь задач для боя
-    std::vector<BattleTask> battleQueue;
-    std::mutex battleMutex;
-    std::condition_variable battleCV;
-    
-    // Мьютекс для вывода
-    static std::mutex coutMutex;
-    
-    // Константы игры
-    static constexpr int MAP_WIDTH = 500;
-    static constexpr int MAP_HEIGHT = 500;
-    static constexpr int GAME_DURATION = 30; // секунды
-    
+
+    // Пул потоков боя со своими lock-free очередями
+    BattlePool battlePool;
+    std::uint32_t nextId;
+
+    // Общий seed: броски и движение считаются от (seed, такт, id NPC)
+    std::uint64_t masterSeed;
+    std::atomic<std::uint32_t> currentTick;
+
+    // Шарды движения со своими сетками для поиска соседей (индексы в npcs),
+    // по сетке на каждый тип NPC. Атакующий смотрит только сетки типов,
+    // которых может убить. У каждого шарда свой поток.
+    std::vector<MovementShard> shards;
+    std::vector<std::uint32_t> shardOfRow;  // шард-владелец строки ячеек
+    std::unique_ptr<ShardPool> shardPool;
+    std::vector<std::uint8_t> inGrid;
+    int gridCellSize;
+
+    // Полосы перестраиваются по измеренному времени шардов раз в
+    // config.rebalanceTicks тактов, если разброс больше допуска.
+    // Без балансировки метрика считается окнами по BALANCE_WINDOW тактов
+    int ticksSinceBalance;
+    ShardCost shardCost;
+    mutable std::mutex balanceMutex;
+    ShardBalance balance;
+    static constexpr double IMBALANCE_TOLERANCE = 1.1;
+    static constexpr int BALANCE_WINDOW = 50;
+
+    // Кандидаты в бой текущего такта. Заполняются и разбираются потоком
+    // движения, память переиспользуется между тактами.
+    std::vector<BattleCandidate> battleBatch;
+
+    // Снимки позиций и флагов жизни, публикуются раз в такт
+    SnapshotBuffer snapshots;
+
+    // Статистика боёв и число живых по типам
+    std::atomic<std::size_t> fightCount;
+    std::atomic<std::size_t> killCount;
+    std::array<std::atomic<int>, 4> aliveByType;
+
+    // Лог боёв: потоки боя только кладут события, пишет фоновый поток
+    std::shared_ptr<FightLog> fightLog;
+    std::uint32_t battleChannel;
+
+    // Наблюдатели боёв, общие для всех NPC игры
+    std::shared_ptr<ObserverRegistry> observers;
+
+    // Журнал перемещений и гибели NPC; пишет только поток движения
+    std::unique_ptr<Journal> journal;
+
+    // Бои для записи прогона (config.record) и число тактов, бои которых
+    // разрешены полностью: бои последнего такта при остановке могут
+    // остаться неразобранными
+    mutable std::mutex recordMutex;
+    std::vector<FightRecord> recordedFights;
+    std::atomic<std::uint32_t> settledTicks;
+
+    // Метрики такта (metrics.h): начало такта, начало фазы боя и число
+    // выделений памяти на начало такта. Пишет только поток движения
+    std::uint64_t tickStartNanos;
+    std::uint64_t battleStartNanos;
+    std::uint64_t tickStartAllocations;
+    std::unique_ptr<metrics::Exporter> metricsExporter;
+
+    // Мьютекс для вывода, общий с логом боёв
+    static std::mutex& coutMutex;
+
+    static constexpr std::size_t BATTLE_QUEUE_CAPACITY = 1 << 16;
+
 public:
-    Game();
+    explicit Game(const GameConfig& config = GameConfig());
     ~Game();
-    
-    void initialize(int npcCount = 50);
+
+    void initialize();
+    void initialize(int npcCount);
     void start();
     void stop();
-    
+
+    // Ускоренный режим: такты идут без пауз, бои каждого такта
+    // разрешаются до следующего. Останавливается по лимиту тактов или
+    // когда в живых остается один тип NPC.
+    SimulationStats runHeadless();
+
+    void setSeed(std::uint64_t seed);
+    std::uint64_t getSeed() const;
+    const GameConfig& getConfig() const;
+
+    // Один такт движения: шарды параллельно перемещают живых NPC и ищут
+    // бои, найденные бои ставятся в очередь, не больше одной ожидающей
+    // атаки на защищающегося. Возвращает количество поставленных задач.
+    std::size_t movementTick();
+
+    // Бинарный снимок мира (binary_snapshot.h). Вызывать, когда потоки
+    // игры остановлены. Загрузка заменяет всех NPC; размер карты
+    // снимка должен совпадать с настройками игры.
+    void saveSnapshot(const std::string& path) const;
+    void loadSnapshot(const std::string& path);
+
+    // Восстанавливает NPC, seed и такт из журнала (journal.h) и продолжает
+    // писать журнал, если он включен. Возвращает true, если хвост журнала
+    // был оборван или поврежден и отброшен. Бросает std::runtime_error,
+    // если журнал велся на карте другого размера.
+    bool recoverJournal(const std::string& path);
+
+    // Запись прогона: параметры мира и бои полностью разрешенных тактов.
+    // Пуста по боям, если config.record не задан
+    Recording recording() const;
+    std::size_t npcCount() const;
+    // Число шардов движения (не больше числа строк ячеек карты)
+    std::size_t shardCount() const;
+    // Метрика балансировки шардов за последнее окно
+    ShardBalance shardBalance() const;
+    // Цена шарда вместо замера времени, для воспроизводимых тестов;
+    // задавать до запуска. Пустая функция - снова замер
+    void setShardCost(ShardCost cost);
+
+    std::size_t pendingBattles() const;
+    void clearBattleTasks();
+
 private:
     void movementWorker();
-    void battleWorker();
+    // Ждет боев такта и записывает его метрики
+    void settleTick();
+    void resolveBattle(const BattleTask& task);
     void mapWorker();
-    
+
     static void safePrint(const std::string& message);
-    void printMap() const;
-    
+    void printMap(MapRenderer& renderer) const;
+    void printSurvivors() const;
+
+    // Заменяет всех NPC новыми (игра остановлена)
+    void replaceNPCs(std::vector<std::shared_ptr<NPC>> loaded);
+    void journalDeaths();
+
+    void rebuildGrid();
+    // Раскладывает NPC из сеток по полосам с первыми строками firstRows
+    void partitionShards(const std::vector<int>& firstRows);
+    void balanceShards(bool rebuild);
+    // Фазы такта движения для одного шарда
+    void moveShard(std::size_t index, std::uint32_t tick, const philox::Key& key,
+                   WorldSnapshot& snap);
+    void acceptMigrants(std::size_t index);
+    void detectFights(std::size_t index, const WorldSnapshot& snap);
+    void resetSnapshot();
+    int aliveFactions() const;
+
     void addBattleTask(const BattleTask& task);
-    BattleTask getBattleTask();
-};
\ No newline at end of file
+    std::size_t submitBattleBatch(std::uint32_t tick, const philox::Key& key);
+};
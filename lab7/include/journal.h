@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "npc.h"
+
+// Состояние мира, восстановленное из журнала
+struct JournalState {
+    std::uint64_t seed = 0;
+    std::uint32_t tick = 0;                  // следующий такт
+    int mapWidth = 0;                        // карта, на которой велся журнал
+    int mapHeight = 0;
+    std::vector<std::shared_ptr<NPC>> npcs;  // по возрастанию id
+    std::size_t records = 0;                 // применено записей после снимка
+    bool truncated = false;                  // хвост оборван или поврежден
+};
+
+// Журнал изменений NPC, только дописываемый.
+//
+// Файл - текстовый. Первая строка "J 2 <seed> <такт> <ширина> <высота>",
+// за ней полный снимок: записи добавления всех NPC. Дальше идут изменения:
+//   A <id>           затем запись NPC::save (добавление)
+//   M <id> <x> <y>   перемещение
+//   K <id>           гибель
+//   R <id>           затем строка с новым именем
+//   T <такт>         номер следующего такта
+// Записи копятся в буфере и уходят в файл одним write на commit(),
+// поэтому сохранение после нескольких правок стоит только этих правок.
+// Когда изменений набирается больше двух снимков, compact() переписывает
+// файл одним снимком текущего состояния (через временный файл и rename).
+// После падения replay() восстанавливает последнее записанное состояние.
+// Координаты вне карты из заголовка считаются повреждением журнала.
+//
+// Не потокобезопасен: пишет один поток (в игре - поток движения).
+class Journal {
+public:
+    static constexpr std::uint32_t VERSION = 2;
+    static constexpr std::size_t MIN_COMPACT_BYTES = 1 << 20;
+
+    // Открывает файл для дописывания, создает его при необходимости.
+    // Бросает std::runtime_error, если файл не открылся
+    explicit Journal(const std::string& path, std::size_t minCompactBytes = MIN_COMPACT_BYTES);
+    ~Journal();
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    void add(const NPC& npc);
+    void move(std::uint32_t id, int x, int y);
+    void kill(std::uint32_t id);
+    void rename(std::uint32_t id, const std::string& name);
+    void tick(std::uint32_t nextTick);
+
+    // Записывает накопленные записи в файл
+    void commit();
+
+    // Изменений после снимка больше, чем стоит его переписать
+    bool needsCompaction() const;
+    // Заменяет файл снимком npcs; незаписанные изменения отбрасываются
+    void compact(const std::vector<std::shared_ptr<NPC>>& npcs,
+                 std::uint64_t seed, std::uint32_t nextTick, int mapWidth, int mapHeight);
+
+    // Размер снимка и изменений после него, включая буфер
+    std::size_t snapshotSize() const;
+    std::size_t changesSize() const;
+    const std::string& getPath() const;
+
+    // Снимок и все целые записи после него. Оборванная или поврежденная
+    // запись и все, что за ней, отбрасываются. Бросает std::runtime_error, если файла нет или это не журнал
+    static JournalState replay(const std::string& path);
+
+private:
+    std::string path;
+    int fd;
+    std::string buffer;
+    std::size_t snapshotBytes;
+    std::size_t appendedBytes;
+    std::size_t minCompactBytes;
+
+    void open();
+};
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// Ограниченная lock-free очередь на кольцевом буфере (схема Д. Вьюкова).
+// Каждая ячейка хранит номер последовательности, по которому производители
+// и потребители понимают, свободна ли она. Вставка и извлечение - O(1) без
+// мьютекса; допускается несколько производителей и потребителей.
+// Мьютекс и condition_variable используются только для засыпания
+// потребителя на пустой очереди.
+template<typename T>
+class LockFreeQueue {
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    std::vector<Cell> buffer;
+    std::size_t mask;
+
+    alignas(64) std::atomic<std::size_t> head;   // позиция записи
+    alignas(64) std::atomic<std::size_t> tail;   // позиция чтения
+    alignas(64) std::atomic<bool> closed;
+
+    std::atomic<int> waiters;
+    std::mutex waitMutex;
+    std::condition_variable waitCV;
+
+    void wakeConsumer() {
+        // Барьер в паре с fetch_add в waitPop: либо потребитель увидит
+        // новый элемент, либо мы увидим, что он ждет
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard lock(waitMutex);
+            waitCV.notify_one();
+        }
+    }
+
+public:
+    explicit LockFreeQueue(std::size_t capacity)
+        : buffer(capacity), mask(capacity - 1),
+          head(0), tail(0), closed(false), waiters(0) {
+        if (capacity < 2 || (capacity & (capacity - 1)) != 0) {
+            throw std::invalid_argument("LockFreeQueue: capacity must be a power of two");
+        }
+        for (std::size_t i = 0; i < capacity; ++i) {
+            buffer[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    LockFreeQueue(const LockFreeQueue&) = delete;
+    LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+    // Неблокирующая вставка, false если очередь заполнена
+    bool tryPush(T value) {
+        std::size_t pos = head.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = buffer[pos & mask];
+            std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    wakeConsumer();
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Вставка с ожиданием свободного места; false если очередь закрыта
+    bool push(T value) {
+        while (!closed.load(std::memory_order_acquire)) {
+            if (tryPush(value)) return true;
+            std::this_thread::yield();
+        }
+        return false;
+    }
+
+    // Неблокирующее извлечение, false если очередь пуста
+    bool tryPop(T& out) {
+        std::size_t pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = buffer[pos & mask];
+            std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out = std::move(cell.value);
+                    cell.value = T{};
+                    cell.sequence.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Извлечение с ожиданием; false если очередь закрыта
+    bool waitPop(T& out) {
+        if (tryPop(out)) return true;
+
+        std::unique_lock lock(waitMutex);
+        waiters.fetch_add(1, std::memory_order_seq_cst);
+        bool ok = false;
+        for (;;) {
+            if (closed.load(std::memory_order_acquire)) break;
+            if (tryPop(out)) {
+                ok = true;
+                break;
+            }
+            waitCV.wait(lock);
+        }
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+        return ok;
+    }
+
+    // Извлечение с ожиданием не дольше timeout; false по таймауту или
+    // если очередь закрыта
+    template<typename Rep, typename Period>
+    bool waitPopFor(T& out, const std::chrono::duration<Rep, Period>& timeout) {
+        if (tryPop(out)) return true;
+
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        std::unique_lock lock(waitMutex);
+        waiters.fetch_add(1, std::memory_order_seq_cst);
+        bool ok = false;
+        for (;;) {
+            if (closed.load(std::memory_order_acquire)) break;
+            if (tryPop(out)) {
+                ok = true;
+                break;
+            }
+            if (waitCV.wait_until(lock, deadline) == std::cv_status::timeout) {
+                ok = tryPop(out);
+                break;
+            }
+        }
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+        return ok;
+    }
+
+    // Закрывает очередь и будит всех ожидающих
+    void close() {
+        closed.store(true, std::memory_order_release);
+        std::lock_guard lock(waitMutex);
+        waitCV.notify_all();
+    }
+
+    void open() {
+        closed.store(false, std::memory_order_release);
+    }
+
+    bool isClosed() const {
+        return closed.load(std::memory_order_acquire);
+    }
+
+    // Приблизительный размер (точен, если нет параллельных операций)
+    std::size_t size() const {
+        std::size_t h = head.load(std::memory_order_acquire);
+        std::size_t t = tail.load(std::memory_order_acquire);
+        return h >= t ? h - t : 0;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    std::size_t capacity() const {
+        return buffer.size();
+    }
+};
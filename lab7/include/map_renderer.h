@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "world_snapshot.h"
+
+// Вид кадра карты
+enum class RenderMode {
+    Plain,  // каждый кадр целиком, текстом
+    Ansi    // первый кадр целиком, дальше только изменившиеся клетки
+};
+
+// Отрисовка карты по снимку мира в текстовый кадр.
+//
+// Карта мира сжимается до columns x rows клеток; в клетке виден символ
+// последнего живого NPC снимка, попавшего в нее. Кадр собирается в одну
+// строку, чтобы уйти в терминал одним write: консоль занята только на
+// время этого вызова, а не на время обхода NPC.
+//
+// В режиме Ansi карта стоит в верхних строках экрана, а строки лога
+// прокручиваются под ней (область прокрутки терминала). Следующие кадры
+// переставляют курсор только на изменившиеся клетки.
+//
+// Не потокобезопасен: рисует один поток (в игре - поток карты).
+class MapRenderer {
+public:
+    static constexpr int MAX_VIEW_SIZE = 500;
+
+    // Бросает std::invalid_argument, если размеры вне допустимых
+    MapRenderer(int mapWidth, int mapHeight, int columns, int rows,
+                RenderMode mode = RenderMode::Plain);
+
+    // Раскладывает живых NPC по клеткам. Снимок нужен только на это время
+    void rasterize(const WorldSnapshot& snapshot);
+
+    // Текст кадра по последней раскладке
+    const std::string& compose();
+
+    // Возвращает терминал в обычный режим (для Ansi), иначе пусто
+    std::string finish() const;
+
+    // Следующий кадр рисуется целиком
+    void reset();
+
+    char cell(int column, int row) const;
+    std::size_t aliveCount() const;
+    int getColumns() const;
+    int getRows() const;
+
+    // Пишет data в fd целиком; при частичной записи дописывает остаток.
+    // Бросает std::runtime_error при ошибке записи
+    static void emit(int fd, const std::string& data);
+
+private:
+    int columns;
+    int rows;
+    RenderMode mode;
+    // Клетка по координате мира: без деления на каждого NPC
+    std::vector<int> columnOf;
+    std::vector<int> rowOf;
+    std::vector<char> cells;
+    std::vector<char> shown;  // клетки, уже выведенные в терминал
+    bool drawn;
+    std::size_t alive;
+    std::size_t shownAlive;
+    std::string frame;
+
+    void composeFull();
+    void composeDiff();
+    void appendAlive();
+};
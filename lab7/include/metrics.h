@@ -0,0 +1,133 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Метрики движка: задержки фаз такта, глубина очереди боев, бои и
+// убийства, ожидание блокировок NPC и выделения памяти.
+//
+// Каждый поток пишет в свой слот счетчиков: слот выделяется при первой
+// записи из статического массива, без выделения памяти (счетчик выделений
+// ведется из operator new). Писатель у слота один, поэтому запись - обычные
+// load/store с relaxed; читатель (выгрузка) суммирует слоты всех потоков.
+// Слот завершившегося потока со всеми счетчиками достается следующему
+// новому потоку. Потоки сверх MAX_THREADS живых одновременно делят общий
+// слот и пишут через fetch_add.
+//
+// Выделения считает замена operator new из alloc_hook.cpp. Она собирается
+// только в симулятор и тесты; в остальных программах счетчик стоит на нуле.
+//
+// Метрики общие для процесса и только растут (кроме показателей-gauge),
+// как принято в Prometheus: скорость считает тот, кто их читает.
+namespace metrics {
+
+// Гистограммы по тактам
+enum Histogram : std::size_t {
+    MovePhase = 0,     // перемещение NPC, нс
+    MigratePhase,      // прием перешедших границу шарда, нс
+    DetectPhase,       // поиск боев, нс
+    BattlePhase,       // постановка и разрешение боев такта, нс
+    TickTotal,         // весь такт, нс
+    QueueDepth,        // боев в очереди за такт
+    TickAllocations,   // выделений памяти за такт во всех потоках
+    HISTOGRAM_COUNT
+};
+
+// Счетчики
+enum Counter : std::size_t {
+    Ticks = 0,
+    Fights,
+    Kills,
+    LockWaits,         // захватов занятого мьютекса NPC
+    LockWaitNanos,     // сколько они ждали
+    Allocations,       // вызовов operator new (с alloc_hook.cpp)
+    COUNTER_COUNT
+};
+
+// Показатели - последнее значение, пишет один поток
+enum Gauge : std::size_t {
+    AliveNpcs = 0,
+    LastQueueDepth,
+    ShardImbalance,    // время самого долгого шарда движения / среднее за окно
+    GAUGE_COUNT
+};
+
+// Границы корзин - степени двойки: le = 2^i единиц (мкс для времени,
+// штук для счетов), i < BUCKETS; последняя корзина - +Inf
+constexpr std::size_t BUCKETS = 24;
+constexpr std::size_t MAX_THREADS = 256;
+
+// Сумма по всем потокам
+struct Snapshot {
+    struct Distribution {
+        std::array<std::uint64_t, BUCKETS + 1> buckets{};  // не накопленные
+        std::uint64_t count = 0;
+        std::uint64_t sum = 0;
+    };
+    std::array<Distribution, HISTOGRAM_COUNT> histograms{};
+    std::array<std::uint64_t, COUNTER_COUNT> counters{};
+    std::array<double, GAUGE_COUNT> gauges{};
+};
+
+void add(Counter counter, std::uint64_t value = 1);
+void observe(Histogram histogram, std::uint64_t value);
+void set(Gauge gauge, double value);
+
+// Номер корзины для значения гистограммы
+std::size_t bucketOf(Histogram histogram, std::uint64_t value);
+// Выделения памяти во всех потоках с начала работы
+std::uint64_t allocations();
+// Сколько слотов потоков занято за все время, без общего
+std::size_t threadSlots();
+// Монотонное время, нс
+std::uint64_t nowNanos();
+
+Snapshot collect();
+
+// Текст в формате Prometheus (text exposition 0.0.4). fightsPerSecond и
+// killsPerSecond - скорость за последний интервал выгрузки
+std::string formatPrometheus(const Snapshot& snapshot,
+                             double fightsPerSecond = 0.0, double killsPerSecond = 0.0);
+
+// Фоновая выгрузка в файл раз в interval. Файл заменяется целиком
+// (запись во временный и rename), читатель не увидит половину выгрузки.
+class Exporter {
+public:
+    // Бросает std::invalid_argument при пустом пути или интервале
+    Exporter(std::string path, std::chrono::milliseconds interval);
+    ~Exporter();
+
+    Exporter(const Exporter&) = delete;
+    Exporter& operator=(const Exporter&) = delete;
+
+    // Выгружает сейчас. Бросает std::runtime_error, если файл не записался
+    void exportNow();
+    // Последняя выгрузка и остановка потока
+    void stop();
+
+    const std::string& getPath() const;
+
+private:
+    std::string path;
+    std::chrono::milliseconds interval;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping;
+    std::thread thread;
+
+    // Для скорости боев между выгрузками
+    std::uint64_t lastNanos;
+    std::uint64_t lastFights;
+    std::uint64_t lastKills;
+
+    void run();
+};
+
+} // namespace metrics
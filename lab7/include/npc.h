@@ -1,11 +1,12 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <iostream>
 #include <memory>
 #include <string>
 #include <vector>
 #include <cmath>
-#include <random>
 #include <mutex>
 #include <shared_mutex>
 
@@ -15,6 +16,10 @@ class Knight;
 class Pegasus;
 class IFightVisitor;
 class IFightObserver;
+class ObserverRegistry;
+class World;
+
+using ObserverList = std::vector<std::shared_ptr<IFightObserver>>;
 
 // NPC типы
 enum class NpcType {
@@ -24,40 +29,104 @@ enum class NpcType {
     Pegasus = 3
 };
 
+// Итог разрешения боя
+enum class FightOutcome {
+    Skipped,   // один из участников уже мертв
+    Killed,    // защищающийся убит
+    Survived   // защищающийся отбился
+};
+
 class NPC : public std::enable_shared_from_this<NPC> {
 protected:
+    // Состояние NPC вне мира. У привязанного NPC его нет: позиция и флаг
+    // жизни лежат в колонках World, имя и наблюдатели - в его боковых
+    // таблицах по дескриптору, блокировка - в полосе мьютексов мира.
+    struct Standalone {
+        int x = 0;
+        int y = 0;
+        bool alive = true;
+        std::string name;
+        std::shared_mutex mutex;
+        // Общий список наблюдателей и необязательные собственные.
+        // Оба неизменяемы после публикации, уведомление их не копирует.
+        std::shared_ptr<ObserverRegistry> registry;
+        std::shared_ptr<const ObserverList> ownObservers;
+    };
+
+    std::uint32_t id;
     NpcType type;
-    int x;
-    int y;
-    std::string name;
-    bool alive;
-    mutable std::shared_mutex mutex;  // Используем shared_mutex
-    
-    std::vector<std::shared_ptr<IFightObserver>> observers;
+    // Первый такт, на котором NPC уже мертв (0 - убит вне тактов)
+    std::uint32_t deathTick;
+    mutable std::atomic<std::uint32_t> rollCounter;  // для бросков без такта
+    std::uint32_t handle;
+    World* world;
+    std::unique_ptr<Standalone> own;  // только пока NPC не привязан к миру
+
+    // Текущее состояние без блокировки (вызывающий держит mutex())
+    int posX() const;
+    int posY() const;
+    bool aliveState() const;
+    void storeAlive(bool value);
+    const std::string& nameRef() const;
+    std::shared_mutex& mutex() const;
 
 public:
+    // Seed для бросков, сделанных вне игры (без такта)
+    static constexpr std::uint64_t DEFAULT_SEED = 0x5EED5EED5EED5EEDull;
+
     NPC(NpcType t, int x, int y, const std::string& name);
     virtual ~NPC() = default;
 
-    // Геттеры
+    // Геттеры (id и тип задаются до запуска потоков и читаются без блокировки)
+    std::uint32_t getId() const;
     NpcType getType() const;
     int getX() const;
     int getY() const;
+    // Ссылка действительна до следующих setName, attach и detach
     const std::string& getName() const;
     bool isAlive() const;
 
     // Сеттеры
+    void setId(std::uint32_t newId);
     void setPosition(int newX, int newY);
     void setName(const std::string& newName);
     void setAlive(bool isAlive);
 
+    // Привязка к хранилищу World: NPC становится представлением своей строки,
+    // собственное состояние переносится в мир и освобождается; detach
+    // возвращает его обратно. attach/detach вызываются только до запуска потоков.
+    void attach(World& target);
+    void detach();
+    World* getWorld() const;
+    std::uint32_t getHandle() const;
+
     // Методы для движения и боя
     virtual int getMoveDistance() const = 0;
     virtual int getKillDistance() const = 0;
     int rollAttack() const;
     int rollDefense() const;
 
-    // Паттерн обзервера
+    // Детерминированные броски: зависят только от seed, такта, id этого NPC
+    // и id противника, общего состояния нет
+    int rollAttack(std::uint64_t seed, std::uint32_t tick, std::uint32_t opponentId) const;
+    int rollDefense(std::uint64_t seed, std::uint32_t tick, std::uint32_t opponentId) const;
+
+    // Разрешает бой с defender. Оба NPC блокируются в порядке адресов их
+    // мьютексов (в мире NPC может делить мьютекс с соседом), поэтому
+    // встречные бои из разных потоков не взаимоблокируются, а проверка
+    // "оба живы" и убийство выполняются атомарно.
+    FightOutcome fight(NPC& defender, int attackPower, int defensePower);
+
+    // Бой, найденный на такте tick. Атакующий, погибший на этом же или
+    // более позднем такте, все равно бьет: бои такта считаются
+    // одновременными, и исход не зависит от порядка их разрешения потоками.
+    // Защищающийся должен быть жив.
+    FightOutcome fight(NPC& defender, int attackPower, int defensePower, std::uint32_t tick);
+
+    // Паттерн обзервера. Наблюдатели берутся из общего реестра мира;
+    // subscribe добавляет наблюдателя только этому NPC. У привязанного NPC
+    // реестр - реестр его мира, setObserverRegistry меняет его для всех.
+    void setObserverRegistry(std::shared_ptr<ObserverRegistry> shared);
     void subscribe(const std::shared_ptr<IFightObserver>& observer);
     void notifyFight(const std::shared_ptr<NPC>& defender, bool win);
 
@@ -77,6 +146,10 @@ public:
 
     // Блокировка для потокобезопасности
     std::unique_lock<std::shared_mutex> getLock() const;
+    // Без ожидания: owns_lock() == false, если мьютекс занят
+    std::unique_lock<std::shared_mutex> getLock(std::try_to_lock_t) const;
+    // Без захвата: чтобы сравнить мьютексы двух NPC перед блокировкой
+    std::unique_lock<std::shared_mutex> getLock(std::defer_lock_t) const;
 };
 
 std::ostream& operator<<(std::ostream& os, const NPC& npc);
\ No newline at end of file
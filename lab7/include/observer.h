@@ -1,8 +1,10 @@
 #pragma once
 #include <memory>
 #include <fstream>
-
-class NPC;
+#include <mutex>
+#include <string>
+#include "fight_log.h"
+#include "npc.h"
 
 class IFightObserver {
 public:
@@ -12,8 +14,42 @@ public:
                         bool win) = 0;
 };
 
+// Общий список наблюдателей для всех NPC мира (RCU).
+// Читатели атомарно берут указатель на неизменяемый список и обходят его
+// без блокировок и копирования; запись создает новый список и публикует
+// его атомарной заменой указателя. Старый список живет, пока его читают.
+class ObserverRegistry {
+private:
+    std::shared_ptr<const ObserverList> list;
+    std::mutex writeMutex;  // писатели по очереди, читатели не ждут
+
+    void publish(std::shared_ptr<const ObserverList> updated);
+
+public:
+    ObserverRegistry();
+
+    void subscribe(const std::shared_ptr<IFightObserver>& observer);
+    void unsubscribe(const std::shared_ptr<IFightObserver>& observer);
+    void clear();
+
+    std::shared_ptr<const ObserverList> snapshot() const;
+    std::size_t size() const;
+
+    void notify(const std::shared_ptr<NPC>& attacker,
+                const std::shared_ptr<NPC>& defender,
+                bool win) const;
+};
+
+// Наблюдатели пишут через FightLog, если он передан: в потоке боя событие
+// только кладется в очередь. Без FightLog запись идет сразу.
 class ConsoleObserver : public IFightObserver {
+private:
+    std::shared_ptr<FightLog> log;
+    std::uint32_t channel;
+
 public:
+    explicit ConsoleObserver(std::shared_ptr<FightLog> log = nullptr);
+
     void onFight(const std::shared_ptr<NPC>& attacker,
                 const std::shared_ptr<NPC>& defender,
                 bool win) override;
@@ -21,13 +57,18 @@ public:
 
 class FileObserver : public IFightObserver {
 private:
-    std::ofstream logFile;
+    // Поток общий с приемником FightLog и живет, пока лог не допишет его
+    std::shared_ptr<std::ofstream> logFile;
+    std::mutex fileMutex;  // onFight вызывается из нескольких потоков боя
+    std::shared_ptr<FightLog> log;
+    std::uint32_t channel;
     
 public:
-    FileObserver(const std::string& filename = "log.txt");
+    FileObserver(const std::string& filename = "log.txt",
+                 std::shared_ptr<FightLog> log = nullptr);
     ~FileObserver();
     
     void onFight(const std::shared_ptr<NPC>& attacker,
                 const std::shared_ptr<NPC>& defender,
                 bool win) override;
-};
\ No newline at end of file
+};
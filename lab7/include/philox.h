@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Счётчиковый генератор Philox4x32-10 (Salmon et al., "Parallel random
+// numbers: as easy as 1, 2, 3", 2011). Результат - чистая функция от
+// счётчика и ключа, поэтому генератору не нужно общее состояние: любой поток
+// получает одно и то же число для одного и того же (seed, такт, NPC).
+namespace philox {
+
+using Counter = std::array<std::uint32_t, 4>;
+using Key = std::array<std::uint32_t, 2>;
+
+constexpr std::uint32_t M0 = 0xD2511F53u;
+constexpr std::uint32_t M1 = 0xCD9E8D57u;
+constexpr std::uint32_t W0 = 0x9E3779B9u;
+constexpr std::uint32_t W1 = 0xBB67AE85u;
+
+inline Counter round(const Counter& c, const Key& k) {
+    std::uint64_t p0 = static_cast<std::uint64_t>(M0) * c[0];
+    std::uint64_t p1 = static_cast<std::uint64_t>(M1) * c[2];
+    return {
+        static_cast<std::uint32_t>(p1 >> 32) ^ c[1] ^ k[0],
+        static_cast<std::uint32_t>(p1),
+        static_cast<std::uint32_t>(p0 >> 32) ^ c[3] ^ k[1],
+        static_cast<std::uint32_t>(p0)
+    };
+}
+
+inline Counter generate(Counter c, Key k) {
+    for (int r = 0; r < 10; ++r) {
+        if (r > 0) {
+            k[0] += W0;
+            k[1] += W1;
+        }
+        c = round(c, k);
+    }
+    return c;
+}
+
+inline Key keyFromSeed(std::uint64_t seed) {
+    return {static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)};
+}
+
+// Назначение случайного числа - отдельное поле счётчика,
+// чтобы броски атаки, защиты и движения не совпадали
+enum Stream : std::uint32_t {
+    Attack = 1,
+    Defense = 2,
+    Move = 3,
+    Target = 4,
+    Spawn = 5
+};
+
+// Равномерное число из [0, n): старшие биты произведения (смещение < n / 2^32)
+inline std::uint32_t uniform(std::uint32_t value, std::uint32_t n) {
+    return static_cast<std::uint32_t>((static_cast<std::uint64_t>(value) * n) >> 32);
+}
+
+// Бросок кубика 1..6 для NPC npcId против opponentId на такте tick
+inline int rollDie(std::uint64_t seed, std::uint32_t tick, std::uint32_t npcId,
+                   std::uint32_t opponentId, Stream stream) {
+    Counter out = generate({tick, npcId, opponentId, stream}, keyFromSeed(seed));
+    return 1 + static_cast<int>(uniform(out[0], 6));
+}
+
+} // namespace philox
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Пакетная проверка дистанции: одна точка (x, y) против блока до 64
+// позиций из колонок xs/ys. Бит i результата выставлен, если
+// (xs[i] - x)^2 + (ys[i] - y)^2 <= radius^2 - то же условие, что в NPC::isClose.
+//
+// Реализация выбирается один раз во время работы по возможностям
+// процессора: AVX2 (8 позиций за шаг), SSE2 (4 позиции) или скалярная.
+// Все варианты дают одинаковый результат, если разности координат
+// и радиус по модулю не больше MAX_SPAN (карта до 10000x10000).
+namespace proximity {
+
+constexpr std::size_t BLOCK_SIZE = 64;
+// Наибольший разброс координат и радиус, при которых ядра точны
+constexpr int MAX_SPAN = 32767;
+
+enum class Isa {
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+using Kernel = std::uint64_t (*)(int x, int y, int radius,
+                                 const int* xs, const int* ys, std::size_t count);
+
+// count не больше BLOCK_SIZE, лишние позиции не проверяются
+std::uint64_t withinRadius(int x, int y, int radius,
+                           const int* xs, const int* ys, std::size_t count);
+
+// Лучший набор инструкций, доступный на этом процессоре
+Isa activeIsa();
+bool isSupported(Isa isa);
+const char* isaName(Isa isa);
+// Конкретная реализация (для тестов и бенчмарков); nullptr, если не поддерживается
+Kernel kernelFor(Isa isa);
+
+// Вызывает f(i) для каждого выставленного бита маски по возрастанию i
+template<typename F>
+void forEachBit(std::uint64_t mask, F&& f) {
+    while (mask) {
+#if defined(__GNUC__)
+        std::size_t i = static_cast<std::size_t>(__builtin_ctzll(mask));
+#else
+        std::size_t i = 0;
+        while (!((mask >> i) & 1)) ++i;
+#endif
+        f(i);
+        mask &= mask - 1;
+    }
+}
+
+} // namespace proximity
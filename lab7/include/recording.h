@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Разрешенный бой: такт, id атакующего и защищающегося, исход
+struct FightRecord {
+    std::uint32_t tick = 0;
+    std::uint32_t attacker = 0;
+    std::uint32_t defender = 0;
+    bool killed = false;
+
+    bool operator==(const FightRecord& other) const {
+        return tick == other.tick && attacker == other.attacker &&
+               defender == other.defender && killed == other.killed;
+    }
+    bool operator!=(const FightRecord& other) const { return !(*this == other); }
+};
+
+// Запись прогона игры: параметры, из которых мир восстанавливается
+// целиком (seed, карта, число NPC), и все бои по тактам. Повтор с теми же
+// параметрами обязан дать те же бои при любом числе потоков боя.
+//
+// Файл - текстовый:
+//   DNGREC 1
+//   seed <seed>
+//   map <ширина> <высота>
+//   npcs <число NPC>
+//   ticks <число тактов>
+//   fights <число боев>
+// и дальше по строке на бой: "<такт> <атакующий> <защищающийся> K|S"
+// (K - убит, S - выжил), по возрастанию (такт, защищающийся, атакующий).
+struct Recording {
+    static constexpr std::uint32_t VERSION = 1;
+
+    std::uint64_t seed = 0;
+    int mapWidth = 0;
+    int mapHeight = 0;
+    int npcCount = 0;
+    long long ticks = 0;
+    std::vector<FightRecord> fights;
+
+    // Канонический порядок боев, не зависящий от потоков
+    void sortFights();
+
+    // Бросает std::runtime_error, если файл не открылся или поврежден
+    void save(const std::string& path) const;
+    static Recording load(const std::string& path);
+};
+
+// Первое расхождение прогона actual с записью expected или пустая строка.
+// Число тактов не сравнивается: ускоренный прогон заканчивается раньше,
+// когда в живых остается один тип NPC и боев больше быть не может.
+std::string firstDifference(const Recording& expected, const Recording& actual);
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Расчеты для балансировки шардов движения по полосам строк ячеек
+namespace shard_balance {
+
+// Отношение самой большой нагрузки к средней; 1 - нагрузка ровная
+// (и для пустого списка или нулевых нагрузок)
+double imbalance(const std::vector<double>& loads);
+
+// Делит строки с ценами rowCosts на shards полос подряд идущих строк
+// с примерно равной суммой цен. Возвращает первую строку каждой полосы;
+// в каждой полосе хотя бы одна строка. Если все цены нулевые, строки
+// делятся поровну. Бросает std::invalid_argument, если строк меньше,
+// чем полос, или полос ноль.
+std::vector<int> split(const std::vector<double>& rowCosts, std::size_t shards);
+
+} // namespace shard_balance
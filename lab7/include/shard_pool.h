@@ -0,0 +1,46 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Потоки шардов движения: у каждого шарда свой постоянный поток, и шард
+// всегда обрабатывается одним и тем же потоком (его данные остаются в кэше
+// этого ядра). run() - одна фаза такта: все шарды выполняют задачу
+// параллельно, вызов возвращается, когда закончили все. Шард 0
+// обрабатывает вызывающий поток, поэтому при одном шарде потоков нет.
+class ShardPool {
+public:
+    using Job = std::function<void(std::size_t shard)>;
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable startCV;
+    std::condition_variable doneCV;
+    const Job* job;
+    std::size_t generation;  // номер фазы, меняется при каждом run()
+    std::size_t remaining;   // шарды фазы, еще не закончившие работу
+    bool closed;
+    std::exception_ptr failure;
+
+    void workerLoop(std::size_t shard);
+    void runShard(std::size_t shard);
+
+public:
+    explicit ShardPool(std::size_t shards = 1);
+    ~ShardPool();
+
+    ShardPool(const ShardPool&) = delete;
+    ShardPool& operator=(const ShardPool&) = delete;
+
+    // Выполняет job(shard) для каждого шарда и ждет всех.
+    // Исключение из задачи пробрасывается после завершения фазы
+    void run(const Job& job);
+
+    std::size_t size() const;
+};
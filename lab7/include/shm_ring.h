@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Разделяемая память POSIX для процессов одной машины
+namespace shm {
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+              "Atomics in shared memory must not need locks");
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free,
+              "Atomics in shared memory must not need locks");
+
+// Сегмент shm_open + mmap. Создатель удаляет имя сразу после отображения:
+// процессы, порожденные fork(), наследуют отображение, а после падения
+// в /dev/shm ничего не остается.
+class Segment {
+private:
+    std::string name;
+    void* data;
+    std::size_t length;
+
+public:
+    // Новый обнуленный сегмент. Бросает std::runtime_error при ошибке
+    explicit Segment(std::size_t bytes);
+    ~Segment();
+
+    Segment(const Segment&) = delete;
+    Segment& operator=(const Segment&) = delete;
+
+    void* get() const { return data; }
+    std::size_t size() const { return length; }
+    const std::string& getName() const { return name; }
+};
+
+// Сообщение между процессами: одно на NPC, заявку на бой или итог боя
+struct Message {
+    enum Kind : std::uint32_t {
+        End = 0,       // конец сообщений фазы от этого отправителя
+        Migrant = 1,   // NPC перешел в чужой регион: id, type, x, y
+        Ghost = 2,     // копия NPC у границы: id, type, x, y
+        Attack = 3,    // заявка на бой: id атакующего, other - защищающийся
+        Fight = 4      // итог боя: id, other, type = 1 если убит, x - такт
+    };
+
+    std::uint32_t kind = End;
+    std::uint32_t id = 0;
+    std::uint32_t other = 0;
+    std::uint32_t type = 0;
+    std::int32_t x = 0;
+    std::int32_t y = 0;
+};
+
+// Кольцевой буфер сообщений с одним писателем и одним читателем.
+// Заголовок и слоты лежат в разделяемой памяти; объект Ring - только вид
+// на них, в каждом процессе свой.
+class Ring {
+public:
+    struct Header {
+        alignas(64) std::atomic<std::uint64_t> head;  // следующий к чтению
+        alignas(64) std::atomic<std::uint64_t> tail;  // следующий к записи
+        alignas(64) std::uint32_t capacity;
+    };
+
+    // Байт памяти под кольцо на capacity сообщений
+    static std::size_t bytes(std::size_t capacity);
+
+    Ring() : header(nullptr), slots(nullptr) {}
+    // Размечает память под кольцо (один раз, до запуска процессов)
+    static Ring create(void* memory, std::size_t capacity);
+    // Вид на уже размеченное кольцо
+    static Ring attach(void* memory);
+
+    // false, если кольцо полно / пусто
+    bool tryPush(const Message& message);
+    bool tryPop(Message& message);
+    std::size_t size() const;
+
+private:
+    Header* header;
+    Message* slots;
+};
+
+// Барьер для процессов: все участники ждут, пока придут остальные.
+// Ожидание - активное с уступанием процессора; poll() вызывается на каждом
+// круге ожидания (например, чтобы разбирать входящие кольца), и если
+// вернет false, ожидание прерывается.
+struct Barrier {
+    std::atomic<std::uint32_t> arrived;
+    std::atomic<std::uint32_t> generation;
+    std::uint32_t parties;
+
+    void init(std::uint32_t count);
+
+    template<typename Poll>
+    bool arriveAndWait(Poll&& poll);
+};
+
+// Пауза в циклах ожидания: сначала уступаем процессор, потом спим
+void backoff(unsigned& spins);
+
+template<typename Poll>
+bool Barrier::arriveAndWait(Poll&& poll) {
+    std::uint32_t current = generation.load(std::memory_order_acquire);
+    if (arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == parties) {
+        arrived.store(0, std::memory_order_relaxed);
+        generation.store(current + 1, std::memory_order_release);
+        return true;
+    }
+    unsigned spins = 0;
+    while (generation.load(std::memory_order_acquire) == current) {
+        if (!poll()) return false;
+        backoff(spins);
+    }
+    return true;
+}
+
+} // namespace shm
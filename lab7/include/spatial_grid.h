@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Равномерная сетка для поиска соседей.
+// Карта делится на квадратные ячейки со стороной cellSize, в каждой ячейке
+// хранятся идентификаторы NPC. Если cellSize не меньше радиуса поиска,
+// кандидаты находятся только в соседних ячейках (3x3).
+//
+// Сетка может хранить не всю карту, а полосу строк ячеек
+// [firstRow, firstRow + rows): так у каждого шарда движения своя сетка
+// своей полосы. Координаты вне полосы прижимаются к ее краю.
+class SpatialGrid {
+private:
+    int cellSize;
+    int cols;
+    int rows;
+    int firstRow;
+    std::vector<std::vector<std::uint32_t>> cells;
+    std::size_t count;
+
+    int cellColumn(int x) const;
+    int cellRow(int y) const;
+    std::vector<std::uint32_t>& cellAt(int x, int y);
+
+public:
+    SpatialGrid(int width = 1, int height = 1, int cellSize = 1);
+    // Только строки ячеек [rowBegin, rowEnd) карты width x height
+    SpatialGrid(int width, int height, int cellSize, int rowBegin, int rowEnd);
+
+    void insert(std::uint32_t id, int x, int y);
+    void remove(std::uint32_t id, int x, int y);
+    // Переносит id в новую ячейку только если ячейка изменилась
+    void move(std::uint32_t id, int oldX, int oldY, int newX, int newY);
+    void clear();
+
+    int getCellSize() const;
+    std::size_t size() const;
+
+    // Строка ячеек карты для координаты y (без прижатия к полосе)
+    int rowOf(int y) const { return y / cellSize; }
+    // Число строк ячеек на карте высоты height
+    static int rowCount(int height, int cellSize) { return height / cellSize + 1; }
+
+    // Очищает строку ячеек row карты (должна лежать в полосе)
+    void clearRow(int row);
+
+    // Вызывает f(id) для всех id строки ячеек row карты
+    template<typename F>
+    void forEachInRow(int row, F&& f) const {
+        const auto* line = &cells[static_cast<std::size_t>(row - firstRow) * cols];
+        for (int c = 0; c < cols; ++c) {
+            for (std::uint32_t id : line[c]) {
+                f(id);
+            }
+        }
+    }
+
+    // Вызывает f(id) для всех id из ячеек, пересекающих квадрат
+    // [x - radius, x + radius] x [y - radius, y + radius]
+    template<typename F>
+    void forEachNear(int x, int y, int radius, F&& f) const {
+        int c0 = cellColumn(x - radius);
+        int c1 = cellColumn(x + radius);
+        int r0 = cellRow(y - radius);
+        int r1 = cellRow(y + radius);
+
+        for (int r = r0; r <= r1; ++r) {
+            for (int c = c0; c <= c1; ++c) {
+                for (std::uint32_t id : cells[r * cols + c]) {
+                    f(id);
+                }
+            }
+        }
+    }
+
+    // То же, но целыми ячейками: f(ids, count) для каждой непустой ячейки.
+    // Удобно для пакетной проверки дистанции.
+    template<typename F>
+    void forEachCellNear(int x, int y, int radius, F&& f) const {
+        int c0 = cellColumn(x - radius);
+        int c1 = cellColumn(x + radius);
+        int r0 = cellRow(y - radius);
+        int r1 = cellRow(y + radius);
+
+        for (int r = r0; r <= r1; ++r) {
+            for (int c = c0; c <= c1; ++c) {
+                const auto& cell = cells[r * cols + c];
+                if (!cell.empty()) {
+                    f(cell.data(), cell.size());
+                }
+            }
+        }
+    }
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "npc.h"
+
+using NpcHandle = std::uint32_t;
+
+// Хранилище состояния NPC в виде структуры массивов (SoA).
+// Каждое поле - отдельный непрерывный массив, NPC адресуется целым
+// дескриптором (индексом строки), который не меняется до clear().
+// Горячие колонки занимают 15 байт на строку. Холодные данные - имена,
+// собственные наблюдатели и общий реестр - лежат в боковых таблицах.
+//
+// Потоки: позиции пишет только поток движения (через NPC::setPosition под
+// блокировкой NPC), остальные потоки читают их через NPC. Блокировка NPC -
+// мьютекс его полосы: строка h закрыта мьютексом h % LOCK_STRIPES. Флаг
+// жизни и флаг ожидающей атаки - атомарные, их читают без блокировок.
+class World {
+public:
+    static constexpr std::size_t LOCK_STRIPES = 1024;
+
+private:
+    // По мьютексу на кеш-линию, чтобы соседние полосы не мешали друг другу
+    struct alignas(64) RowLock {
+        std::shared_mutex mutex;
+    };
+
+    int width;
+    int height;
+    std::size_t count;
+    std::size_t capacity;
+
+    std::vector<int> xs;
+    std::vector<int> ys;
+    std::vector<std::uint8_t> types;
+    std::vector<std::int16_t> moveDistances;
+    std::vector<std::int16_t> killDistances;
+    std::unique_ptr<std::atomic<std::uint8_t>[]> alive;
+    // NPC уже стоит защищающимся в очереди боёв
+    std::unique_ptr<std::atomic<std::uint8_t>[]> pending;
+
+    std::vector<std::string> names;
+    std::unique_ptr<RowLock[]> rowLocks;
+    // Реестр задается до запуска потоков и дальше только читается
+    std::shared_ptr<ObserverRegistry> registry;
+    // Собственные наблюдатели есть у немногих NPC: разреженная таблица
+    mutable std::shared_mutex observersMutex;
+    std::unordered_map<NpcHandle, std::shared_ptr<const ObserverList>> observerTable;
+    std::atomic<bool> hasOwnObservers;
+
+public:
+    World(int width = 500, int height = 500);
+
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    // Выделяет место под n строк. Вызывать только до запуска потоков.
+    void reserve(std::size_t n);
+    NpcHandle add(NpcType type, int x, int y, bool isAlive,
+                  int moveDistance, int killDistance, std::string name = std::string());
+    void clear();
+
+    std::size_t size() const { return count; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    bool inBounds(int px, int py) const {
+        return px >= 0 && px <= width && py >= 0 && py <= height;
+    }
+
+    // Доступ к колонкам
+    int x(NpcHandle h) const { return xs[h]; }
+    int y(NpcHandle h) const { return ys[h]; }
+    NpcType type(NpcHandle h) const { return static_cast<NpcType>(types[h]); }
+    int moveDistance(NpcHandle h) const { return moveDistances[h]; }
+    int killDistance(NpcHandle h) const { return killDistances[h]; }
+    bool isAlive(NpcHandle h) const {
+        return alive[h].load(std::memory_order_relaxed) != 0;
+    }
+
+    void setPosition(NpcHandle h, int px, int py) {
+        xs[h] = px;
+        ys[h] = py;
+    }
+    void setAlive(NpcHandle h, bool value) {
+        alive[h].store(value ? 1 : 0, std::memory_order_relaxed);
+    }
+
+    // Помечает NPC как цель ожидающего боя. false, если метка уже стоит.
+    bool tryMarkPending(NpcHandle h) {
+        return pending[h].exchange(1, std::memory_order_acq_rel) == 0;
+    }
+    void clearPending(NpcHandle h) {
+        pending[h].store(0, std::memory_order_release);
+    }
+    bool isPending(NpcHandle h) const {
+        return pending[h].load(std::memory_order_acquire) != 0;
+    }
+    void clearAllPending();
+
+    // Холодные данные
+    const std::string& name(NpcHandle h) const { return names[h]; }
+    void setName(NpcHandle h, const std::string& value) { names[h] = value; }
+    std::shared_ptr<ObserverRegistry> observerRegistry() const { return registry; }
+    // Только до запуска потоков
+    void setObserverRegistry(std::shared_ptr<ObserverRegistry> shared) { registry = std::move(shared); }
+    std::shared_ptr<const ObserverList> ownObservers(NpcHandle h) const;
+    void setOwnObservers(NpcHandle h, std::shared_ptr<const ObserverList> list);
+
+    std::shared_mutex& rowMutex(NpcHandle h) const { return rowLocks[h % LOCK_STRIPES].mutex; }
+
+    const int* xData() const { return xs.data(); }
+    const int* yData() const { return ys.data(); }
+};
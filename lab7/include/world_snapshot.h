@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "npc.h"
+
+// Снимок состояния мира за один такт: позиции, типы и флаги жизни
+// в непрерывных массивах. Индекс - номер NPC в Game::npcs.
+struct WorldSnapshot {
+    std::uint32_t tick = 0;
+    std::vector<int> x;
+    std::vector<int> y;
+    std::vector<NpcType> type;
+    std::vector<std::uint8_t> alive;
+
+    std::size_t size() const;
+    void resize(std::size_t count);
+};
+
+// Двойной буфер снимков с одним писателем.
+// Писатель заполняет задний буфер и публикует его одной атомарной записью.
+// Читатели берут передний буфер без мьютексов: счётчик читателей буфера
+// не дает писателю начать его перезапись, пока снимок читается.
+class SnapshotBuffer {
+private:
+    WorldSnapshot buffers[2];
+    std::atomic<int> front;
+    mutable std::atomic<int> readers[2];
+
+public:
+    // Доступ на чтение к переднему буферу на время жизни объекта
+    class ReadGuard {
+    private:
+        const SnapshotBuffer* owner;
+        int index;
+
+    public:
+        ReadGuard(const SnapshotBuffer* owner, int index);
+        ReadGuard(ReadGuard&& other) noexcept;
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+        ReadGuard& operator=(ReadGuard&&) = delete;
+        ~ReadGuard();
+
+        const WorldSnapshot& operator*() const;
+        const WorldSnapshot* operator->() const;
+    };
+
+    SnapshotBuffer();
+
+    // Задний буфер для писателя. Начальное содержимое - копия переднего.
+    WorldSnapshot& beginWrite();
+    // Делает задний буфер передним
+    void publish();
+
+    ReadGuard read() const;
+
+    // Сбрасывает оба буфера в одно состояние (только без параллельных читателей)
+    void reset(const WorldSnapshot& snapshot);
+};
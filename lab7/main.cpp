@@ -1,27 +1,253 @@
+#include <algorithm>
+#include <fstream>
 #include <iostream>
+#include <string>
 #include "game.h"
+#include "cluster.h"
 #include "observer.h"
+#include "binary_snapshot.h"
+#include "recording.h"
 
 // Глобальные observers
 static auto consoleObserver = std::make_shared<ConsoleObserver>();
 static auto fileObserver = std::make_shared<FileObserver>("game_log.txt");
 
-int main() {
+static void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --headless        run as fast as possible; no map or fight lines on the console,\n"
+              << "                    kills are still logged to game_log.txt\n"
+              << "  --npcs N          number of NPCs (default 50)\n"
+              << "  --width W         map width (default 500)\n"
+              << "  --height H        map height (default 500)\n"
+              << "  --duration S      game time in seconds (default 30)\n"
+              << "  --ticks N         number of ticks in headless mode\n"
+              << "  --threads N       battle threads (default: number of cores)\n"
+              << "  --shards N        movement shards, one thread each (default: number of cores)\n"
+              << "  --rebalance N     ticks between shard rebalancing, 0 - never (default 50)\n"
+              << "  --processes N     run headless as N processes over shared memory\n"
+              << "  --seed S          master seed (default: random)\n"
+              << "  --log-flush MS    fight log flush interval (default 100)\n"
+              << "  --view-width N    map columns in the console, up to 500 (default 10)\n"
+              << "  --view-height N   map rows in the console, up to 500 (default 10)\n"
+              << "  --ansi-map        keep the map on top and redraw only changed cells\n"
+              << "  --metrics FILE    export tick metrics to FILE in Prometheus text format\n"
+              << "  --metrics-interval MS  metrics export interval (default 1000)\n"
+              << "  --load FILE       restore NPCs from a binary snapshot\n"
+              << "  --save FILE       write a binary snapshot when the game ends\n"
+              << "  --convert FILE    convert a text save to the --save file and exit\n"
+              << "  --journal FILE    append NPC changes to a journal during the run\n"
+              << "  --recover         restore NPCs from the --journal file and continue\n"
+              << "  --record FILE     write the seed and every fight to FILE when the game ends\n"
+              << "  --replay FILE     rerun a recording headless and check the fights match\n";
+}
+
+// Файлы снимков из командной строки
+struct SnapshotOptions {
+    std::string load;
+    std::string save;
+    std::string convert;
+    std::string record;
+    std::string replay;
+    bool recover = false;
+    std::size_t processes = 0;  // 0 - один процесс (Game)
+};
+
+// Разбор аргументов командной строки; false если нужно завершиться
+static bool parseArgs(int argc, char* argv[], GameConfig& config, SnapshotOptions& files) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--headless") {
+            config.headless = true;
+            continue;
+        }
+        if (arg == "--ansi-map") {
+            config.ansiMap = true;
+            continue;
+        }
+        if (arg == "--recover") {
+            files.recover = true;
+            continue;
+        }
+        if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return false;
+        }
+        if (i + 1 >= argc) {
+            throw std::invalid_argument("Missing value for " + arg);
+        }
+
+        std::string value = argv[++i];
+        if (arg == "--npcs") config.npcCount = std::stoi(value);
+        else if (arg == "--width") config.mapWidth = std::stoi(value);
+        else if (arg == "--height") config.mapHeight = std::stoi(value);
+        else if (arg == "--duration") config.duration = std::stoi(value);
+        else if (arg == "--ticks") config.maxTicks = std::stoll(value);
+        else if (arg == "--threads") config.battleWorkers = std::stoul(value);
+        else if (arg == "--shards") config.movementShards = std::stoul(value);
+        else if (arg == "--rebalance") config.rebalanceTicks = std::stoi(value);
+        else if (arg == "--processes") files.processes = std::stoul(value);
+        else if (arg == "--seed") config.seed = std::stoull(value);
+        else if (arg == "--log-flush") config.logFlushMillis = std::stoi(value);
+        else if (arg == "--view-width") config.viewColumns = std::stoi(value);
+        else if (arg == "--view-height") config.viewRows = std::stoi(value);
+        else if (arg == "--metrics") config.metricsPath = value;
+        else if (arg == "--metrics-interval") config.metricsMillis = std::stoi(value);
+        else if (arg == "--load") files.load = value;
+        else if (arg == "--save") files.save = value;
+        else if (arg == "--convert") files.convert = value;
+        else if (arg == "--journal") config.journalPath = value;
+        else if (arg == "--record") files.record = value;
+        else if (arg == "--replay") files.replay = value;
+        else throw std::invalid_argument("Unknown option " + arg);
+    }
+    return true;
+}
+
+// Повтор записи в ускоренном режиме; 0 - бои совпали, 3 - расхождение
+static int replay(const std::string& path, const GameConfig& options) {
+    Recording expected = Recording::load(path);
+
+    GameConfig config;
+    config.headless = true;
+    config.record = true;
+    config.seed = expected.seed;
+    config.mapWidth = expected.mapWidth;
+    config.mapHeight = expected.mapHeight;
+    config.npcCount = expected.npcCount;
+    config.maxTicks = expected.ticks;
+    // Число потоков на исход не влияет, его можно менять
+    config.battleWorkers = options.battleWorkers;
+    config.logFlushMillis = options.logFlushMillis;
+
+    Game game(config);
+    game.initialize();
+    // maxTicks == 0 означает "по длительности", а записано ноль тактов
+    if (expected.ticks > 0) {
+        game.runHeadless();
+    }
+
+    std::string difference = firstDifference(expected, game.recording());
+    if (!difference.empty()) {
+        std::cout << "Replay of " << path << " diverged: " << difference << std::endl;
+        return 3;
+    }
+    std::cout << "Replay of " << path << " matches: " << expected.fights.size()
+              << " fights over " << expected.ticks << " ticks" << std::endl;
+    return 0;
+}
+
+// Ускоренный прогон несколькими процессами (cluster.h)
+static void runCluster(const GameConfig& config, const SnapshotOptions& files) {
+    cluster::Options options;
+    options.processes = files.processes;
+    cluster::Coordinator coordinator(config, options);
+
+    std::cout << "=== DUNGEON SIMULATOR ===" << std::endl;
+    std::cout << "Running " << config.npcCount << " NPCs in " << options.processes
+              << " processes (seed " << coordinator.getSeed() << ")..." << std::endl;
+    SimulationStats stats = coordinator.run();
+
+    double seconds = std::max(stats.seconds, 1e-9);
+    std::cout << "Cluster run: " << stats.ticks << " ticks in " << stats.seconds << " s ("
+              << stats.ticks / seconds << " ticks/sec), "
+              << stats.fights << " fights (" << stats.fights / seconds << " fights/sec), "
+              << stats.kills << " kills, " << stats.survivors << " survivors" << std::endl;
+
+    if (!files.record.empty()) {
+        Recording recording = coordinator.recording();
+        recording.save(files.record);
+        std::cout << "Recorded " << recording.fights.size() << " fights over "
+                  << recording.ticks << " ticks (seed " << recording.seed << ") to "
+                  << files.record << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
     try {
-        Game game;
-        
+        GameConfig config;
+        SnapshotOptions files;
+        if (!parseArgs(argc, argv, config, files)) {
+            return 0;
+        }
+
+        if (!files.convert.empty()) {
+            if (files.save.empty()) {
+                throw std::invalid_argument("--convert needs --save FILE");
+            }
+            std::ifstream text(files.convert);
+            if (!text.is_open()) {
+                throw std::runtime_error("Cannot open " + files.convert);
+            }
+            std::size_t count = snapshot::convertText(text, files.save,
+                                                      config.mapWidth, config.mapHeight);
+            std::cout << "Converted " << count << " NPCs to " << files.save << std::endl;
+            return 0;
+        }
+
+        if (!files.replay.empty()) {
+            return replay(files.replay, config);
+        }
+
+        if (!files.record.empty() && (files.recover || !files.load.empty())) {
+            throw std::invalid_argument("--record needs a world generated from --seed");
+        }
+        config.record = !files.record.empty();
+
+        if (files.processes > 0) {
+            if (!config.headless || !files.load.empty() || !files.save.empty() ||
+                files.recover || !config.journalPath.empty() || !config.metricsPath.empty()) {
+                throw std::invalid_argument(
+                    "--processes runs headless from --seed, without snapshots, journal or metrics");
+            }
+            runCluster(config, files);
+            std::cout << "\nSimulation completed!" << std::endl;
+            return 0;
+        }
+
+        if (files.recover && config.journalPath.empty()) {
+            throw std::invalid_argument("--recover needs --journal FILE");
+        }
+
+        Game game(config);
+
         std::cout << "=== DUNGEON SIMULATOR ===" << std::endl;
-        std::cout << "Initializing game with 50 NPCs..." << std::endl;
-        
-        game.initialize(50);
-        game.start();
-        
+        if (files.recover) {
+            bool truncated = game.recoverJournal(config.journalPath);
+            std::cout << "Recovered " << game.npcCount() << " NPCs from " << config.journalPath
+                      << (truncated ? " (damaged tail dropped)" : "") << std::endl;
+        } else if (files.load.empty()) {
+            std::cout << "Initializing game with " << config.npcCount << " NPCs..." << std::endl;
+            game.initialize();
+        } else {
+            game.loadSnapshot(files.load);
+            std::cout << "Loaded " << game.npcCount() << " NPCs from " << files.load << std::endl;
+        }
+
+        if (config.headless) {
+            game.runHeadless();
+        } else {
+            game.start();
+        }
+
+        if (!files.save.empty()) {
+            game.saveSnapshot(files.save);
+            std::cout << "Saved snapshot to " << files.save << std::endl;
+        }
+
+        if (!files.record.empty()) {
+            Recording recording = game.recording();
+            recording.save(files.record);
+            std::cout << "Recorded " << recording.fights.size() << " fights over "
+                      << recording.ticks << " ticks (seed " << recording.seed << ") to "
+                      << files.record << std::endl;
+        }
+
         std::cout << "\nSimulation completed!" << std::endl;
-        
+
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
         return 1;
     }
-    
+
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,152 @@
+#include "battle_pool.h"
+#include <algorithm>
+
+BattlePool::BattlePool(std::size_t workerCount, std::size_t queueCapacity)
+    : closed(false), roundRobin(0), idle(0), inFlight(0) {
+    if (workerCount == 0) {
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (std::size_t i = 0; i < workerCount; ++i) {
+        queues.push_back(std::make_unique<LockFreeQueue<BattleTask>>(queueCapacity));
+    }
+}
+
+BattlePool::~BattlePool() {
+    stop();
+}
+
+void BattlePool::start(Handler taskHandler) {
+    if (!workers.empty()) {
+        stop();
+    }
+
+    handler = std::move(taskHandler);
+    closed = false;
+    for (auto& queue : queues) {
+        queue->open();
+    }
+    for (std::size_t i = 0; i < queues.size(); ++i) {
+        workers.emplace_back(&BattlePool::workerLoop, this, i);
+    }
+}
+
+void BattlePool::stop() {
+    closed = true;
+    // Закрытые очереди отпускают производителей, ждущих свободного места
+    for (auto& queue : queues) {
+        queue->close();
+    }
+    {
+        std::lock_guard lock(parkMutex);
+        parkCV.notify_all();
+    }
+
+    for (auto& worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+    workers.clear();
+
+    // Необработанные задачи отбрасываются
+    clear();
+    {
+        std::lock_guard lock(idleMutex);
+        idleCV.notify_all();
+    }
+}
+
+bool BattlePool::submit(const BattleTask& task) {
+    // Бои одного защищающегося попадают в одну очередь, чтобы реже
+    // конфликтовать за его блокировку
+    std::size_t index = task.defender
+        ? task.defender->getId() % queues.size()
+        : roundRobin.fetch_add(1, std::memory_order_relaxed) % queues.size();
+
+    inFlight.fetch_add(1, std::memory_order_relaxed);
+    if (!queues[index]->push(task)) {
+        finishTask();
+        return false;
+    }
+    wakeWorker();
+    return true;
+}
+
+void BattlePool::wakeWorker() {
+    // Барьер в паре с fetch_add в nextTask (как в LockFreeQueue)
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (idle.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard lock(parkMutex);
+        parkCV.notify_one();
+    }
+}
+
+void BattlePool::workerLoop(std::size_t index) {
+    BattleTask task;
+    while (nextTask(index, task)) {
+        handler(task);
+        task = BattleTask{};
+        finishTask();
+    }
+}
+
+void BattlePool::finishTask() {
+    if (inFlight.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard lock(idleMutex);
+        idleCV.notify_all();
+    }
+}
+
+void BattlePool::waitIdle() {
+    std::unique_lock lock(idleMutex);
+    idleCV.wait(lock, [this]() {
+        return inFlight.load(std::memory_order_acquire) == 0 ||
+               closed.load(std::memory_order_acquire);
+    });
+}
+
+bool BattlePool::nextTask(std::size_t index, BattleTask& task) {
+    for (;;) {
+        if (closed.load(std::memory_order_acquire)) return false;
+        if (takeTask(index, task)) return true;
+
+        // Работы нет ни у кого - засыпаем до следующего submit
+        std::unique_lock lock(parkMutex);
+        idle.fetch_add(1, std::memory_order_seq_cst);
+        bool got = takeTask(index, task);
+        if (!got && !closed.load(std::memory_order_acquire)) {
+            parkCV.wait(lock);
+        }
+        idle.fetch_sub(1, std::memory_order_relaxed);
+        if (got) return true;
+    }
+}
+
+bool BattlePool::takeTask(std::size_t index, BattleTask& task) {
+    // Сначала своя очередь, затем кража у соседей по кругу
+    for (std::size_t k = 0; k < queues.size(); ++k) {
+        if (queues[(index + k) % queues.size()]->tryPop(task)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::size_t BattlePool::pending() const {
+    std::size_t total = 0;
+    for (const auto& queue : queues) {
+        total += queue->size();
+    }
+    return total;
+}
+
+void BattlePool::clear() {
+    BattleTask task;
+    for (auto& queue : queues) {
+        while (queue->tryPop(task)) {
+            finishTask();
+        }
+    }
+}
+
+std::size_t BattlePool::workerCount() const {
+    return queues.size();
+}
@@ -0,0 +1,308 @@
+#include "binary_snapshot.h"
+#include "factory.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace snapshot {
+
+namespace {
+
+std::uint64_t align8(std::uint64_t value) {
+    return (value + 7) & ~std::uint64_t(7);
+}
+
+// Координаты записи лежат на карте: 0..width-1, 0..height-1
+bool onMap(std::int32_t x, std::int32_t y, std::int32_t width, std::int32_t height) {
+    return x >= 0 && x < width && y >= 0 && y < height;
+}
+
+std::string position(std::int32_t x, std::int32_t y) {
+    return "(" + std::to_string(x) + ", " + std::to_string(y) + ")";
+}
+
+std::string mapSize(std::int32_t width, std::int32_t height) {
+    return std::to_string(width) + "x" + std::to_string(height);
+}
+
+std::runtime_error systemError(const std::string& what, const std::string& path) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+// writev может записать не все сразу - досылаем остаток
+void writeAll(int fd, std::vector<iovec>& parts, const std::string& path) {
+    std::size_t index = 0;
+    while (index < parts.size()) {
+        int batch = static_cast<int>(std::min<std::size_t>(parts.size() - index, IOV_MAX));
+        ssize_t written = ::writev(fd, &parts[index], batch);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            throw systemError("Cannot write snapshot", path);
+        }
+
+        auto left = static_cast<std::size_t>(written);
+        while (index < parts.size() && left >= parts[index].iov_len) {
+            left -= parts[index].iov_len;
+            ++index;
+        }
+        if (left > 0) {
+            parts[index].iov_base = static_cast<char*>(parts[index].iov_base) + left;
+            parts[index].iov_len -= left;
+        }
+    }
+}
+
+} // namespace
+
+void Columns::reserve(std::size_t count) {
+    ids.reserve(count);
+    types.reserve(count);
+    x.reserve(count);
+    y.reserve(count);
+    alive.reserve(count);
+    nameOffsets.reserve(count + 1);
+}
+
+void Columns::add(std::uint32_t id, NpcType type, int px, int py, bool isAlive,
+                  const std::string& name) {
+    ids.push_back(id);
+    types.push_back(static_cast<std::uint8_t>(type));
+    x.push_back(px);
+    y.push_back(py);
+    alive.push_back(isAlive ? 1 : 0);
+    names += name;
+    nameOffsets.push_back(static_cast<std::uint32_t>(names.size()));
+}
+
+std::size_t Columns::size() const {
+    return ids.size();
+}
+
+void write(const std::string& path, const Columns& columns) {
+    const std::size_t count = columns.size();
+    if (columns.types.size() != count || columns.x.size() != count ||
+        columns.y.size() != count || columns.alive.size() != count ||
+        columns.nameOffsets.size() != count + 1 ||
+        columns.nameOffsets.back() != columns.names.size()) {
+        throw std::invalid_argument("Snapshot columns have different sizes");
+    }
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.headerSize = sizeof(Header);
+    header.endianTag = ENDIAN_TAG;
+    header.tick = columns.tick;
+    header.seed = columns.seed;
+    header.mapWidth = columns.mapWidth;
+    header.mapHeight = columns.mapHeight;
+    header.count = count;
+    header.namesSize = columns.names.size();
+
+    // Раскладка: каждая колонка с границы 8 байт
+    std::uint64_t offset = align8(sizeof(Header));
+    auto place = [&](std::uint64_t& field, std::size_t bytes) {
+        field = offset;
+        offset = align8(offset + bytes);
+    };
+    place(header.idsOffset, count * sizeof(std::uint32_t));
+    place(header.typesOffset, count);
+    place(header.xOffset, count * sizeof(std::int32_t));
+    place(header.yOffset, count * sizeof(std::int32_t));
+    place(header.aliveOffset, count);
+    place(header.nameOffsetsOffset, (count + 1) * sizeof(std::uint32_t));
+    place(header.namesOffset, columns.names.size());
+    header.fileSize = offset;
+
+    // Части файла без копирования: заголовок, колонки и выравнивание нулями
+    static const char padding[8] = {};
+    std::vector<iovec> parts;
+    std::uint64_t position = 0;
+    auto append = [&](const void* bytes, std::size_t size, std::uint64_t at) {
+        if (at > position) {
+            parts.push_back({const_cast<char*>(padding), static_cast<std::size_t>(at - position)});
+        }
+        if (size > 0) {
+            parts.push_back({const_cast<void*>(bytes), size});
+        }
+        position = at + size;
+    };
+    append(&header, sizeof(Header), 0);
+    append(columns.ids.data(), count * sizeof(std::uint32_t), header.idsOffset);
+    append(columns.types.data(), count, header.typesOffset);
+    append(columns.x.data(), count * sizeof(std::int32_t), header.xOffset);
+    append(columns.y.data(), count * sizeof(std::int32_t), header.yOffset);
+    append(columns.alive.data(), count, header.aliveOffset);
+    append(columns.nameOffsets.data(), (count + 1) * sizeof(std::uint32_t), header.nameOffsetsOffset);
+    append(columns.names.data(), columns.names.size(), header.namesOffset);
+    append(nullptr, 0, header.fileSize);
+
+    // Пишем во временный файл и переименовываем: прерванная запись
+    // не портит предыдущий снимок
+    std::string temporary = path + ".tmp";
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw systemError("Cannot open snapshot", temporary);
+    }
+    try {
+        writeAll(fd, parts, temporary);
+    } catch (...) {
+        ::close(fd);
+        ::unlink(temporary.c_str());
+        throw;
+    }
+    if (::close(fd) != 0) {
+        ::unlink(temporary.c_str());
+        throw systemError("Cannot write snapshot", temporary);
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        ::unlink(temporary.c_str());
+        throw systemError("Cannot rename snapshot to", path);
+    }
+}
+
+MappedSnapshot::MappedSnapshot(const std::string& path)
+    : data(nullptr), length(0), head(nullptr) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw systemError("Cannot open snapshot", path);
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw systemError("Cannot stat snapshot", path);
+    }
+    length = static_cast<std::size_t>(info.st_size);
+    if (length < sizeof(Header)) {
+        ::close(fd);
+        throw std::runtime_error("Snapshot " + path + " is too short");
+    }
+
+    void* mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        throw systemError("Cannot map snapshot", path);
+    }
+    data = static_cast<const char*>(mapped);
+    head = reinterpret_cast<const Header*>(data);
+
+    // Проверяем заголовок и границы колонок до любого обращения к ним
+    auto fail = [&](const std::string& reason) {
+        ::munmap(const_cast<char*>(data), length);
+        data = nullptr;
+        throw std::runtime_error("Snapshot " + path + ": " + reason);
+    };
+    if (std::memcmp(head->magic, MAGIC, sizeof(MAGIC)) != 0) fail("not a snapshot file");
+    if (head->version != VERSION) fail("unsupported version " + std::to_string(head->version));
+    if (head->endianTag != ENDIAN_TAG) fail("written with a different byte order");
+    if (head->headerSize != sizeof(Header) || head->fileSize > length) fail("truncated file");
+    if (head->mapWidth <= 0 || head->mapHeight <= 0) {
+        fail("bad map size " + mapSize(head->mapWidth, head->mapHeight));
+    }
+
+    const std::uint64_t count = head->count;
+    if (count > length) fail("bad NPC count");
+    auto fits = [&](std::uint64_t offset, std::uint64_t bytes) {
+        return offset % 8 == 0 && offset <= length && bytes <= length - offset;
+    };
+    if (!fits(head->idsOffset, count * sizeof(std::uint32_t)) ||
+        !fits(head->typesOffset, count) ||
+        !fits(head->xOffset, count * sizeof(std::int32_t)) ||
+        !fits(head->yOffset, count * sizeof(std::int32_t)) ||
+        !fits(head->aliveOffset, count) ||
+        !fits(head->nameOffsetsOffset, (count + 1) * sizeof(std::uint32_t)) ||
+        !fits(head->namesOffset, head->namesSize)) {
+        fail("column out of bounds");
+    }
+
+    const std::uint32_t* offsets = column<std::uint32_t>(head->nameOffsetsOffset);
+    if (offsets[0] != 0 || offsets[count] != head->namesSize) fail("bad string table");
+    for (std::uint64_t i = 0; i < count; ++i) {
+        if (offsets[i] > offsets[i + 1]) fail("bad string table");
+    }
+
+    // Игра раскладывает NPC по ячейкам карты без проверок
+    const std::int32_t* xs = column<std::int32_t>(head->xOffset);
+    const std::int32_t* ys = column<std::int32_t>(head->yOffset);
+    for (std::uint64_t i = 0; i < count; ++i) {
+        if (!onMap(xs[i], ys[i], head->mapWidth, head->mapHeight)) {
+            fail("record " + std::to_string(i) + " at " + position(xs[i], ys[i]) +
+                 " is outside the " + mapSize(head->mapWidth, head->mapHeight) + " map");
+        }
+    }
+}
+
+MappedSnapshot::~MappedSnapshot() {
+    if (data) {
+        ::munmap(const_cast<char*>(data), length);
+    }
+}
+
+MappedSnapshot::MappedSnapshot(MappedSnapshot&& other) noexcept
+    : data(other.data), length(other.length), head(other.head) {
+    other.data = nullptr;
+    other.length = 0;
+    other.head = nullptr;
+}
+
+std::string_view MappedSnapshot::name(std::size_t i) const {
+    const std::uint32_t* offsets = column<std::uint32_t>(head->nameOffsetsOffset);
+    const char* names = data + head->namesOffset;
+    return std::string_view(names + offsets[i], offsets[i + 1] - offsets[i]);
+}
+
+std::size_t convertText(std::istream& text, const std::string& binaryPath,
+                        int mapWidth, int mapHeight) {
+    std::string content((std::istreambuf_iterator<char>(text)), std::istreambuf_iterator<char>());
+
+    // Необязательная строка количества, за которой идет пустая строка
+    std::size_t start = 0;
+    std::size_t firstEnd = content.find('\n');
+    if (firstEnd != std::string::npos) {
+        std::string first = content.substr(0, firstEnd);
+        std::size_t secondEnd = content.find('\n', firstEnd + 1);
+        std::string second = content.substr(firstEnd + 1,
+            secondEnd == std::string::npos ? std::string::npos : secondEnd - firstEnd - 1);
+        bool blankSecond = second.find_first_not_of(" \t\r") == std::string::npos;
+        bool numericFirst = !first.empty() &&
+            first.find_first_not_of("0123456789 \t\r") == std::string::npos;
+        if (numericFirst && blankSecond && secondEnd != std::string::npos) {
+            start = secondEnd + 1;
+        }
+    }
+
+    std::istringstream records(content.substr(start));
+    Columns columns;
+    columns.mapWidth = mapWidth;
+    columns.mapHeight = mapHeight;
+
+    std::uint32_t id = 0;
+    while (records >> std::ws, !records.eof()) {
+        auto npc = NPCFactory::loadNPC(records);
+        if (!npc) {
+            throw std::runtime_error("Cannot convert NPC record #" + std::to_string(id + 1));
+        }
+        if (!onMap(npc->getX(), npc->getY(), mapWidth, mapHeight)) {
+            throw std::runtime_error("Cannot convert NPC record #" + std::to_string(id + 1) +
+                                     " (" + npc->getName() + "): " +
+                                     position(npc->getX(), npc->getY()) + " is outside the " +
+                                     mapSize(mapWidth, mapHeight) + " map");
+        }
+        columns.add(id++, npc->getType(), npc->getX(), npc->getY(), npc->isAlive(), npc->getName());
+    }
+
+    write(binaryPath, columns);
+    return columns.size();
+}
+
+} // namespace snapshot
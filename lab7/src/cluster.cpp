@@ -0,0 +1,562 @@
+#include "cluster.h"
+#include "factory.h"
+#include "fight_rules.h"
+#include "philox.h"
+#include "proximity.h"
+#include "spatial_grid.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <csignal>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace cluster {
+
+namespace {
+
+constexpr std::size_t CACHE_LINE = 64;
+
+std::size_t alignUp(std::size_t bytes) {
+    return (bytes + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+}
+
+// Блок управления в начале сегмента
+struct Control {
+    shm::Barrier barrier;                // координатор и все регионы
+    std::atomic<std::uint32_t> tick;     // такт, который начинают регионы
+    std::atomic<std::uint32_t> stop;     // тактов больше не будет
+    std::atomic<std::uint32_t> failed;   // прогон прерван
+};
+
+// Итог региона после последнего такта, по строке кэша на регион
+struct alignas(CACHE_LINE) RegionReport {
+    std::atomic<std::uint64_t> alive;
+};
+
+// Раскладка сегмента: блок управления, итоги регионов, кольца
+// регион -> регион и регион -> координатор. Размечается координатором
+// до fork(), поэтому у потомков те же адреса и виды колец.
+struct Shared {
+    Control* control = nullptr;
+    RegionReport* reports = nullptr;
+    std::vector<shm::Ring> peers;    // [from * regions + to]
+    std::vector<shm::Ring> results;  // [region]
+    std::size_t regions = 0;
+
+    static std::size_t bytes(std::size_t regions, std::size_t capacity) {
+        return alignUp(sizeof(Control)) + regions * sizeof(RegionReport) +
+               (regions * regions + regions) * alignUp(shm::Ring::bytes(capacity));
+    }
+
+    Shared(void* memory, std::size_t regionCount, std::size_t capacity) : regions(regionCount) {
+        char* pos = static_cast<char*>(memory);
+        control = new (pos) Control;
+        control->barrier.init(static_cast<std::uint32_t>(regions + 1));
+        control->tick.store(0, std::memory_order_relaxed);
+        control->stop.store(0, std::memory_order_relaxed);
+        control->failed.store(0, std::memory_order_relaxed);
+        pos += alignUp(sizeof(Control));
+
+        reports = new (pos) RegionReport[regions];
+        for (std::size_t r = 0; r < regions; ++r) {
+            reports[r].alive.store(0, std::memory_order_relaxed);
+        }
+        pos += regions * sizeof(RegionReport);
+
+        std::size_t ringBytes = alignUp(shm::Ring::bytes(capacity));
+        for (std::size_t i = 0; i < regions * regions; ++i, pos += ringBytes) {
+            peers.push_back(shm::Ring::create(pos, capacity));
+        }
+        for (std::size_t i = 0; i < regions; ++i, pos += ringBytes) {
+            results.push_back(shm::Ring::create(pos, capacity));
+        }
+    }
+
+    shm::Ring& peer(std::size_t from, std::size_t to) { return peers[from * regions + to]; }
+};
+
+// Прогон прерван: другой процесс упал или координатор остановил всех
+struct Aborted {};
+
+// NPC в памяти региона: свой или призрак соседа
+struct Body {
+    std::uint32_t id;
+    NpcType type;
+    int x;
+    int y;
+    bool alive;
+};
+
+struct Candidate {
+    std::uint32_t defender;  // id
+    std::uint32_t attacker;  // id
+    std::uint32_t local;     // строка защищающегося в bodies
+};
+
+// Процесс одной полосы карты по y: свои NPC, их ходы и бои, где они защищаются
+class RegionWorker {
+public:
+    RegionWorker(const GameConfig& config, std::uint64_t seed, Shared& shared, std::size_t region)
+        : config(config), key(philox::keyFromSeed(seed)), seed(seed), shared(shared),
+          region(region), regions(shared.regions), outgoing(shared.regions) {
+        for (std::size_t r = 0; r <= regions; ++r) {
+            bounds.push_back(static_cast<int>(static_cast<long long>(config.mapHeight) * r / regions));
+        }
+        ownerOfY.resize(static_cast<std::size_t>(config.mapHeight));
+        for (std::size_t r = 0; r < regions; ++r) {
+            std::fill(ownerOfY.begin() + bounds[r], ownerOfY.begin() + bounds[r + 1],
+                      static_cast<std::uint32_t>(r));
+        }
+
+        // Дистанции берутся у самих классов NPC, как и в Game
+        margin = 1;
+        for (NpcType type : {NpcType::Dragon, NpcType::Knight, NpcType::Pegasus}) {
+            auto probe = NPCFactory::createNPC(type);
+            moveDistance[fight_rules::index(type)] = probe->getMoveDistance();
+            killDistance[fight_rules::index(type)] = probe->getKillDistance();
+            margin = std::max(margin, probe->getKillDistance());
+        }
+
+        // Сетки покрывают полосу и призраков: ячейка не меньше дистанции убийства
+        int first = std::max(0, bounds[region] - margin) / margin;
+        int last = std::min(config.mapHeight - 1, bounds[region + 1] - 1 + margin) / margin;
+        for (auto& grid : grids) {
+            grid = SpatialGrid(config.mapWidth, config.mapHeight, margin, first, last + 1);
+        }
+    }
+
+    void run() {
+        spawn();
+        auto poll = [this]() { return !aborted(); };
+        for (;;) {
+            if (!shared.control->barrier.arriveAndWait(poll)) throw Aborted();
+            if (shared.control->stop.load(std::memory_order_acquire)) break;
+            step(shared.control->tick.load(std::memory_order_acquire));
+            if (!shared.control->barrier.arriveAndWait(poll)) throw Aborted();
+        }
+
+        std::uint64_t alive = 0;
+        for (const Body& body : bodies) {
+            alive += body.alive ? 1 : 0;
+        }
+        shared.reports[region].alive.store(alive, std::memory_order_relaxed);
+        if (!shared.control->barrier.arriveAndWait(poll)) throw Aborted();
+    }
+
+private:
+    const GameConfig& config;
+    philox::Key key;
+    std::uint64_t seed;
+    Shared& shared;
+    std::size_t region;
+    std::size_t regions;
+
+    std::vector<int> bounds;                // полоса региона r: [bounds[r], bounds[r + 1])
+    std::vector<std::uint32_t> ownerOfY;    // регион-владелец строки карты
+    std::array<int, fight_rules::TYPE_COUNT> moveDistance{};
+    std::array<int, fight_rules::TYPE_COUNT> killDistance{};
+    int margin;                             // ширина полосы призраков
+
+    // Свои NPC, на время поиска боев за ними - призраки соседей
+    std::vector<Body> bodies;
+    std::size_t ownCount = 0;
+    std::array<SpatialGrid, fight_rules::TYPE_COUNT> grids;
+    std::vector<std::vector<shm::Message>> outgoing;  // по региону-получателю
+    std::vector<shm::Message> incoming;
+    std::vector<Candidate> candidates;
+    std::unordered_map<std::uint32_t, std::uint32_t> localOf;
+
+    bool aborted() const {
+        return shared.control->failed.load(std::memory_order_acquire) != 0;
+    }
+
+    // Мир создается из seed целиком, регион оставляет себе только свою полосу
+    void spawn() {
+        std::uint32_t width = static_cast<std::uint32_t>(config.mapWidth);
+        std::uint32_t height = static_cast<std::uint32_t>(config.mapHeight);
+        for (std::uint32_t id = 0; id < static_cast<std::uint32_t>(config.npcCount); ++id) {
+            philox::Counter r = philox::generate({id, 0, 0, philox::Spawn}, key);
+            NpcType type = static_cast<NpcType>(philox::uniform(r[0], 3) + 1);
+            int x = static_cast<int>(philox::uniform(r[1], width));
+            int y = static_cast<int>(philox::uniform(r[2], height));
+            if (ownerOfY[y] == region) {
+                bodies.push_back({id, type, x, y, true});
+            }
+        }
+    }
+
+    void step(std::uint32_t tick) {
+        move(tick);
+        exchange();
+        for (const shm::Message& m : incoming) {
+            bodies.push_back({m.id, static_cast<NpcType>(m.type), m.x, m.y, true});
+        }
+        ownCount = bodies.size();
+
+        sendGhosts();
+        exchange();
+        for (const shm::Message& m : incoming) {
+            bodies.push_back({m.id, static_cast<NpcType>(m.type), m.x, m.y, true});
+        }
+
+        detectFights();
+        bodies.resize(ownCount);
+        exchange();
+        acceptAttacks();
+        resolveFights(tick);
+    }
+
+    // Убитые на прошлом такте уходят, живые делают шаг. Ушедшие в чужую
+    // полосу отправляются ее владельцу
+    void move(std::uint32_t tick) {
+        for (std::size_t k = 0; k < bodies.size();) {
+            Body& body = bodies[k];
+            if (!body.alive) {
+                body = bodies.back();
+                bodies.pop_back();
+                continue;
+            }
+            philox::Counter r = philox::generate({tick, body.id, 0, philox::Move}, key);
+            int dx = static_cast<int>(philox::uniform(r[0], 3)) - 1;
+            int dy = static_cast<int>(philox::uniform(r[1], 3)) - 1;
+            int step = moveDistance[fight_rules::index(body.type)];
+            body.x = std::max(0, std::min(config.mapWidth - 1, body.x + dx * step));
+            body.y = std::max(0, std::min(config.mapHeight - 1, body.y + dy * step));
+
+            std::uint32_t owner = ownerOfY[body.y];
+            if (owner != region) {
+                outgoing[owner].push_back(message(shm::Message::Migrant, body));
+                body = bodies.back();
+                bodies.pop_back();
+                continue;
+            }
+            ++k;
+        }
+    }
+
+    // Копии NPC, до которых может дотянуться атакующий из чужой полосы
+    void sendGhosts() {
+        for (std::size_t k = 0; k < ownCount; ++k) {
+            const Body& body = bodies[k];
+            for (std::size_t r = 0; r < regions; ++r) {
+                if (r != region && body.y >= bounds[r] - margin && body.y < bounds[r + 1] + margin) {
+                    outgoing[r].push_back(message(shm::Message::Ghost, body));
+                }
+            }
+        }
+    }
+
+    // Как Game::detectFights: атакующий смотрит сетки типов, которых может
+    // убить, дистанция проверяется блоками. Бой со своим защищающимся
+    // разрешается здесь, с чужим - заявкой его владельцу
+    void detectFights() {
+        for (auto& grid : grids) {
+            grid.clear();
+        }
+        for (std::size_t k = 0; k < bodies.size(); ++k) {
+            grids[fight_rules::index(bodies[k].type)].insert(
+                static_cast<std::uint32_t>(k), bodies[k].x, bodies[k].y);
+        }
+        candidates.clear();
+
+        for (std::size_t k = 0; k < ownCount; ++k) {
+            const Body& attacker = bodies[k];
+            if (!fight_rules::canAttack(attacker.type)) continue;
+
+            int killDist = killDistance[fight_rules::index(attacker.type)];
+            std::uint32_t found[proximity::BLOCK_SIZE];
+            int foundX[proximity::BLOCK_SIZE];
+            int foundY[proximity::BLOCK_SIZE];
+            std::size_t blockSize = 0;
+
+            auto flush = [&]() {
+                std::uint64_t mask = proximity::withinRadius(attacker.x, attacker.y, killDist,
+                                                             foundX, foundY, blockSize);
+                blockSize = 0;
+                proximity::forEachBit(mask, [&](std::size_t i) {
+                    std::uint32_t local = found[i];
+                    const Body& defender = bodies[local];
+                    if (local < ownCount) {
+                        candidates.push_back({defender.id, attacker.id, local});
+                    } else {
+                        shm::Message request;
+                        request.kind = shm::Message::Attack;
+                        request.id = attacker.id;
+                        request.other = defender.id;
+                        outgoing[ownerOfY[defender.y]].push_back(request);
+                    }
+                });
+            };
+            auto collect = [&](const std::uint32_t* ids, std::size_t count) {
+                for (std::size_t i = 0; i < count; ++i) {
+                    found[blockSize] = ids[i];
+                    foundX[blockSize] = bodies[ids[i]].x;
+                    foundY[blockSize] = bodies[ids[i]].y;
+                    if (++blockSize == proximity::BLOCK_SIZE) flush();
+                }
+            };
+            for (std::size_t target = 0; target < fight_rules::TYPE_COUNT; ++target) {
+                if (fight_rules::KILLS[fight_rules::index(attacker.type)][target]) {
+                    grids[target].forEachCellNear(attacker.x, attacker.y, killDist, collect);
+                }
+            }
+            if (blockSize > 0) flush();
+        }
+    }
+
+    void acceptAttacks() {
+        if (incoming.empty()) return;
+        localOf.clear();
+        for (std::size_t k = 0; k < bodies.size(); ++k) {
+            localOf.emplace(bodies[k].id, static_cast<std::uint32_t>(k));
+        }
+        for (const shm::Message& m : incoming) {
+            auto it = localOf.find(m.other);
+            if (it == localOf.end()) {
+                throw std::runtime_error("Attack on NPC " + std::to_string(m.other) +
+                                         " outside region " + std::to_string(region));
+            }
+            candidates.push_back({m.other, m.id, it->second});
+        }
+    }
+
+    // Порядок и выбор атакующего те же, что в Game::submitBattleBatch,
+    // бросок и исход - как в Game::resolveBattle
+    void resolveFights(std::uint32_t tick) {
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+            return a.defender != b.defender ? a.defender < b.defender : a.attacker < b.attacker;
+        });
+        for (std::size_t begin = 0; begin < candidates.size();) {
+            std::uint32_t defender = candidates[begin].defender;
+            std::size_t end = begin + 1;
+            while (end < candidates.size() && candidates[end].defender == defender) ++end;
+
+            philox::Counter r = philox::generate({tick, defender, 0, philox::Target}, key);
+            const Candidate& chosen =
+                candidates[begin + philox::uniform(r[0], static_cast<std::uint32_t>(end - begin))];
+            int attack = philox::rollDie(seed, tick, chosen.attacker, defender, philox::Attack);
+            int defense = philox::rollDie(seed, tick, defender, chosen.attacker, philox::Defense);
+            bool killed = attack > defense;
+            if (killed) bodies[chosen.local].alive = false;
+
+            shm::Message result;
+            result.kind = shm::Message::Fight;
+            result.id = chosen.attacker;
+            result.other = defender;
+            result.type = killed ? 1 : 0;
+            result.x = static_cast<std::int32_t>(tick);
+            push(shared.results[region], result, [] {});
+            begin = end;
+        }
+    }
+
+    static shm::Message message(shm::Message::Kind kind, const Body& body) {
+        shm::Message m;
+        m.kind = kind;
+        m.id = body.id;
+        m.type = static_cast<std::uint32_t>(body.type);
+        m.x = body.x;
+        m.y = body.y;
+        return m;
+    }
+
+    // Пока кольцо полно, ждем; drain() разбирает входящие, чтобы соседи,
+    // пишущие нам, тоже не стояли
+    template<typename Drain>
+    void push(shm::Ring& ring, const shm::Message& m, Drain&& drain) {
+        unsigned spins = 0;
+        while (!ring.tryPush(m)) {
+            drain();
+            if (aborted()) throw Aborted();
+            shm::backoff(spins);
+        }
+    }
+
+    // Обмен фазы: каждому соседу свои сообщения и End, от каждого соседа -
+    // все до его End. Кольца FIFO, поэтому сообщения следующей фазы,
+    // пришедшие раньше, остаются в кольце до следующего обмена
+    void exchange() {
+        incoming.clear();
+        std::vector<bool> ended(regions, false);
+        ended[region] = true;
+        std::size_t waiting = regions - 1;
+
+        auto drain = [&]() {
+            for (std::size_t from = 0; from < regions; ++from) {
+                if (ended[from]) continue;
+                shm::Ring& ring = shared.peer(from, region);
+                shm::Message m;
+                while (ring.tryPop(m)) {
+                    if (m.kind == shm::Message::End) {
+                        ended[from] = true;
+                        --waiting;
+                        break;
+                    }
+                    incoming.push_back(m);
+                }
+            }
+        };
+
+        for (std::size_t to = 0; to < regions; ++to) {
+            if (to == region) continue;
+            shm::Ring& ring = shared.peer(region, to);
+            for (const shm::Message& m : outgoing[to]) {
+                push(ring, m, drain);
+            }
+            push(ring, shm::Message(), drain);
+            outgoing[to].clear();
+        }
+
+        unsigned spins = 0;
+        for (;;) {
+            drain();
+            if (waiting == 0) break;
+            if (aborted()) throw Aborted();
+            shm::backoff(spins);
+        }
+    }
+};
+
+} // namespace
+
+Coordinator::Coordinator(const GameConfig& gameConfig, const Options& clusterOptions)
+    : config(gameConfig), options(clusterOptions), seed(gameConfig.seed) {
+    config.validate();
+    if (options.processes < 1 || options.processes > static_cast<std::size_t>(config.mapHeight)) {
+        throw std::invalid_argument("Process count must be in [1, map height]");
+    }
+    if (options.ringCapacity < 1 || options.ringCapacity > UINT32_MAX) {
+        throw std::invalid_argument("Ring capacity must be positive");
+    }
+    if (seed == 0) {
+        std::random_device rd;
+        seed = (static_cast<std::uint64_t>(rd()) << 32) | rd();
+    }
+}
+
+Coordinator::~Coordinator() {
+    stopChildren();
+}
+
+void Coordinator::stopChildren() {
+    for (pid_t child : children) {
+        ::kill(child, SIGKILL);
+        ::waitpid(child, nullptr, 0);
+    }
+    children.clear();
+}
+
+SimulationStats Coordinator::run() {
+    SimulationStats stats;
+    std::size_t regions = options.processes;
+    shm::Segment segment(Shared::bytes(regions, options.ringCapacity));
+    Shared shared(segment.get(), regions, options.ringCapacity);
+    pid_t parent = ::getpid();
+
+    fights = Recording();
+    fights.seed = seed;
+    fights.mapWidth = config.mapWidth;
+    fights.mapHeight = config.mapHeight;
+    fights.npcCount = config.npcCount;
+
+    for (std::size_t r = 0; r < regions; ++r) {
+        pid_t pid = ::fork();
+        if (pid < 0) {
+            shared.control->failed.store(1, std::memory_order_release);
+            stopChildren();
+            throw std::runtime_error("Cannot start region process");
+        }
+        if (pid == 0) {
+            // Потомок не возвращается в код вызывающего: только _exit
+            ::prctl(PR_SET_PDEATHSIG, SIGKILL);
+            int status = 0;
+            if (::getppid() != parent) ::_exit(1);
+            try {
+                RegionWorker(config, seed, shared, r).run();
+            } catch (const Aborted&) {
+                status = 1;
+            } catch (const std::exception& e) {
+                std::cerr << "Region " << r << " failed: " << e.what() << std::endl;
+                shared.control->failed.store(1, std::memory_order_release);
+                status = 1;
+            }
+            ::_exit(status);
+        }
+        children.push_back(pid);
+    }
+
+    // Ожидая барьер, координатор разбирает итоги боев и следит, живы ли регионы
+    auto drain = [&]() {
+        shm::Message m;
+        for (auto& ring : shared.results) {
+            while (ring.tryPop(m)) {
+                fights.fights.push_back({static_cast<std::uint32_t>(m.x), m.id, m.other, m.type != 0});
+                ++stats.fights;
+                if (m.type != 0) ++stats.kills;
+            }
+        }
+    };
+    unsigned polls = 0;
+    auto poll = [&]() {
+        drain();
+        if (shared.control->failed.load(std::memory_order_acquire) != 0) return false;
+        if (++polls % 64 == 0) {
+            for (pid_t child : children) {
+                if (::waitpid(child, nullptr, WNOHANG) != 0) return false;
+            }
+        }
+        return true;
+    };
+    auto wait = [&]() {
+        if (!shared.control->barrier.arriveAndWait(poll)) {
+            shared.control->failed.store(1, std::memory_order_release);
+            stopChildren();
+            throw std::runtime_error("Region process failed");
+        }
+    };
+
+    auto startTime = std::chrono::steady_clock::now();
+    long long limit = config.tickLimit();
+    for (long long tick = 0; tick < limit; ++tick) {
+        shared.control->tick.store(static_cast<std::uint32_t>(tick), std::memory_order_release);
+        wait();  // регионы начинают такт
+        wait();  // регионы закончили такт, итоги боев в кольцах
+        drain();
+        ++stats.ticks;
+    }
+    shared.control->stop.store(1, std::memory_order_release);
+    wait();
+    wait();  // регионы записали число живых
+    stats.seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - startTime).count();
+
+    for (std::size_t r = 0; r < regions; ++r) {
+        stats.survivors += shared.reports[r].alive.load(std::memory_order_relaxed);
+    }
+    for (pid_t child : children) {
+        int status = 0;
+        ::waitpid(child, &status, 0);
+    }
+    children.clear();
+
+    fights.ticks = stats.ticks;
+    fights.sortFights();
+    return stats;
+}
+
+Recording Coordinator::recording() const {
+    return fights;
+}
+
+std::uint64_t Coordinator::getSeed() const {
+    return seed;
+}
+
+} // namespace cluster
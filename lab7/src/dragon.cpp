@@ -23,7 +23,7 @@ bool Dragon::accept(const std::shared_ptr<IFightVisitor>& visitor,
 }
 
 void Dragon::print(std::ostream& os) const {
-    os << "Dragon '" << name << "' at (" << x << ", " << y << ")";
+    os << "Dragon '" << nameRef() << "' at (" << posX() << ", " << posY() << ")";
 }
 
 void Dragon::save(std::ostream& os) const {
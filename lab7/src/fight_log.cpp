@@ -0,0 +1,229 @@
+#include "fight_log.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+
+FightEvent FightEvent::make(const NPC& attacker, const NPC& defender, bool win) {
+    FightEvent event;
+    event.attackerType = attacker.getType();
+    event.defenderType = defender.getType();
+    event.attackerX = attacker.getX();
+    event.attackerY = attacker.getY();
+    event.defenderX = defender.getX();
+    event.defenderY = defender.getY();
+    event.win = win;
+
+    std::string attackerName = attacker.getName();
+    std::string defenderName = defender.getName();
+    std::strncpy(event.attackerName, attackerName.c_str(), NAME_SIZE - 1);
+    std::strncpy(event.defenderName, defenderName.c_str(), NAME_SIZE - 1);
+    return event;
+}
+
+std::mutex& consoleMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+void writeConsole(const std::string& text) {
+    std::lock_guard lock(consoleMutex());
+    std::cout << text << std::flush;
+}
+
+FightLog::FightLog(std::chrono::milliseconds flushInterval, std::size_t capacity)
+    : flushInterval(flushInterval), queue(capacity), droppedCount(0), pushed(0),
+      written(0), finished(false), flushRequested(false) {
+    sinks.push_back({writeConsole, std::string()});
+    worker = std::thread(&FightLog::run, this);
+}
+
+FightLog::~FightLog() {
+    stop();
+}
+
+std::uint32_t FightLog::addSink(Writer writer) {
+    std::lock_guard lock(channelMutex);
+    sinks.push_back({std::move(writer), std::string()});
+    return static_cast<std::uint32_t>(sinks.size() - 1);
+}
+
+std::uint32_t FightLog::addChannel(Formatter formatter, std::uint32_t sink) {
+    std::lock_guard lock(channelMutex);
+    channels.push_back({formatter, sink});
+    return static_cast<std::uint32_t>(channels.size() - 1);
+}
+
+bool FightLog::push(const FightEvent& event) {
+    if (queue.isClosed() || !queue.tryPush(event)) {
+        ++droppedCount;
+        return false;
+    }
+    pushed.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+void FightLog::flush() {
+    std::size_t target = pushed.load(std::memory_order_acquire);
+    flushRequested = true;
+    std::unique_lock lock(channelMutex);
+    writtenCV.wait(lock, [&]() { return written >= target || finished; });
+}
+
+void FightLog::stop() {
+    if (!worker.joinable()) return;
+    queue.close();
+    worker.join();
+}
+
+std::size_t FightLog::dropped() const {
+    return droppedCount;
+}
+
+std::chrono::milliseconds FightLog::getFlushInterval() const {
+    return flushInterval;
+}
+
+void FightLog::run() {
+    std::vector<FightEvent> batch;
+    batch.reserve(256);
+    std::size_t formatted = 0;
+    std::size_t buffered = 0;
+    auto nextFlush = std::chrono::steady_clock::now() + flushInterval;
+
+    for (;;) {
+        auto now = std::chrono::steady_clock::now();
+        auto wait = std::max(nextFlush - now, std::chrono::steady_clock::duration::zero());
+        // Короткий сон, если кто-то ждет flush()
+        if (flushRequested) wait = std::min<std::chrono::steady_clock::duration>(
+            wait, std::chrono::milliseconds(1));
+
+        FightEvent event;
+        bool got = queue.waitPopFor(event, wait);
+        if (got) {
+            batch.push_back(event);
+            while (batch.size() < batch.capacity() && queue.tryPop(event)) {
+                batch.push_back(event);
+            }
+        }
+
+        std::lock_guard lock(channelMutex);
+        if (!batch.empty()) {
+            buffered = format(batch);
+            formatted += batch.size();
+            batch.clear();
+        }
+
+        now = std::chrono::steady_clock::now();
+        bool due = now >= nextFlush || buffered >= BATCH_BYTES ||
+                   (queue.empty() && flushRequested.exchange(false));
+        if (due) {
+            writeAll(formatted);
+            formatted = 0;
+            buffered = 0;
+            nextFlush = now + flushInterval;
+        }
+
+        if (!got && queue.isClosed()) break;
+    }
+
+    // Очередь закрыта: дописываем то, что успели положить
+    std::lock_guard lock(channelMutex);
+    FightEvent event;
+    while (queue.tryPop(event)) {
+        batch.push_back(event);
+    }
+    format(batch);
+    writeAll(formatted + batch.size());
+    finished = true;
+    writtenCV.notify_all();
+}
+
+std::size_t FightLog::format(const std::vector<FightEvent>& batch) {
+    for (const auto& event : batch) {
+        if (event.channel >= channels.size()) continue;
+        const Channel& channel = channels[event.channel];
+        channel.formatter(event, sinks[channel.sink].buffer);
+    }
+
+    std::size_t total = 0;
+    for (const auto& sink : sinks) {
+        total += sink.buffer.size();
+    }
+    return total;
+}
+
+void FightLog::writeAll(std::size_t events) {
+    for (auto& sink : sinks) {
+        if (!sink.buffer.empty()) {
+            sink.writer(sink.buffer);
+            sink.buffer.clear();
+        }
+    }
+    written += events;
+    writtenCV.notify_all();
+}
+
+namespace fight_format {
+
+namespace {
+
+const char* typeName(NpcType type) {
+    switch (type) {
+        case NpcType::Dragon: return "Dragon";
+        case NpcType::Knight: return "Knight";
+        case NpcType::Pegasus: return "Pegasus";
+        default: return "Unknown";
+    }
+}
+
+void appendInt(std::string& out, int value) {
+    char digits[16];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+// Так же, как NPC::print: Dragon 'name' at (x, y)
+void appendNpc(std::string& out, NpcType type, const char* name, int x, int y) {
+    out += typeName(type);
+    out += " '";
+    out += name;
+    out += "' at (";
+    appendInt(out, x);
+    out += ", ";
+    appendInt(out, y);
+    out += ")";
+}
+
+} // namespace
+
+void console(const FightEvent& event, std::string& out) {
+    if (!event.win) return;
+    out += "\nBATTLE RESULT\nAttacker: ";
+    appendNpc(out, event.attackerType, event.attackerName, event.attackerX, event.attackerY);
+    out += "\nDefender: ";
+    appendNpc(out, event.defenderType, event.defenderName, event.defenderX, event.defenderY);
+    out += " was killed!\n\n\n";
+}
+
+void file(const FightEvent& event, std::string& out) {
+    if (!event.win) return;
+    out += "Battle: ";
+    appendNpc(out, event.attackerType, event.attackerName, event.attackerX, event.attackerY);
+    out += " killed ";
+    appendNpc(out, event.defenderType, event.defenderName, event.defenderX, event.defenderY);
+    out += "\n";
+}
+
+void battle(const FightEvent& event, std::string& out) {
+    out += event.attackerName;
+    out += event.win ? " killed " : " failed to kill ";
+    out += event.defenderName;
+    out += " (Attack: ";
+    appendInt(out, event.attackPower);
+    out += " vs Defense: ";
+    appendInt(out, event.defensePower);
+    out += ")\n";
+}
+
+} // namespace fight_format
@@ -1,49 +1,138 @@
 #include "game.h"
 #include "factory.h"
-#include "visitor.h"
 #include "observer.h"
+#include "philox.h"
+#include "proximity.h"
+#include "binary_snapshot.h"
+#include "shard_balance.h"
 #include <iostream>
 #include <chrono>
 #include <random>
 #include <algorithm>
 #include <sstream>
+#include <stdexcept>
+#include <time.h>
+#include <unistd.h>
 
-std::mutex Game::coutMutex;
+std::mutex& Game::coutMutex = consoleMutex();
 
-Game::Game() : running(false) {
-    auto consoleObserver = std::make_shared<ConsoleObserver>();
-    auto fileObserver = std::make_shared<FileObserver>("game_log.txt");
+namespace {
+
+// Процессорное время текущего потока: не растет, пока поток вытеснен
+std::uint64_t threadCpuNanos() {
+    timespec now;
+    ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return static_cast<std::uint64_t>(now.tv_sec) * 1000000000ull +
+           static_cast<std::uint64_t>(now.tv_nsec);
+}
+
+} // namespace
+
+void GameConfig::validate() const {
+    // Размер ограничен, чтобы сетка соседей оставалась разумного размера
+    if (mapWidth < 1 || mapWidth > MAX_MAP_SIZE || mapHeight < 1 || mapHeight > MAX_MAP_SIZE) {
+        throw std::invalid_argument("Map size must be in [1, " +
+                                    std::to_string(MAX_MAP_SIZE) + "]");
+    }
+    if (npcCount < 0) {
+        throw std::invalid_argument("NPC count must not be negative");
+    }
+    if (viewColumns < 1 || viewColumns > MapRenderer::MAX_VIEW_SIZE ||
+        viewRows < 1 || viewRows > MapRenderer::MAX_VIEW_SIZE) {
+        throw std::invalid_argument("Map view size must be in [1, " +
+                                    std::to_string(MapRenderer::MAX_VIEW_SIZE) + "]");
+    }
+    if (rebalanceTicks < 0) {
+        throw std::invalid_argument("Rebalance window must not be negative");
+    }
+    if (metricsMillis <= 0) {
+        throw std::invalid_argument("Metrics interval must be positive");
+    }
+    if (duration < 0 || tickMillis <= 0 || maxTicks < 0 || logFlushMillis <= 0) {
+        throw std::invalid_argument("Duration and tick length must be positive");
+    }
+}
+
+long long GameConfig::tickLimit() const {
+    if (maxTicks > 0) return maxTicks;
+    return static_cast<long long>(duration) * 1000 / tickMillis;
+}
+
+Game::Game(const GameConfig& gameConfig)
+    : config(gameConfig), world(gameConfig.mapWidth, gameConfig.mapHeight), running(false),
+      battlePool(gameConfig.battleWorkers, BATTLE_QUEUE_CAPACITY), nextId(0),
+      masterSeed(gameConfig.seed), currentTick(0),
+      gridCellSize(1), ticksSinceBalance(0),
+      fightCount(0), killCount(0), settledTicks(0),
+      tickStartNanos(0), battleStartNanos(0), tickStartAllocations(0) {
+    config.validate();
+    for (auto& count : aliveByType) {
+        count = 0;
+    }
+    if (masterSeed == 0) {
+        std::random_device rd;
+        masterSeed = (static_cast<std::uint64_t>(rd()) << 32) | rd();
+    }
+    fightLog = std::make_shared<FightLog>(std::chrono::milliseconds(config.logFlushMillis));
+    battleChannel = fightLog->addChannel(fight_format::battle, FightLog::CONSOLE_SINK);
+    
+    // В ускоренном режиме бои не печатаются в консоль
+    observers = std::make_shared<ObserverRegistry>();
+    if (!config.headless) {
+        observers->subscribe(std::make_shared<ConsoleObserver>(fightLog));
+    }
+    observers->subscribe(std::make_shared<FileObserver>("game_log.txt", fightLog));
+    // Реестр общий для всех NPC мира и переживает world.clear()
+    world.setObserverRegistry(observers);
+    
+    if (!config.journalPath.empty()) {
+        journal = std::make_unique<Journal>(config.journalPath);
+    }
+    if (!config.metricsPath.empty()) {
+        metricsExporter = std::make_unique<metrics::Exporter>(
+            config.metricsPath, std::chrono::milliseconds(config.metricsMillis));
+    }
 }
 
 Game::~Game() {
     stop();
 }
 
+void Game::initialize() {
+    initialize(config.npcCount);
+}
+
 void Game::initialize(int npcCount) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> typeDist(1, 3);
-    std::uniform_int_distribution<> coordDist(0, 499);
-    
-    auto consoleObserver = std::make_shared<ConsoleObserver>();
-    auto fileObserver = std::make_shared<FileObserver>("game_log.txt");
+    // Тип и позиция - функция от (seed, id): тот же seed дает тот же мир
+    philox::Key key = philox::keyFromSeed(masterSeed);
+    std::uint32_t width = static_cast<std::uint32_t>(config.mapWidth);
+    std::uint32_t height = static_cast<std::uint32_t>(config.mapHeight);
     
+    world.reserve(npcs.size() + static_cast<std::size_t>(std::max(0, npcCount)));
     for (int i = 0; i < npcCount; ++i) {
-        NpcType type = static_cast<NpcType>(typeDist(gen));
-        int x = coordDist(gen);
-        int y = coordDist(gen);
+        philox::Counter r = philox::generate({nextId, 0, 0, philox::Spawn}, key);
+        NpcType type = static_cast<NpcType>(philox::uniform(r[0], 3) + 1);
+        int x = static_cast<int>(philox::uniform(r[1], width));
+        int y = static_cast<int>(philox::uniform(r[2], height));
         
         std::string name = NPCFactory::getStringFromType(type) + 
                           "_" + std::to_string(i+1);
         
         auto npc = NPCFactory::createNPC(type, x, y, name);
         if (npc) {
-            npc->subscribe(consoleObserver);
-            npc->subscribe(fileObserver);
+            npc->setId(nextId++);
+            npc->attach(world);
             npcs.push_back(npc);
+            ++aliveByType[static_cast<int>(type)];
         }
     }
     
+    rebuildGrid();
+    resetSnapshot();
+    if (journal) {
+        journal->compact(npcs, masterSeed, currentTick, config.mapWidth, config.mapHeight);
+    }
+    
     safePrint("Game initialized with " + std::to_string(npcs.size()) + " NPCs");
 }
 
@@ -51,18 +140,65 @@ void Game::start() {
     running = true;
     
     // Запускаем потоки
+    battlePool.start([this](const BattleTask& task) { resolveBattle(task); });
     movementThread = std::thread(&Game::movementWorker, this);
-    battleThread = std::thread(&Game::battleWorker, this);
     mapThread = std::thread(&Game::mapWorker, this);
     
-    safePrint("Game started! Duration: " + std::to_string(GAME_DURATION) + " seconds");
+    safePrint("Game started! Duration: " + std::to_string(config.duration) + " seconds, " +
+              std::to_string(battlePool.workerCount()) + " battle threads");
     
     // Ждем завершения игры
-    std::this_thread::sleep_for(std::chrono::seconds(GAME_DURATION));
+    std::this_thread::sleep_for(std::chrono::seconds(config.duration));
+    stop();
+    
+    printSurvivors();
+}
+
+SimulationStats Game::runHeadless() {
+    SimulationStats stats;
+    std::size_t fightsBefore = fightCount;
+    std::size_t killsBefore = killCount;
+    long long limit = config.tickLimit();
+    
+    battlePool.start([this](const BattleTask& task) { resolveBattle(task); });
+    
+    auto startTime = std::chrono::steady_clock::now();
+    while (stats.ticks < limit && aliveFactions() > 1) {
+        movementTick();
+        // Фиксированный шаг: бои такта разрешаются до следующего такта
+        settleTick();
+        settledTicks = currentTick.load();
+        ++stats.ticks;
+    }
+    stats.seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - startTime).count();
+    // Остановка перестраивает шарды - метрику берем до нее
+    stats.shardImbalance = shardBalance().imbalance;
+    
     stop();
     
-    // Выводим список выживших
+    stats.fights = fightCount - fightsBefore;
+    stats.kills = killCount - killsBefore;
+    stats.survivors = npcs.size();
+    
+    double seconds = std::max(stats.seconds, 1e-9);
+    std::stringstream ss;
+    ss << "Headless run: " << stats.ticks << " ticks in " << stats.seconds << " s ("
+       << stats.ticks / seconds << " ticks/sec), "
+       << stats.fights << " fights (" << stats.fights / seconds << " fights/sec), "
+       << stats.kills << " kills, " << stats.survivors << " survivors";
+    if (shards.size() > 1) {
+        ss << ", shard imbalance " << stats.shardImbalance;
+    }
+    safePrint(ss.str());
+    return stats;
+}
+
+void Game::printSurvivors() const {
     safePrint("\n=== GAME OVER ===");
+    if (fightLog->dropped() > 0) {
+        safePrint("Fight log dropped " + std::to_string(fightLog->dropped()) + " events");
+    }
     safePrint("Survivors (" + std::to_string(npcs.size()) + "):");
     for (const auto& npc : npcs) {
         if (npc->isAlive()) {
@@ -76,200 +212,732 @@ void Game::start() {
 void Game::stop() {
     running = false;
     
-    // Оповещаем потоки
-    battleCV.notify_all();
+    // Останавливаем пул боя: это же отпускает поток движения,
+    // если он ждет места в очереди
+    battlePool.stop();
     
     // Ждем завершения потоков
     if (movementThread.joinable()) movementThread.join();
-    if (battleThread.joinable()) battleThread.join();
     if (mapThread.joinable()) mapThread.join();
     
+    // Гибель с последнего такта попадает в журнал до удаления мертвых
+    journalDeaths();
+    
     // Удаляем мертвых NPC
     npcs.erase(
         std::remove_if(npcs.begin(), npcs.end(),
             [](const std::shared_ptr<NPC>& npc) { return !npc->isAlive(); }),
         npcs.end()
     );
+    
+    // Уплотняем мир: выжившие получают новые строки по порядку в npcs
+    for (auto& npc : npcs) {
+        npc->detach();
+    }
+    world.clear();
+    world.reserve(npcs.size());
+    for (auto& npc : npcs) {
+        npc->attach(world);
+    }
+    
+    // Индексы в сетке и снимке сдвинулись после удаления
+    rebuildGrid();
+    resetSnapshot();
+    
+    // Итоги печатаются после всех строк о боях
+    fightLog->flush();
+    
+    // Выгрузка с итогами прогона, не дожидаясь интервала
+    if (metricsExporter) {
+        try {
+            metricsExporter->exportNow();
+        } catch (const std::exception& e) {
+            safePrint(e.what());
+        }
+    }
 }
 
-void Game::movementWorker() {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dirDist(-1, 1);
+void Game::saveSnapshot(const std::string& path) const {
+    snapshot::Columns columns;
+    columns.seed = masterSeed;
+    columns.tick = currentTick;
+    columns.mapWidth = config.mapWidth;
+    columns.mapHeight = config.mapHeight;
     
-    while (running) {
-        for (auto& npc : npcs) {
-            if (!npc->isAlive()) continue;
-            
-            // Генерируем случайное направление
-            int dx = dirDist(gen);
-            int dy = dirDist(gen);
-            
-            // Получаем текущую позицию
-            int currentX = npc->getX();
-            int currentY = npc->getY();
-            
-            // Получаем максимальное расстояние перемещения
-            int moveDist = npc->getMoveDistance();
-            
-            // Вычисляем новую позицию с учетом направления и расстояния
-            int newX = currentX + dx * moveDist;
-            int newY = currentY + dy * moveDist;
-            
-            // Ограничиваем границами карты
-            newX = std::max(0, std::min(MAP_WIDTH - 1, newX));
-            newY = std::max(0, std::min(MAP_HEIGHT - 1, newY));
-            
-            // Обновляем позицию
-            npc->setPosition(newX, newY);
-            
-            // Проверяем ближайших NPC для боя
-            int killDist = npc->getKillDistance();
-            for (auto& other : npcs) {
-                if (other == npc || !other->isAlive()) continue;
-                
-                if (npc->isClose(other, killDist)) {
-                    // Проверяем правила боя через Visitor
-                    auto visitor = std::make_shared<FightVisitor>();
-                    if (other->accept(visitor, npc)) {
-                        // Создаем задачу для боя
-                        BattleTask task{npc, other};
-                        addBattleTask(task);
-                    }
-                }
-            }
+    // Состояние и имена берутся из колонок мира, id - из объектов NPC
+    columns.reserve(npcs.size());
+    for (NpcHandle h = 0; h < world.size(); ++h) {
+        columns.add(npcs[h]->getId(), world.type(h), world.x(h), world.y(h),
+                    world.isAlive(h), world.name(h));
+    }
+    snapshot::write(path, columns);
+}
+
+void Game::loadSnapshot(const std::string& path) {
+    snapshot::MappedSnapshot snap(path);
+    const snapshot::Header& header = snap.header();
+    if (header.mapWidth != config.mapWidth || header.mapHeight != config.mapHeight) {
+        throw std::runtime_error("Snapshot map " + std::to_string(header.mapWidth) + "x" +
+                                 std::to_string(header.mapHeight) + " does not match game map " +
+                                 std::to_string(config.mapWidth) + "x" +
+                                 std::to_string(config.mapHeight));
+    }
+    
+    std::vector<std::shared_ptr<NPC>> loaded;
+    loaded.reserve(snap.size());
+    for (std::size_t i = 0; i < snap.size(); ++i) {
+        auto npc = NPCFactory::createNPC(snap.type(i), snap.x()[i], snap.y()[i],
+                                         std::string(snap.name(i)));
+        if (!npc) {
+            throw std::runtime_error("Snapshot " + path + ": unknown NPC type in record " +
+                                     std::to_string(i));
         }
-        
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        npc->setId(snap.ids()[i]);
+        npc->setAlive(snap.alive()[i] != 0);
+        loaded.push_back(npc);
     }
+    
+    if (header.seed != 0) {
+        masterSeed = header.seed;
+    }
+    currentTick = header.tick;
+    replaceNPCs(std::move(loaded));
 }
 
-void Game::battleWorker() {
-    auto visitor = std::make_shared<FightVisitor>();
+bool Game::recoverJournal(const std::string& path) {
+    JournalState state = Journal::replay(path);
+    if (state.mapWidth != config.mapWidth || state.mapHeight != config.mapHeight) {
+        throw std::runtime_error("Journal map " + std::to_string(state.mapWidth) + "x" +
+                                 std::to_string(state.mapHeight) + " does not match game map " +
+                                 std::to_string(config.mapWidth) + "x" +
+                                 std::to_string(config.mapHeight));
+    }
+    if (state.seed != 0) {
+        masterSeed = state.seed;
+    }
+    currentTick = state.tick;
+    replaceNPCs(std::move(state.npcs));
+    return state.truncated;
+}
+
+void Game::replaceNPCs(std::vector<std::shared_ptr<NPC>> loaded) {
+    stop();
+    for (auto& npc : npcs) {
+        npc->detach();
+    }
+    npcs = std::move(loaded);
+    world.clear();
+    world.reserve(npcs.size());
+    for (auto& count : aliveByType) {
+        count = 0;
+    }
     
-    while (running) {
-        BattleTask task;
-        {
-            std::unique_lock lock(battleMutex);
-            battleCV.wait_for(lock, std::chrono::milliseconds(100),
-                [this]() { return !battleQueue.empty() || !running; });
-            
-            if (!running && battleQueue.empty()) break;
-            
-            if (!battleQueue.empty()) {
-                task = battleQueue.front();
-                battleQueue.erase(battleQueue.begin());
-            }
+    nextId = 0;
+    for (auto& npc : npcs) {
+        npc->attach(world);
+        nextId = std::max(nextId, npc->getId() + 1);
+        if (npc->isAlive()) {
+            ++aliveByType[static_cast<int>(npc->getType())];
         }
-        
-        if (task.attacker && task.defender && 
-            task.attacker->isAlive() && task.defender->isAlive()) {
-            
-            // Каждый NPC бросает кубик
-            int attackPower = task.attacker->rollAttack();
-            int defensePower = task.defender->rollDefense();
-            
-            if (attackPower > defensePower) {
-                // Убийство
-                task.defender->setAlive(false);
-                
-                // Уведомляем о победе
-                task.attacker->notifyFight(task.defender, true);
-                
-                std::stringstream ss;
-                ss << task.attacker->getName() << " killed " 
-                   << task.defender->getName() 
-                   << " (Attack: " << attackPower 
-                   << " vs Defense: " << defensePower << ")";
-                safePrint(ss.str());
-            } else {
-                std::stringstream ss;
-                ss << task.attacker->getName() << " failed to kill " 
-                   << task.defender->getName()
-                   << " (Attack: " << attackPower 
-                   << " vs Defense: " << defensePower << ")";
-                safePrint(ss.str());
+    }
+    
+    rebuildGrid();
+    resetSnapshot();
+    if (journal) {
+        journal->compact(npcs, masterSeed, currentTick, config.mapWidth, config.mapHeight);
+    }
+}
+
+void Game::journalDeaths() {
+    if (!journal) return;
+    // Убитые после начала последнего такта еще стоят в сетке
+    for (std::size_t i = 0; i < npcs.size() && i < inGrid.size(); ++i) {
+        if (inGrid[i] && !world.isAlive(static_cast<NpcHandle>(i))) {
+            journal->kill(npcs[i]->getId());
+        }
+    }
+    journal->tick(currentTick);
+    journal->commit();
+}
+
+Recording Game::recording() const {
+    Recording result;
+    result.seed = masterSeed;
+    result.mapWidth = config.mapWidth;
+    result.mapHeight = config.mapHeight;
+    // id выдаются подряд с нуля, мертвые NPC удаляются при остановке
+    result.npcCount = static_cast<int>(nextId);
+    result.ticks = settledTicks.load();
+    {
+        std::lock_guard<std::mutex> lock(recordMutex);
+        for (const auto& fight : recordedFights) {
+            if (fight.tick < result.ticks) {
+                result.fights.push_back(fight);
             }
         }
     }
+    result.sortFights();
+    return result;
 }
 
-void Game::mapWorker() {
+std::size_t Game::shardCount() const {
+    return shards.size();
+}
+
+std::size_t Game::npcCount() const {
+    return npcs.size();
+}
+
+void Game::setSeed(std::uint64_t seed) {
+    masterSeed = seed;
+}
+
+std::uint64_t Game::getSeed() const {
+    return masterSeed;
+}
+
+const GameConfig& Game::getConfig() const {
+    return config;
+}
+
+int Game::aliveFactions() const {
+    int factions = 0;
+    for (const auto& count : aliveByType) {
+        if (count > 0) ++factions;
+    }
+    return factions;
+}
+
+void Game::movementWorker() {
     while (running) {
-        printMap();
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+        movementTick();
+        // Тот же фиксированный шаг, что и в ускоренном режиме: иначе бои
+        // такта смешиваются со следующим и исход зависит от потоков
+        settleTick();
+        if (running) {
+            settledTicks = currentTick.load();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(config.tickMillis));
     }
 }
 
-void Game::addBattleTask(const BattleTask& task) {
-    std::lock_guard lock(battleMutex);
-    battleQueue.push_back(task);
-    battleCV.notify_one();
+void Game::settleTick() {
+    battlePool.waitIdle();
+    std::uint64_t now = metrics::nowNanos();
+    metrics::observe(metrics::BattlePhase, now - battleStartNanos);
+    metrics::observe(metrics::TickTotal, now - tickStartNanos);
+    metrics::observe(metrics::TickAllocations, metrics::allocations() - tickStartAllocations);
+    metrics::add(metrics::Ticks);
+    
+    int alive = 0;
+    for (const auto& count : aliveByType) {
+        alive += count;
+    }
+    metrics::set(metrics::AliveNpcs, alive);
 }
 
-BattleTask Game::getBattleTask() {
-    std::lock_guard lock(battleMutex);
-    if (battleQueue.empty()) {
-        return {nullptr, nullptr};
+std::size_t Game::movementTick() {
+    tickStartNanos = metrics::nowNanos();
+    tickStartAllocations = metrics::allocations();
+    
+    // Метрика считается и без перестройки полос, окном по умолчанию
+    int window = config.rebalanceTicks > 0 ? config.rebalanceTicks : BALANCE_WINDOW;
+    if (++ticksSinceBalance >= window) {
+        balanceShards(config.rebalanceTicks > 0);
     }
-    BattleTask task = battleQueue.front();
-    battleQueue.erase(battleQueue.begin());
-    return task;
+    
+    std::uint32_t tick = currentTick.fetch_add(1);
+    philox::Key key = philox::keyFromSeed(masterSeed);
+    
+    // Задний буфер снимка. Пишут его только шарды движения, каждый -
+    // строки своих NPC, поэтому поиск соседей читает позиции без блокировок.
+    WorldSnapshot& snap = snapshots.beginWrite();
+    snap.tick = tick;
+    
+    // Три фазы, между фазами шарды ждут друг друга: перемещение,
+    // прием перешедших границу NPC, затем призраки и поиск боев.
+    // Бои ищутся по позициям после перемещения всех NPC, поэтому набор
+    // кандидатов не зависит ни от числа шардов, ни от порядка обхода.
+    // Каждый шард замеряет свое процессорное время для балансировки
+    auto timed = [this](std::size_t index, auto&& phase) {
+        std::uint64_t start = threadCpuNanos();
+        phase();
+        shards[index].busyNanos += threadCpuNanos() - start;
+    };
+    // Метрики фаз - по настенному времени: столько ждет такт
+    std::uint64_t phaseStart = metrics::nowNanos();
+    auto phaseDone = [&phaseStart](metrics::Histogram phase) {
+        std::uint64_t now = metrics::nowNanos();
+        metrics::observe(phase, now - phaseStart);
+        phaseStart = now;
+    };
+    shardPool->run([&](std::size_t index) {
+        timed(index, [&]() { moveShard(index, tick, key, snap); });
+    });
+    phaseDone(metrics::MovePhase);
+    shardPool->run([&](std::size_t index) {
+        timed(index, [&]() { acceptMigrants(index); });
+    });
+    phaseDone(metrics::MigratePhase);
+    shardPool->run([&](std::size_t index) {
+        timed(index, [&]() { detectFights(index, snap); });
+    });
+    phaseDone(metrics::DetectPhase);
+    
+    for (auto& shard : shards) {
+        battleBatch.insert(battleBatch.end(), shard.candidates.begin(), shard.candidates.end());
+        shard.candidates.clear();
+        if (journal) {
+            for (std::uint32_t id : shard.died) {
+                journal->kill(npcs[id]->getId());
+            }
+            for (std::uint32_t id : shard.moved) {
+                journal->move(npcs[id]->getId(), world.x(id), world.y(id));
+            }
+        }
+    }
+    
+    battleStartNanos = metrics::nowNanos();
+    std::size_t tasks = submitBattleBatch(tick, key);
+    metrics::observe(metrics::QueueDepth, tasks);
+    metrics::set(metrics::LastQueueDepth, static_cast<double>(tasks));
+    
+    // Изменения такта уходят в журнал одной записью в файл
+    if (journal) {
+        journal->tick(tick + 1);
+        journal->commit();
+        if (journal->needsCompaction()) {
+            journal->compact(npcs, masterSeed, tick + 1, config.mapWidth, config.mapHeight);
+        }
+    }
+    
+    // Публикуем снимок такта для карты и других читателей
+    snapshots.publish();
+    return tasks;
 }
 
-void Game::safePrint(const std::string& message) {
-    std::lock_guard lock(coutMutex);
-    std::cout << message << std::endl;
+void Game::moveShard(std::size_t index, std::uint32_t tick, const philox::Key& key,
+                     WorldSnapshot& snap) {
+    MovementShard& shard = shards[index];
+    for (auto& box : shard.outbox) {
+        box.clear();
+    }
+    shard.died.clear();
+    shard.moved.clear();
+    
+    for (std::size_t k = 0; k < shard.owned.size();) {
+        std::uint32_t id = shard.owned[k];
+        NpcType type = world.type(id);
+        SpatialGrid& grid = shard.grids[fight_rules::index(type)];
+        
+        // Позиции NPC пишет только шард-владелец, поэтому колонки мира
+        // читаются без блокировки NPC
+        int currentX = world.x(id);
+        int currentY = world.y(id);
+        
+        if (!world.isAlive(id)) {
+            // Убитых NPC убираем из сетки, чтобы не проверять их снова
+            snap.alive[id] = 0;
+            grid.remove(id, currentX, currentY);
+            inGrid[id] = 0;
+            if (journal) shard.died.push_back(id);
+            shard.owned[k] = shard.owned.back();
+            shard.owned.pop_back();
+            continue;
+        }
+        snap.alive[id] = 1;
+        
+        // Случайное направление - функция от (seed, такт, id)
+        auto& npc = npcs[id];
+        philox::Counter r = philox::generate({tick, npc->getId(), 0, philox::Move}, key);
+        int dx = static_cast<int>(philox::uniform(r[0], 3)) - 1;
+        int dy = static_cast<int>(philox::uniform(r[1], 3)) - 1;
+        
+        // Новая позиция с учетом дистанции хода, в границах карты
+        int moveDist = world.moveDistance(id);
+        int newX = std::max(0, std::min(config.mapWidth - 1, currentX + dx * moveDist));
+        int newY = std::max(0, std::min(config.mapHeight - 1, currentY + dy * moveDist));
+        
+        npc->setPosition(newX, newY);
+        if (journal && (newX != currentX || newY != currentY)) {
+            shard.moved.push_back(id);
+        }
+        snap.x[id] = newX;
+        snap.y[id] = newY;
+        
+        // NPC ушел в полосу другого шарда - отдаем его через ящик получателя
+        std::uint32_t target = shardOfRow[grid.rowOf(newY)];
+        if (target != index) {
+            grid.remove(id, currentX, currentY);
+            shard.outbox[target].push_back(id);
+            shard.owned[k] = shard.owned.back();
+            shard.owned.pop_back();
+            continue;
+        }
+        grid.move(id, currentX, currentY, newX, newY);
+        ++k;
+    }
 }
 
-void Game::printMap() const {
-    std::lock_guard lock(coutMutex);
-    std::cout << "\n=== CURRENT MAP ===" << std::endl;
+void Game::acceptMigrants(std::size_t index) {
+    MovementShard& shard = shards[index];
+    // Ящики других шардов в этой фазе только читаются
+    for (const auto& source : shards) {
+        for (std::uint32_t id : source.outbox[index]) {
+            shard.grids[fight_rules::index(world.type(id))].insert(id, world.x(id), world.y(id));
+            shard.owned.push_back(id);
+        }
+    }
+}
+
+void Game::detectFights(std::size_t index, const WorldSnapshot& snap) {
+    MovementShard& shard = shards[index];
     
-    // Создаем простую текстовую карту
-    const int gridSize = 10;
-    char grid[gridSize][gridSize];
+    // Строки-призраки: копии пограничных строк соседей. Соседи в этой фазе
+    // меняют только свои строки-призраки, свои строки читать безопасно.
+    // Дистанция убийства не больше ячейки, поэтому соседей NPC у границы
+    // дальше одной строки искать не нужно.
+    for (std::size_t t = 0; t < fight_rules::TYPE_COUNT; ++t) {
+        SpatialGrid& grid = shard.grids[t];
+        auto copy = [&](std::uint32_t id) { grid.insert(id, world.x(id), world.y(id)); };
+        if (index > 0) {
+            grid.clearRow(shard.rowBegin - 1);
+            shards[index - 1].grids[t].forEachInRow(shard.rowBegin - 1, copy);
+        }
+        if (index + 1 < shards.size()) {
+            grid.clearRow(shard.rowEnd);
+            shards[index + 1].grids[t].forEachInRow(shard.rowEnd, copy);
+        }
+    }
     
-    // Инициализируем пустую карту
-    for (int i = 0; i < gridSize; ++i) {
-        for (int j = 0; j < gridSize; ++j) {
-            grid[i][j] = '.';
+    for (std::uint32_t id : shard.owned) {
+        NpcType type = world.type(id);
+        // Пегасы никого не атакуют - соседей не ищем
+        if (!fight_rules::canAttack(type)) continue;
+        
+        // Проверяем ближайших NPC для боя: только из соседних ячеек.
+        // Позиции кандидатов собираются блоками и проверяются одним вызовом
+        // векторного ядра, дальше обрабатываются только попавшие в радиус.
+        int x = snap.x[id];
+        int y = snap.y[id];
+        int killDist = world.killDistance(id);
+        std::uint32_t candidates[proximity::BLOCK_SIZE];
+        int candidateX[proximity::BLOCK_SIZE];
+        int candidateY[proximity::BLOCK_SIZE];
+        std::size_t blockSize = 0;
+        
+        auto flush = [&]() {
+            std::uint64_t mask = proximity::withinRadius(x, y, killDist,
+                                                         candidateX, candidateY, blockSize);
+            blockSize = 0;
+            // Кандидаты взяты только из сеток типов, которых атакующий
+            // может убить, поэтому Visitor здесь не нужен: ни выделений
+            // памяти, ни счетчиков shared_ptr на пару кандидатов
+            proximity::forEachBit(mask, [&](std::size_t k) {
+                shard.candidates.push_back({candidates[k], id});
+            });
+        };
+        
+        auto collect = [&](const std::uint32_t* ids, std::size_t count) {
+            for (std::size_t k = 0; k < count; ++k) {
+                std::uint32_t otherId = ids[k];
+                // На цель уже есть атака в очереди - второй бросок не нужен
+                if (otherId == id || !snap.alive[otherId] || world.isPending(otherId)) continue;
+                
+                candidates[blockSize] = otherId;
+                candidateX[blockSize] = snap.x[otherId];
+                candidateY[blockSize] = snap.y[otherId];
+                if (++blockSize == proximity::BLOCK_SIZE) flush();
+            }
+        };
+        // Смотрим только сетки типов, которых этот NPC может убить
+        for (std::size_t target = 0; target < fight_rules::TYPE_COUNT; ++target) {
+            if (fight_rules::KILLS[fight_rules::index(type)][target]) {
+                shard.grids[target].forEachCellNear(x, y, killDist, collect);
+            }
         }
+        if (blockSize > 0) flush();
     }
+}
+
+std::size_t Game::submitBattleBatch(std::uint32_t tick, const philox::Key& key) {
+    // Детерминированный порядок: по защищающемуся, затем по атакующему
+    std::sort(battleBatch.begin(), battleBatch.end(),
+        [](const BattleCandidate& a, const BattleCandidate& b) {
+            return a.defender != b.defender ? a.defender < b.defender : a.attacker < b.attacker;
+        });
     
-    // Размещаем живых NPC на карте
-    int aliveCount = 0;
-    for (const auto& npc : npcs) {
-        if (npc->isAlive()) {
-            aliveCount++;
-            
-            // Масштабируем координаты к размеру сетки
-            int gridX = (npc->getX() * gridSize) / MAP_WIDTH;
-            int gridY = (npc->getY() * gridSize) / MAP_HEIGHT;
-            
-            gridX = std::min(gridSize - 1, std::max(0, gridX));
-            gridY = std::min(gridSize - 1, std::max(0, gridY));
+    std::size_t tasks = 0;
+    for (std::size_t begin = 0; begin < battleBatch.size();) {
+        std::uint32_t defender = battleBatch[begin].defender;
+        std::size_t end = begin + 1;
+        while (end < battleBatch.size() && battleBatch[end].defender == defender) ++end;
+        
+        // Одна попытка на защищающегося: атакующего выбираем функцией
+        // от (seed, такт, id защищающегося), без перекоса в пользу младших
+        if (world.tryMarkPending(defender)) {
+            philox::Counter r = philox::generate({tick, npcs[defender]->getId(), 0, philox::Target}, key);
+            std::size_t pick = begin + philox::uniform(r[0], static_cast<std::uint32_t>(end - begin));
             
-            char symbol;
-            switch (npc->getType()) {
-                case NpcType::Dragon: symbol = 'D'; break;
-                case NpcType::Knight: symbol = 'K'; break;
-                case NpcType::Pegasus: symbol = 'P'; break;
-                default: symbol = '?';
+            BattleTask task{npcs[battleBatch[pick].attacker], npcs[defender], tick};
+            addBattleTask(task);
+            ++tasks;
+        }
+        begin = end;
+    }
+    
+    battleBatch.clear();
+    return tasks;
+}
+
+void Game::rebuildGrid() {
+    // Размер ячейки равен наибольшей дистанции убийства,
+    // тогда все цели находятся в соседних ячейках
+    gridCellSize = 1;
+    for (NpcHandle h = 0; h < world.size(); ++h) {
+        gridCellSize = std::max(gridCellSize, world.killDistance(h));
+    }
+    
+    // Карта режется на горизонтальные полосы строк ячеек, по полосе на шард.
+    // Сначала поровну, дальше полосы двигает балансировка.
+    int cellRows = SpatialGrid::rowCount(config.mapHeight, gridCellSize);
+    std::size_t count = config.movementShards;
+    if (count == 0) {
+        count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    count = std::min(count, static_cast<std::size_t>(cellRows));
+    if (!shardPool || shardPool->size() != count) {
+        shardPool = std::make_unique<ShardPool>(count);
+    }
+    std::vector<int> firstRows(count);
+    for (std::size_t index = 0; index < count; ++index) {
+        firstRows[index] = static_cast<int>(cellRows * index / count);
+    }
+    
+    inGrid.assign(world.size(), 0);
+    for (NpcHandle h = 0; h < world.size(); ++h) {
+        inGrid[h] = world.isAlive(h) ? 1 : 0;
+    }
+    partitionShards(firstRows);
+    
+    std::lock_guard lock(balanceMutex);
+    balance = ShardBalance();
+    balance.millis.assign(count, 0.0);
+    balance.npcs.assign(count, 0);
+    for (std::size_t index = 0; index < count; ++index) {
+        balance.npcs[index] = shards[index].owned.size();
+    }
+    balance.firstRows = firstRows;
+    // До первого окна замеров шарды считаются равными
+    metrics::set(metrics::ShardImbalance, balance.imbalance);
+}
+
+void Game::partitionShards(const std::vector<int>& firstRows) {
+    int cellRows = SpatialGrid::rowCount(config.mapHeight, gridCellSize);
+    std::size_t count = firstRows.size();
+    
+    shards.assign(count, MovementShard());
+    shardOfRow.resize(static_cast<std::size_t>(cellRows));
+    for (std::size_t index = 0; index < count; ++index) {
+        MovementShard& shard = shards[index];
+        shard.rowBegin = firstRows[index];
+        shard.rowEnd = index + 1 < count ? firstRows[index + 1] : cellRows;
+        // Плюс по строке-призраку с каждой стороны, если там есть сосед
+        int first = std::max(0, shard.rowBegin - 1);
+        int last = std::min(cellRows, shard.rowEnd + 1);
+        for (auto& grid : shard.grids) {
+            grid = SpatialGrid(config.mapWidth, config.mapHeight, gridCellSize, first, last);
+        }
+        shard.outbox.assign(count, {});
+        for (int row = shard.rowBegin; row < shard.rowEnd; ++row) {
+            shardOfRow[row] = static_cast<std::uint32_t>(index);
+        }
+    }
+    
+    // В сетках остаются и убитые с начала прошлого такта: их уберет
+    // (и запишет в журнал) следующий такт
+    for (NpcHandle h = 0; h < world.size(); ++h) {
+        if (inGrid[h]) {
+            MovementShard& shard = shards[shardOfRow[world.y(h) / gridCellSize]];
+            shard.grids[fight_rules::index(world.type(h))].insert(h, world.x(h), world.y(h));
+            shard.owned.push_back(h);
+        }
+    }
+    ticksSinceBalance = 0;
+}
+
+void Game::balanceShards(bool rebuild) {
+    ticksSinceBalance = 0;
+    std::size_t count = shards.size();
+    std::vector<double> millis(count);
+    std::vector<std::size_t> npcCounts(count);
+    double totalMillis = 0.0;
+    std::size_t totalNpcs = 0;
+    for (std::size_t index = 0; index < count; ++index) {
+        npcCounts[index] = shards[index].owned.size();
+        millis[index] = shardCost ? shardCost(index, npcCounts[index])
+                                  : static_cast<double>(shards[index].busyNanos) / 1e6;
+        totalMillis += millis[index];
+        totalNpcs += npcCounts[index];
+        shards[index].busyNanos = 0;
+    }
+    double ratio = shard_balance::imbalance(millis);
+    metrics::set(metrics::ShardImbalance, ratio);
+    
+    std::vector<int> firstRows(count);
+    for (std::size_t index = 0; index < count; ++index) {
+        firstRows[index] = shards[index].rowBegin;
+    }
+    
+    bool rebuilt = false;
+    if (rebuild && count > 1 && ratio > IMBALANCE_TOLERANCE && totalNpcs > 0) {
+        // Цена строки - ее NPC по измеренной цене NPC ее шарда: стычки
+        // и скопления делают NPC одних полос дороже, чем других
+        double meanCost = totalMillis / static_cast<double>(totalNpcs);
+        std::vector<double> rowCosts(shardOfRow.size(), 0.0);
+        for (std::size_t index = 0; index < count; ++index) {
+            const MovementShard& shard = shards[index];
+            double cost = shard.owned.empty() || millis[index] <= 0.0
+                ? meanCost
+                : millis[index] / static_cast<double>(shard.owned.size());
+            for (std::uint32_t id : shard.owned) {
+                rowCosts[world.y(id) / gridCellSize] += cost;
             }
-            
-            grid[gridY][gridX] = symbol;
+        }
+        
+        std::vector<int> balanced = shard_balance::split(rowCosts, count);
+        if (balanced != firstRows) {
+            partitionShards(balanced);
+            firstRows = balanced;
+            rebuilt = true;
         }
     }
     
-    // Выводим карту
-    for (int i = 0; i < gridSize; ++i) {
-        std::cout << "|";
-        for (int j = 0; j < gridSize; ++j) {
-            std::cout << grid[i][j] << " ";
+    std::lock_guard lock(balanceMutex);
+    balance.imbalance = ratio;
+    balance.millis = millis;
+    balance.npcs = npcCounts;
+    balance.firstRows = firstRows;
+    if (rebuilt) ++balance.rebalances;
+}
+
+void Game::setShardCost(ShardCost cost) {
+    shardCost = std::move(cost);
+}
+
+ShardBalance Game::shardBalance() const {
+    std::lock_guard lock(balanceMutex);
+    return balance;
+}
+
+void Game::resetSnapshot() {
+    WorldSnapshot snap;
+    snap.tick = currentTick;
+    snap.resize(world.size());
+    std::copy(world.xData(), world.xData() + world.size(), snap.x.begin());
+    std::copy(world.yData(), world.yData() + world.size(), snap.y.begin());
+    for (NpcHandle h = 0; h < world.size(); ++h) {
+        snap.type[h] = world.type(h);
+        snap.alive[h] = world.isAlive(h);
+    }
+    snapshots.reset(snap);
+}
+
+void Game::resolveBattle(const BattleTask& task) {
+    if (!task.attacker || !task.defender) return;
+    
+    // Каждый NPC бросает кубик; бросок зависит от seed, такта и пары
+    int attackPower = task.attacker->rollAttack(masterSeed, task.tick, task.defender->getId());
+    int defensePower = task.defender->rollDefense(masterSeed, task.tick, task.attacker->getId());
+    
+    // Проверка "оба живы" и убийство - под блокировкой обоих NPC.
+    // Бои такта одновременны: погибший на этом такте еще атакует
+    FightOutcome outcome = task.attacker->fight(*task.defender, attackPower, defensePower, task.tick);
+    // Бой разрешен - на защищающегося снова можно ставить атаку
+    world.clearPending(task.defender->getHandle());
+    if (outcome == FightOutcome::Skipped) return;
+    
+    if (config.record) {
+        std::lock_guard<std::mutex> lock(recordMutex);
+        recordedFights.push_back({task.tick, task.attacker->getId(), task.defender->getId(),
+                                  outcome == FightOutcome::Killed});
+    }
+    
+    ++fightCount;
+    metrics::add(metrics::Fights);
+    if (outcome == FightOutcome::Killed) {
+        ++killCount;
+        metrics::add(metrics::Kills);
+        --aliveByType[static_cast<int>(task.defender->getType())];
+    }
+    if (outcome == FightOutcome::Killed) {
+        // Уведомляем о победе: в ускоренном режиме подписан только FileObserver
+        task.attacker->notifyFight(task.defender, true);
+    }
+    // В ускоренном режиме бои не печатаются в консоль
+    if (config.headless) return;
+    
+    // Строку о бое пишет поток лога, поток боя не ждет консоль
+    FightEvent event = FightEvent::make(*task.attacker, *task.defender,
+                                        outcome == FightOutcome::Killed);
+    event.channel = battleChannel;
+    event.tick = task.tick;
+    event.attackPower = attackPower;
+    event.defensePower = defensePower;
+    fightLog->push(event);
+}
+
+void Game::mapWorker() {
+    MapRenderer renderer(config.mapWidth, config.mapHeight, config.viewColumns, config.viewRows,
+                         config.ansiMap ? RenderMode::Ansi : RenderMode::Plain);
+    try {
+        while (running) {
+            printMap(renderer);
+            std::this_thread::sleep_for(std::chrono::seconds(1));
         }
-        std::cout << "|" << std::endl;
+        std::string restore = renderer.finish();
+        if (!restore.empty()) {
+            std::lock_guard lock(coutMutex);
+            MapRenderer::emit(STDOUT_FILENO, restore);
+        }
+    } catch (const std::exception& e) {
+        // Без консоли карта просто перестает рисоваться
+        std::cerr << "Error: " << e.what() << std::endl;
+    }
+}
+
+void Game::addBattleTask(const BattleTask& task) {
+    // Если очередь заполнена, поток движения ждет, пока бои разберут
+    battlePool.submit(task);
+}
+
+std::size_t Game::pendingBattles() const {
+    return battlePool.pending();
+}
+
+void Game::clearBattleTasks() {
+    battlePool.clear();
+    world.clearAllPending();
+}
+
+void Game::safePrint(const std::string& message) {
+    std::lock_guard lock(coutMutex);
+    std::cout << message << std::endl;
+}
+
+void Game::printMap(MapRenderer& renderer) const {
+    // Снимок нужен только на время раскладки NPC по клеткам:
+    // дольше держать его нельзя, поток движения ждет этот буфер
+    {
+        auto snap = snapshots.read();
+        renderer.rasterize(*snap);
     }
     
-    std::cout << "Alive: " << aliveCount << std::endl;
+    // Кадр собран заранее, консоль занята только на один write.
+    // Потоки боя консоль не трогают: их события пишет поток лога
+    const std::string& frame = renderer.compose();
+    if (frame.empty()) return;
+    std::lock_guard lock(coutMutex);
+    std::cout << std::flush;
+    MapRenderer::emit(STDOUT_FILENO, frame);
 }
\ No newline at end of file
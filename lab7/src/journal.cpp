@@ -0,0 +1,287 @@
+#include "journal.h"
+#include "factory.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+std::runtime_error systemError(const std::string& what, const std::string& path) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+void writeAll(int fd, const std::string& data, const std::string& path) {
+    const char* pos = data.data();
+    std::size_t left = data.size();
+    while (left > 0) {
+        ssize_t written = ::write(fd, pos, left);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            throw systemError("Cannot write journal", path);
+        }
+        pos += written;
+        left -= static_cast<std::size_t>(written);
+    }
+}
+
+void appendNumber(std::string& out, long long value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+// Как в NPC::load: пробелы и табуляции по краям не входят в значение
+std::string trim(const std::string& line) {
+    std::size_t first = line.find_first_not_of(" \t");
+    if (first == std::string::npos) return "";
+    std::size_t last = line.find_last_not_of(" \t");
+    return line.substr(first, last - first + 1);
+}
+
+bool onMap(int x, int y, const JournalState& state) {
+    return x >= 0 && x < state.mapWidth && y >= 0 && y < state.mapHeight;
+}
+
+// Состояние NPC при воспроизведении
+struct Row {
+    NpcType type;
+    int x;
+    int y;
+    std::string name;
+    bool alive;
+};
+
+} // namespace
+
+Journal::Journal(const std::string& journalPath, std::size_t minCompact)
+    : path(journalPath), fd(-1), snapshotBytes(0), appendedBytes(0),
+      minCompactBytes(minCompact) {
+    open();
+    struct stat info;
+    if (::fstat(fd, &info) == 0) {
+        snapshotBytes = static_cast<std::size_t>(info.st_size);
+    }
+}
+
+Journal::~Journal() {
+    try {
+        commit();
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+void Journal::open() {
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        throw systemError("Cannot open journal", path);
+    }
+}
+
+void Journal::add(const NPC& npc) {
+    std::ostringstream record;
+    record << "A " << npc.getId() << '\n';
+    npc.save(record);
+    buffer += record.str();
+}
+
+void Journal::move(std::uint32_t id, int x, int y) {
+    buffer += "M ";
+    appendNumber(buffer, id);
+    buffer += ' ';
+    appendNumber(buffer, x);
+    buffer += ' ';
+    appendNumber(buffer, y);
+    buffer += '\n';
+}
+
+void Journal::kill(std::uint32_t id) {
+    buffer += "K ";
+    appendNumber(buffer, id);
+    buffer += '\n';
+}
+
+void Journal::rename(std::uint32_t id, const std::string& name) {
+    if (name.find('\n') != std::string::npos) {
+        throw std::invalid_argument("NPC name must be a single line");
+    }
+    buffer += "R ";
+    appendNumber(buffer, id);
+    buffer += '\n';
+    buffer += name;
+    buffer += '\n';
+}
+
+void Journal::tick(std::uint32_t nextTick) {
+    buffer += "T ";
+    appendNumber(buffer, nextTick);
+    buffer += '\n';
+}
+
+void Journal::commit() {
+    if (buffer.empty()) return;
+    writeAll(fd, buffer, path);
+    appendedBytes += buffer.size();
+    buffer.clear();
+}
+
+bool Journal::needsCompaction() const {
+    return changesSize() > std::max(minCompactBytes, 2 * snapshotBytes);
+}
+
+void Journal::compact(const std::vector<std::shared_ptr<NPC>>& npcs,
+                      std::uint64_t seed, std::uint32_t nextTick, int mapWidth, int mapHeight) {
+    std::ostringstream out;
+    out << "J " << VERSION << ' ' << seed << ' ' << nextTick << ' '
+        << mapWidth << ' ' << mapHeight << '\n';
+    for (const auto& npc : npcs) {
+        // Погибшие не нужны для восстановления
+        if (!npc->isAlive()) continue;
+        out << "A " << npc->getId() << '\n';
+        npc->save(out);
+    }
+    std::string data = out.str();
+
+    // Новый снимок целиком на диске до того, как заменит старый файл
+    std::string temporary = path + ".tmp";
+    int tmp = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (tmp < 0) {
+        throw systemError("Cannot open journal", temporary);
+    }
+    try {
+        writeAll(tmp, data, temporary);
+        if (::fsync(tmp) != 0) {
+            throw systemError("Cannot sync journal", temporary);
+        }
+    } catch (...) {
+        ::close(tmp);
+        ::unlink(temporary.c_str());
+        throw;
+    }
+    ::close(tmp);
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        ::unlink(temporary.c_str());
+        throw systemError("Cannot replace journal", path);
+    }
+
+    // Дальше дописываем уже в новый файл
+    ::close(fd);
+    open();
+    buffer.clear();
+    snapshotBytes = data.size();
+    appendedBytes = 0;
+}
+
+std::size_t Journal::snapshotSize() const {
+    return snapshotBytes;
+}
+
+std::size_t Journal::changesSize() const {
+    return appendedBytes + buffer.size();
+}
+
+const std::string& Journal::getPath() const {
+    return path;
+}
+
+JournalState Journal::replay(const std::string& journalPath) {
+    std::ifstream file(journalPath, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open journal " + journalPath);
+    }
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    JournalState state;
+    // Строка без перевода строки в конце - оборванная запись
+    if (!content.empty() && content.back() != '\n') {
+        content.erase(content.rfind('\n') == std::string::npos ? 0 : content.rfind('\n') + 1);
+        state.truncated = true;
+    }
+
+    std::istringstream in(content);
+    std::string line;
+    std::string op;
+    std::uint32_t version = 0;
+    std::istringstream header;
+    if (!std::getline(in, line) || (header.str(line), !(header >> op >> version)) || op != "J") {
+        throw std::runtime_error("Not a journal file: " + journalPath);
+    }
+    if (version != VERSION) {
+        throw std::runtime_error("Unsupported journal version " + std::to_string(version));
+    }
+    if (!(header >> state.seed >> state.tick >> state.mapWidth >> state.mapHeight) ||
+        state.mapWidth <= 0 || state.mapHeight <= 0) {
+        throw std::runtime_error("Bad journal header in " + journalPath);
+    }
+
+    // Записи о NPC, которых нет в журнале, пропускаются
+    std::map<std::uint32_t, Row> rows;
+    bool inSnapshot = true;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::uint32_t id = 0;
+        if (!(fields >> op)) continue;
+
+        bool ok = true;
+        if (op == "A" && (fields >> id)) {
+            auto npc = NPCFactory::loadNPC(in);
+            ok = npc != nullptr && onMap(npc->getX(), npc->getY(), state);
+            if (ok) {
+                rows[id] = Row{npc->getType(), npc->getX(), npc->getY(), npc->getName(), npc->isAlive()};
+            }
+        } else if (op == "M" && (fields >> id)) {
+            int x = 0;
+            int y = 0;
+            ok = (fields >> x >> y) && onMap(x, y, state);
+            auto row = rows.find(id);
+            if (ok && row != rows.end()) {
+                row->second.x = x;
+                row->second.y = y;
+            }
+        } else if (op == "K" && (fields >> id)) {
+            auto row = rows.find(id);
+            if (row != rows.end()) row->second.alive = false;
+        } else if (op == "R" && (fields >> id)) {
+            ok = static_cast<bool>(std::getline(in, line));
+            auto row = rows.find(id);
+            if (ok && row != rows.end()) row->second.name = trim(line);
+        } else if (op == "T") {
+            ok = static_cast<bool>(fields >> state.tick);
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            state.truncated = true;
+            break;
+        }
+        // Снимок - это добавления сразу после заголовка
+        if (op != "A") inSnapshot = false;
+        if (!inSnapshot) ++state.records;
+    }
+
+    state.npcs.reserve(rows.size());
+    for (const auto& [id, row] : rows) {
+        auto npc = NPCFactory::createNPC(row.type, row.x, row.y, row.name);
+        if (row.name.empty()) {
+            // createNPC подставляет имя по умолчанию
+            npc->setName(row.name);
+        }
+        npc->setId(id);
+        npc->setAlive(row.alive);
+        state.npcs.push_back(npc);
+    }
+    return state;
+}
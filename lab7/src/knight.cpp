@@ -23,7 +23,7 @@ bool Knight::accept(const std::shared_ptr<IFightVisitor>& visitor,
 }
 
 void Knight::print(std::ostream& os) const {
-    os << "Knight '" << name << "' at (" << x << ", " << y << ")";
+    os << "Knight '" << nameRef() << "' at (" << posX() << ", " << posY() << ")";
 }
 
 void Knight::save(std::ostream& os) const {
@@ -0,0 +1,223 @@
+#include "map_renderer.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace {
+
+constexpr char EMPTY = '.';
+constexpr char ESC = '\x1b';
+
+char symbolOf(NpcType type) {
+    switch (type) {
+        case NpcType::Dragon: return 'D';
+        case NpcType::Knight: return 'K';
+        case NpcType::Pegasus: return 'P';
+        default: return '?';
+    }
+}
+
+void appendNumber(std::string& out, std::size_t value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+// Курсор в строку row и столбец column терминала (с единицы)
+void moveCursor(std::string& out, int row, int column) {
+    out += ESC;
+    out += '[';
+    appendNumber(out, static_cast<std::size_t>(row));
+    out += ';';
+    appendNumber(out, static_cast<std::size_t>(column));
+    out += 'H';
+}
+
+// Клетка по координате: coordinate * cells / size без деления на каждого NPC
+std::vector<int> scaleTable(int size, int cells) {
+    std::vector<int> table(static_cast<std::size_t>(size));
+    for (int i = 0; i < size; ++i) {
+        table[i] = static_cast<int>(static_cast<long long>(i) * cells / size);
+    }
+    return table;
+}
+
+} // namespace
+
+MapRenderer::MapRenderer(int mapWidth, int mapHeight, int viewColumns, int viewRows, RenderMode renderMode)
+    : columns(viewColumns), rows(viewRows), mode(renderMode), drawn(false), alive(0), shownAlive(0) {
+    if (mapWidth < 1 || mapHeight < 1) {
+        throw std::invalid_argument("Map size must be positive");
+    }
+    if (columns < 1 || columns > MAX_VIEW_SIZE || rows < 1 || rows > MAX_VIEW_SIZE) {
+        throw std::invalid_argument("Map view size must be in [1, " +
+                                    std::to_string(MAX_VIEW_SIZE) + "]");
+    }
+    columnOf = scaleTable(mapWidth, columns);
+    rowOf = scaleTable(mapHeight, rows);
+    cells.assign(static_cast<std::size_t>(columns) * rows, EMPTY);
+    shown.assign(cells.size(), EMPTY);
+}
+
+void MapRenderer::rasterize(const WorldSnapshot& snapshot) {
+    std::fill(cells.begin(), cells.end(), EMPTY);
+    alive = 0;
+    int maxX = static_cast<int>(columnOf.size()) - 1;
+    int maxY = static_cast<int>(rowOf.size()) - 1;
+    for (std::size_t i = 0; i < snapshot.size(); ++i) {
+        if (!snapshot.alive[i]) continue;
+        ++alive;
+        int column = columnOf[std::min(maxX, std::max(0, snapshot.x[i]))];
+        int row = rowOf[std::min(maxY, std::max(0, snapshot.y[i]))];
+        cells[static_cast<std::size_t>(row) * columns + column] = symbolOf(snapshot.type[i]);
+    }
+}
+
+const std::string& MapRenderer::compose() {
+    frame.clear();
+    if (mode == RenderMode::Ansi && drawn) {
+        composeDiff();
+    } else {
+        composeFull();
+    }
+    shown = cells;
+    drawn = true;
+    return frame;
+}
+
+void MapRenderer::composeFull() {
+    // Строка карты: '|', клетки через пробел, '|', перевод строки
+    std::size_t width = 2 * static_cast<std::size_t>(columns) + 3;
+    frame.reserve(64 + width * rows);
+
+    if (mode == RenderMode::Ansi) {
+        // Чистый экран, курсор в начало
+        frame += ESC;
+        frame += "[2J";
+        frame += ESC;
+        frame += "[H";
+    } else {
+        frame += '\n';
+    }
+    frame += "=== CURRENT MAP ===\n";
+    // Строки пишутся прямо в буфер кадра, без посимвольного дописывания
+    std::size_t start = frame.size();
+    frame.resize(start + width * rows, ' ');
+    char* out = &frame[start];
+    for (int row = 0; row < rows; ++row) {
+        const char* line = &cells[static_cast<std::size_t>(row) * columns];
+        out[0] = '|';
+        for (int column = 0; column < columns; ++column) {
+            out[1 + 2 * column] = line[column];
+        }
+        out[width - 2] = '|';
+        out[width - 1] = '\n';
+        out += width;
+    }
+    appendAlive();
+    frame += '\n';
+
+    if (mode == RenderMode::Ansi) {
+        // Лог прокручивается под картой
+        int logTop = rows + 3;
+        frame += ESC;
+        frame += '[';
+        appendNumber(frame, static_cast<std::size_t>(logTop));
+        frame += 'r';
+        moveCursor(frame, logTop, 1);
+    }
+}
+
+void MapRenderer::composeDiff() {
+    bool changed = false;
+    std::string cellsText;
+    for (int row = 0; row < rows; ++row) {
+        std::size_t base = static_cast<std::size_t>(row) * columns;
+        // После клетки с пробелом курсор уже стоит на следующей
+        int cursor = -1;
+        for (int column = 0; column < columns; ++column) {
+            char value = cells[base + column];
+            if (value == shown[base + column]) continue;
+            if (cursor != column) {
+                moveCursor(cellsText, row + 2, 2 * column + 2);
+            }
+            cellsText += value;
+            cellsText += ' ';
+            cursor = column + 1;
+            changed = true;
+        }
+    }
+
+    // Кадр без изменений не выводится
+    if (!changed && shownAlive == alive) return;
+
+    // Курсор лога сохраняется и возвращается на место
+    frame += ESC;
+    frame += '7';
+    frame += cellsText;
+    moveCursor(frame, rows + 2, 1);
+    appendAlive();
+    frame += ESC;
+    frame += "[K";
+    frame += ESC;
+    frame += '8';
+}
+
+void MapRenderer::appendAlive() {
+    frame += "Alive: ";
+    appendNumber(frame, alive);
+    shownAlive = alive;
+}
+
+std::string MapRenderer::finish() const {
+    if (mode != RenderMode::Ansi || !drawn) return "";
+    // Сброс области прокрутки переносит курсор в начало - сохраняем его
+    std::string text;
+    text += ESC;
+    text += '7';
+    text += ESC;
+    text += "[r";
+    text += ESC;
+    text += '8';
+    return text;
+}
+
+void MapRenderer::reset() {
+    drawn = false;
+}
+
+char MapRenderer::cell(int column, int row) const {
+    if (column < 0 || column >= columns || row < 0 || row >= rows) {
+        throw std::out_of_range("Map cell out of range");
+    }
+    return cells[static_cast<std::size_t>(row) * columns + column];
+}
+
+std::size_t MapRenderer::aliveCount() const {
+    return alive;
+}
+
+int MapRenderer::getColumns() const {
+    return columns;
+}
+
+int MapRenderer::getRows() const {
+    return rows;
+}
+
+void MapRenderer::emit(int fd, const std::string& data) {
+    const char* pos = data.data();
+    std::size_t left = data.size();
+    while (left > 0) {
+        ssize_t written = ::write(fd, pos, left);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("Cannot write map: ") + std::strerror(errno));
+        }
+        pos += written;
+        left -= static_cast<std::size_t>(written);
+    }
+}
@@ -0,0 +1,348 @@
+#include "metrics.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <time.h>
+
+namespace metrics {
+
+namespace {
+
+// Счетчики одного потока. Пишет только владелец, читает выгрузка
+struct alignas(64) Slot {
+    std::atomic<std::uint64_t> counters[COUNTER_COUNT];
+    std::atomic<std::uint64_t> buckets[HISTOGRAM_COUNT][BUCKETS + 1];
+    std::atomic<std::uint64_t> sums[HISTOGRAM_COUNT];
+};
+
+// Статическая память обнуляется до любого кода, в том числе до первого
+// operator new, поэтому слоты готовы с самого начала работы процесса.
+// Последний слот - общий для потоков сверх MAX_THREADS живых одновременно
+Slot slots[MAX_THREADS + 1];
+Slot& shared = slots[MAX_THREADS];
+std::atomic<std::size_t> claimed{0};
+std::atomic<double> gauges[GAUGE_COUNT];
+thread_local Slot* current = nullptr;
+
+// Слоты завершившихся потоков. mutex и массив не выделяют память, так что
+// годятся и внутри operator new; захватываются раз на поток
+std::mutex freeMutex;
+std::size_t freeSlots[MAX_THREADS];
+std::size_t freeCount = 0;
+
+Slot* acquire() {
+    std::lock_guard lock(freeMutex);
+    if (freeCount > 0) {
+        return &slots[freeSlots[--freeCount]];
+    }
+    std::size_t index = claimed.load(std::memory_order_relaxed);
+    if (index == MAX_THREADS) return &shared;
+    claimed.store(index + 1, std::memory_order_relaxed);
+    return &slots[index];
+}
+
+// Слот возвращается со всеми счетчиками: следующий владелец продолжает
+// копить в них, и сумма по слотам не теряет ничего. mutex упорядочивает
+// последние записи старого владельца и первые записи нового
+struct Release {
+    ~Release() {
+        if (current != &shared) {
+            std::lock_guard lock(freeMutex);
+            freeSlots[freeCount++] = static_cast<std::size_t>(current - slots);
+        }
+        // Выделения в деструкторах, идущих после этого, - в общий слот
+        current = &shared;
+    }
+};
+
+Slot& slot() {
+    if (!current) {
+        current = acquire();
+        // Деструктор thread_local вернет слот при выходе из потока
+        thread_local Release release;
+    }
+    return *current;
+}
+
+void bump(const Slot& owner, std::atomic<std::uint64_t>& cell, std::uint64_t value) {
+    if (&owner == &shared) {
+        cell.fetch_add(value, std::memory_order_relaxed);
+    } else {
+        cell.store(cell.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+}
+
+// Описание гистограммы для выгрузки; гистограммы одного семейства идут подряд
+struct HistogramInfo {
+    const char* family;
+    const char* labels;  // без фигурных скобок, пусто - без меток
+    bool seconds;        // значения в нс, выгружаются в секундах
+    const char* help;
+};
+
+constexpr HistogramInfo HISTOGRAMS[HISTOGRAM_COUNT] = {
+    {"dungeon_tick_phase_seconds", "phase=\"move\"", true, "Duration of one tick phase."},
+    {"dungeon_tick_phase_seconds", "phase=\"migrate\"", true, "Duration of one tick phase."},
+    {"dungeon_tick_phase_seconds", "phase=\"detect\"", true, "Duration of one tick phase."},
+    {"dungeon_tick_phase_seconds", "phase=\"battle\"", true, "Duration of one tick phase."},
+    {"dungeon_tick_seconds", "", true, "Duration of a whole tick."},
+    {"dungeon_battle_queue_depth", "", false, "Battles queued per tick."},
+    {"dungeon_tick_allocations", "", false, "Heap allocations per tick in all threads."},
+};
+
+struct CounterInfo {
+    const char* name;
+    double scale;  // множитель при выгрузке
+    const char* help;
+};
+
+constexpr CounterInfo COUNTERS[COUNTER_COUNT] = {
+    {"dungeon_ticks_total", 1.0, "Ticks completed."},
+    {"dungeon_fights_total", 1.0, "Fights resolved."},
+    {"dungeon_kills_total", 1.0, "Fights that killed the defender."},
+    {"dungeon_npc_lock_waits_total", 1.0, "NPC lock acquisitions that had to wait."},
+    {"dungeon_npc_lock_wait_seconds_total", 1e-9, "Time spent waiting for NPC locks."},
+    {"dungeon_allocations_total", 1.0, "Calls to operator new."},
+};
+
+constexpr CounterInfo GAUGES[GAUGE_COUNT] = {
+    {"dungeon_alive_npcs", 1.0, "NPCs alive after the last tick."},
+    {"dungeon_battle_queue_last", 1.0, "Battles queued on the last tick."},
+    {"dungeon_shard_imbalance", 1.0, "Slowest movement shard time over the mean, last window."},
+};
+
+std::string number(double value) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.9g", value);
+    return text;
+}
+
+void appendHeader(std::string& out, const char* name, const char* type, const char* help) {
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+}
+
+void appendSample(std::string& out, const std::string& name, const std::string& labels,
+                  const std::string& value) {
+    out += name;
+    if (!labels.empty()) {
+        out += '{';
+        out += labels;
+        out += '}';
+    }
+    out += ' ';
+    out += value;
+    out += '\n';
+}
+
+} // namespace
+
+void add(Counter counter, std::uint64_t value) {
+    Slot& own = slot();
+    bump(own, own.counters[counter], value);
+}
+
+void observe(Histogram histogram, std::uint64_t value) {
+    Slot& own = slot();
+    bump(own, own.buckets[histogram][bucketOf(histogram, value)], 1);
+    bump(own, own.sums[histogram], value);
+}
+
+void set(Gauge gauge, double value) {
+    gauges[gauge].store(value, std::memory_order_relaxed);
+}
+
+std::size_t bucketOf(Histogram histogram, std::uint64_t value) {
+    std::uint64_t unit = HISTOGRAMS[histogram].seconds ? 1000 : 1;
+    std::uint64_t units = value / unit + (value % unit != 0 ? 1 : 0);
+    if (units <= 1) return 0;
+    // Наименьшее i, при котором 2^i >= units
+    std::size_t index = 64 - static_cast<std::size_t>(__builtin_clzll(units - 1));
+    return std::min(index, BUCKETS);
+}
+
+std::uint64_t allocations() {
+    std::size_t used = threadSlots();
+    std::uint64_t total = shared.counters[Allocations].load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < used; ++i) {
+        total += slots[i].counters[Allocations].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+std::size_t threadSlots() {
+    return std::min(claimed.load(std::memory_order_relaxed), MAX_THREADS);
+}
+
+std::uint64_t nowNanos() {
+    timespec now;
+    ::clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<std::uint64_t>(now.tv_sec) * 1000000000ull +
+           static_cast<std::uint64_t>(now.tv_nsec);
+}
+
+Snapshot collect() {
+    Snapshot snapshot;
+    std::size_t used = threadSlots();
+    auto gather = [&snapshot](const Slot& source) {
+        for (std::size_t c = 0; c < COUNTER_COUNT; ++c) {
+            snapshot.counters[c] += source.counters[c].load(std::memory_order_relaxed);
+        }
+        for (std::size_t h = 0; h < HISTOGRAM_COUNT; ++h) {
+            auto& target = snapshot.histograms[h];
+            for (std::size_t b = 0; b <= BUCKETS; ++b) {
+                std::uint64_t count = source.buckets[h][b].load(std::memory_order_relaxed);
+                target.buckets[b] += count;
+                target.count += count;
+            }
+            target.sum += source.sums[h].load(std::memory_order_relaxed);
+        }
+    };
+    for (std::size_t i = 0; i < used; ++i) {
+        gather(slots[i]);
+    }
+    gather(shared);
+    for (std::size_t g = 0; g < GAUGE_COUNT; ++g) {
+        snapshot.gauges[g] = gauges[g].load(std::memory_order_relaxed);
+    }
+    return snapshot;
+}
+
+std::string formatPrometheus(const Snapshot& snapshot, double fightsPerSecond, double killsPerSecond) {
+    std::string out;
+    const char* family = "";
+    for (std::size_t h = 0; h < HISTOGRAM_COUNT; ++h) {
+        const HistogramInfo& info = HISTOGRAMS[h];
+        const auto& data = snapshot.histograms[h];
+        if (std::string(family) != info.family) {
+            family = info.family;
+            appendHeader(out, family, "histogram", info.help);
+        }
+        std::string labels = info.labels;
+        std::string prefix = labels.empty() ? "" : labels + ",";
+        double scale = info.seconds ? 1e-6 : 1.0;
+        double sumScale = info.seconds ? 1e-9 : 1.0;
+
+        // Корзины в Prometheus накопленные
+        std::uint64_t cumulative = 0;
+        for (std::size_t b = 0; b <= BUCKETS; ++b) {
+            cumulative += data.buckets[b];
+            std::string le = b < BUCKETS
+                ? number(static_cast<double>(1ull << b) * scale) : "+Inf";
+            appendSample(out, std::string(family) + "_bucket", prefix + "le=\"" + le + "\"",
+                         std::to_string(cumulative));
+        }
+        appendSample(out, std::string(family) + "_sum", labels,
+                     number(static_cast<double>(data.sum) * sumScale));
+        appendSample(out, std::string(family) + "_count", labels, std::to_string(data.count));
+    }
+
+    for (std::size_t c = 0; c < COUNTER_COUNT; ++c) {
+        appendHeader(out, COUNTERS[c].name, "counter", COUNTERS[c].help);
+        std::string value = COUNTERS[c].scale == 1.0
+            ? std::to_string(snapshot.counters[c])
+            : number(static_cast<double>(snapshot.counters[c]) * COUNTERS[c].scale);
+        appendSample(out, COUNTERS[c].name, "", value);
+    }
+    for (std::size_t g = 0; g < GAUGE_COUNT; ++g) {
+        appendHeader(out, GAUGES[g].name, "gauge", GAUGES[g].help);
+        appendSample(out, GAUGES[g].name, "", number(snapshot.gauges[g]));
+    }
+    appendHeader(out, "dungeon_fights_per_second", "gauge", "Fights per second since the last export.");
+    appendSample(out, "dungeon_fights_per_second", "", number(fightsPerSecond));
+    appendHeader(out, "dungeon_kills_per_second", "gauge", "Kills per second since the last export.");
+    appendSample(out, "dungeon_kills_per_second", "", number(killsPerSecond));
+    return out;
+}
+
+Exporter::Exporter(std::string exportPath, std::chrono::milliseconds exportInterval)
+    : path(std::move(exportPath)), interval(exportInterval), stopping(false),
+      lastNanos(nowNanos()), lastFights(0), lastKills(0) {
+    if (path.empty()) {
+        throw std::invalid_argument("Metrics path must not be empty");
+    }
+    if (interval.count() <= 0) {
+        throw std::invalid_argument("Metrics interval must be positive");
+    }
+    Snapshot start = collect();
+    lastFights = start.counters[Fights];
+    lastKills = start.counters[Kills];
+    thread = std::thread(&Exporter::run, this);
+}
+
+Exporter::~Exporter() {
+    stop();
+}
+
+void Exporter::exportNow() {
+    std::lock_guard<std::mutex> lock(mutex);
+    Snapshot snapshot = collect();
+    std::uint64_t now = nowNanos();
+    double seconds = std::max(1e-9, static_cast<double>(now - lastNanos) * 1e-9);
+    double fightsPerSecond = static_cast<double>(snapshot.counters[Fights] - lastFights) / seconds;
+    double killsPerSecond = static_cast<double>(snapshot.counters[Kills] - lastKills) / seconds;
+    std::string text = formatPrometheus(snapshot, fightsPerSecond, killsPerSecond);
+
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file || !file.write(text.data(), static_cast<std::streamsize>(text.size())) ||
+            !file.flush()) {
+            throw std::runtime_error("Cannot write metrics to " + temporary);
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("Cannot replace metrics file " + path);
+    }
+    lastNanos = now;
+    lastFights = snapshot.counters[Fights];
+    lastKills = snapshot.counters[Kills];
+}
+
+void Exporter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) return;
+        stopping = true;
+    }
+    wake.notify_all();
+    if (thread.joinable()) thread.join();
+    // Последняя выгрузка - с итогами прогона
+    try {
+        exportNow();
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    }
+}
+
+const std::string& Exporter::getPath() const {
+    return path;
+}
+
+void Exporter::run() {
+    bool reported = false;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!wake.wait_for(lock, interval, [this] { return stopping; })) {
+        lock.unlock();
+        try {
+            exportNow();
+        } catch (const std::exception& e) {
+            // Сбой выгрузки не останавливает игру; сообщаем один раз
+            if (!reported) std::cerr << e.what() << std::endl;
+            reported = true;
+        }
+        lock.lock();
+    }
+}
+
+} // namespace metrics
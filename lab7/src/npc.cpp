@@ -1,69 +1,195 @@
 #include "npc.h"
 #include "observer.h"
-#include <random>
-
-static std::random_device rd;
-static std::mt19937 gen(rd());
-static std::uniform_int_distribution<> dice(1, 6);
+#include "philox.h"
+#include "world.h"
+#include "metrics.h"
+#include <functional>
 
 NPC::NPC(NpcType t, int x, int y, const std::string& name) 
-    : type(t), x(x), y(y), name(name), alive(true) {}
+    : id(0), type(t), deathTick(0), rollCounter(0), handle(0), world(nullptr),
+      own(std::make_unique<Standalone>()) {
+    own->x = x;
+    own->y = y;
+    own->name = name;
+}
+
+int NPC::posX() const {
+    return world ? world->x(handle) : own->x;
+}
+
+int NPC::posY() const {
+    return world ? world->y(handle) : own->y;
+}
+
+bool NPC::aliveState() const {
+    return world ? world->isAlive(handle) : own->alive;
+}
+
+void NPC::storeAlive(bool value) {
+    if (world) {
+        world->setAlive(handle, value);
+    } else {
+        own->alive = value;
+    }
+}
+
+const std::string& NPC::nameRef() const {
+    return world ? world->name(handle) : own->name;
+}
+
+std::shared_mutex& NPC::mutex() const {
+    return world ? world->rowMutex(handle) : own->mutex;
+}
+
+void NPC::attach(World& target) {
+    // Из другого мира - через собственное состояние
+    detach();
+    {
+        std::unique_lock lock(own->mutex);
+        handle = target.add(type, own->x, own->y, own->alive,
+                            getMoveDistance(), getKillDistance(), std::move(own->name));
+        target.setOwnObservers(handle, std::move(own->ownObservers));
+        // Реестр у мира общий: NPC приносит свой, только если у мира его нет
+        if (!target.observerRegistry()) {
+            target.setObserverRegistry(std::move(own->registry));
+        }
+    }
+    world = &target;
+    own.reset();
+}
+
+void NPC::detach() {
+    if (!world) return;
+
+    // Возвращаем состояние из мира в собственное
+    auto state = std::make_unique<Standalone>();
+    {
+        std::shared_lock lock(world->rowMutex(handle));
+        state->x = world->x(handle);
+        state->y = world->y(handle);
+        state->alive = world->isAlive(handle);
+        state->name = world->name(handle);
+        state->registry = world->observerRegistry();
+        state->ownObservers = world->ownObservers(handle);
+    }
+    own = std::move(state);
+    world = nullptr;
+    handle = 0;
+}
+
+// Привязка меняется только до запуска потоков
+World* NPC::getWorld() const {
+    return world;
+}
+
+std::uint32_t NPC::getHandle() const {
+    return handle;
+}
+
+std::uint32_t NPC::getId() const {
+    return id;
+}
 
 NpcType NPC::getType() const {
-    std::shared_lock lock(mutex);
     return type;
 }
 
 int NPC::getX() const {
-    std::shared_lock lock(mutex);
-    return x;
+    std::shared_lock lock(mutex());
+    return posX();
 }
 
 int NPC::getY() const {
-    std::shared_lock lock(mutex);
-    return y;
+    std::shared_lock lock(mutex());
+    return posY();
 }
 
 const std::string& NPC::getName() const {
-    std::shared_lock lock(mutex);
-    return name;
+    std::shared_lock lock(mutex());
+    return nameRef();
 }
 
 bool NPC::isAlive() const {
-    std::shared_lock lock(mutex);
-    return alive;
+    std::shared_lock lock(mutex());
+    return aliveState();
+}
+
+void NPC::setId(std::uint32_t newId) {
+    std::unique_lock lock(mutex());
+    id = newId;
 }
 
 void NPC::setPosition(int newX, int newY) {
-    std::unique_lock lock(mutex);
-    if (newX >= 0 && newX <= 500) x = newX;
-    if (newY >= 0 && newY <= 500) y = newY;
+    std::unique_lock lock(mutex());
+    // Вне мира допустимы координаты 0..500, в мире - его размеры
+    int maxX = world ? world->getWidth() : 500;
+    int maxY = world ? world->getHeight() : 500;
+    int px = (newX >= 0 && newX <= maxX) ? newX : posX();
+    int py = (newY >= 0 && newY <= maxY) ? newY : posY();
+    
+    if (world) {
+        world->setPosition(handle, px, py);
+    } else {
+        own->x = px;
+        own->y = py;
+    }
 }
 
 void NPC::setName(const std::string& newName) {
-    std::unique_lock lock(mutex);
-    name = newName;
+    std::unique_lock lock(mutex());
+    if (world) {
+        world->setName(handle, newName);
+    } else {
+        own->name = newName;
+    }
 }
 
 void NPC::setAlive(bool isAlive) {
-    std::unique_lock lock(mutex);
-    alive = isAlive;
+    std::unique_lock lock(mutex());
+    storeAlive(isAlive);
+    deathTick = 0;
+}
+
+void NPC::setObserverRegistry(std::shared_ptr<ObserverRegistry> shared) {
+    std::unique_lock lock(mutex());
+    if (world) {
+        world->setObserverRegistry(std::move(shared));
+    } else {
+        own->registry = std::move(shared);
+    }
 }
 
 void NPC::subscribe(const std::shared_ptr<IFightObserver>& observer) {
-    std::unique_lock lock(mutex);
-    observers.push_back(observer);
+    std::unique_lock lock(mutex());
+    // Копия при записи: уведомления, уже взявшие старый список, его дочитают
+    auto current = world ? world->ownObservers(handle) : own->ownObservers;
+    auto updated = current ? std::make_shared<ObserverList>(*current)
+                           : std::make_shared<ObserverList>();
+    updated->push_back(observer);
+    if (world) {
+        world->setOwnObservers(handle, std::move(updated));
+    } else {
+        own->ownObservers = std::move(updated);
+    }
 }
 
 void NPC::notifyFight(const std::shared_ptr<NPC>& defender, bool win) {
-    std::vector<std::shared_ptr<IFightObserver>> observersCopy;
+    std::shared_ptr<ObserverRegistry> shared;
+    std::shared_ptr<const ObserverList> subscribed;
     {
-        std::shared_lock lock(mutex);
-        observersCopy = observers;
+        std::shared_lock lock(mutex());
+        shared = world ? world->observerRegistry() : own->registry;
+        subscribed = world ? world->ownObservers(handle) : own->ownObservers;
     }
     
-    for (auto& observer : observersCopy) {
-        observer->onFight(shared_from_this(), defender, win);
+    auto self = shared_from_this();
+    if (shared) {
+        shared->notify(self, defender, win);
+    }
+    if (subscribed) {
+        for (const auto& observer : *subscribed) {
+            observer->onFight(self, defender, win);
+        }
     }
 }
 
@@ -73,14 +199,14 @@ bool NPC::isClose(const std::shared_ptr<NPC>& other, int distance) const {
     // Используем shared_lock для чтения позиций
     int otherX, otherY, thisX, thisY;
     {
-        std::shared_lock lock1(mutex);
-        thisX = x;
-        thisY = y;
+        std::shared_lock lock1(mutex());
+        thisX = posX();
+        thisY = posY();
     }
     {
         auto otherLock = other->getLock();
-        otherX = other->x;
-        otherY = other->y;
+        otherX = other->posX();
+        otherY = other->posY();
     }
     
     int dx = thisX - otherX;
@@ -89,32 +215,114 @@ bool NPC::isClose(const std::shared_ptr<NPC>& other, int distance) const {
 }
 
 int NPC::rollAttack() const {
-    return dice(gen);
+    // Вместо такта - собственный счётчик бросков NPC
+    return rollAttack(DEFAULT_SEED, rollCounter.fetch_add(1, std::memory_order_relaxed), 0);
 }
 
 int NPC::rollDefense() const {
-    return dice(gen);
+    return rollDefense(DEFAULT_SEED, rollCounter.fetch_add(1, std::memory_order_relaxed), 0);
+}
+
+int NPC::rollAttack(std::uint64_t seed, std::uint32_t tick, std::uint32_t opponentId) const {
+    // id задается до запуска потоков и дальше не меняется
+    return philox::rollDie(seed, tick, id, opponentId, philox::Attack);
+}
+
+int NPC::rollDefense(std::uint64_t seed, std::uint32_t tick, std::uint32_t opponentId) const {
+    return philox::rollDie(seed, tick, id, opponentId, philox::Defense);
+}
+
+namespace {
+
+// Захват мьютекса NPC; если он занят, ожидание попадает в метрики
+void lockCounted(std::unique_lock<std::shared_mutex>& lock) {
+    if (!lock.try_lock()) {
+        std::uint64_t start = metrics::nowNanos();
+        lock.lock();
+        metrics::add(metrics::LockWaits);
+        metrics::add(metrics::LockWaitNanos, metrics::nowNanos() - start);
+    }
+}
+
+// Единый порядок захвата: по адресу мьютекса. Соседи по полосе мира
+// делят мьютекс, его берем один раз
+std::pair<std::unique_lock<std::shared_mutex>, std::unique_lock<std::shared_mutex>>
+lockPair(const NPC& a, const NPC& b) {
+    auto lock1 = a.getLock(std::defer_lock);
+    auto lock2 = b.getLock(std::defer_lock);
+    if (lock1.mutex() == lock2.mutex()) {
+        lockCounted(lock1);
+        return {std::move(lock1), std::unique_lock<std::shared_mutex>()};
+    }
+    if (std::less<std::shared_mutex*>()(lock2.mutex(), lock1.mutex())) {
+        std::swap(lock1, lock2);
+    }
+    lockCounted(lock1);
+    lockCounted(lock2);
+    return {std::move(lock1), std::move(lock2)};
+}
+
+} // namespace
+
+FightOutcome NPC::fight(NPC& defender, int attackPower, int defensePower) {
+    if (&defender == this) return FightOutcome::Skipped;
+
+    auto locks = lockPair(*this, defender);
+    if (!aliveState() || !defender.aliveState()) {
+        return FightOutcome::Skipped;
+    }
+    if (attackPower > defensePower) {
+        defender.storeAlive(false);
+        return FightOutcome::Killed;
+    }
+    return FightOutcome::Survived;
+}
+
+FightOutcome NPC::fight(NPC& defender, int attackPower, int defensePower, std::uint32_t tick) {
+    if (&defender == this) return FightOutcome::Skipped;
+
+    auto locks = lockPair(*this, defender);
+    bool attackerReady = aliveState() || tick < deathTick;
+    if (!attackerReady || !defender.aliveState()) {
+        return FightOutcome::Skipped;
+    }
+    if (attackPower > defensePower) {
+        defender.storeAlive(false);
+        defender.deathTick = tick + 1;
+        return FightOutcome::Killed;
+    }
+    return FightOutcome::Survived;
 }
 
 std::unique_lock<std::shared_mutex> NPC::getLock() const {
-    return std::unique_lock<std::shared_mutex>(const_cast<std::shared_mutex&>(mutex));
+    return std::unique_lock<std::shared_mutex>(mutex());
+}
+
+std::unique_lock<std::shared_mutex> NPC::getLock(std::try_to_lock_t) const {
+    return std::unique_lock<std::shared_mutex>(mutex(), std::try_to_lock);
+}
+
+std::unique_lock<std::shared_mutex> NPC::getLock(std::defer_lock_t) const {
+    return std::unique_lock<std::shared_mutex>(mutex(), std::defer_lock);
 }
 
 void NPC::save(std::ostream& os) const {
-    std::shared_lock lock(mutex);
+    std::shared_lock lock(mutex());
     os << static_cast<int>(type) << std::endl;
-    os << x << std::endl;
-    os << y << std::endl;
-    os << name << std::endl;
-    os << (alive ? 1 : 0) << std::endl;  // Сохраняем состояние alive
+    os << posX() << std::endl;
+    os << posY() << std::endl;
+    os << nameRef() << std::endl;
+    os << (aliveState() ? 1 : 0) << std::endl;  // Сохраняем состояние alive
     os << std::endl;  // Пустая строка для разделения записей
 }
 
 void NPC::load(std::istream& is) {
-    std::unique_lock lock(mutex);
+    std::unique_lock lock(mutex());
     
     // Читаем координату X
     std::string line;
+    int px = 0;
+    int py = 0;
     if (!std::getline(is, line)) {
         throw std::runtime_error("Error reading X coordinate");
     }
@@ -124,7 +332,7 @@ void NPC::load(std::istream& is) {
     line.erase(line.find_last_not_of(" \t") + 1);
     
     try {
-        x = std::stoi(line);
+        px = std::stoi(line);
     } catch (const std::exception& e) {
         throw std::runtime_error("Error parsing X coordinate: '" + line + "'");
     }
@@ -138,7 +346,7 @@ void NPC::load(std::istream& is) {
     line.erase(line.find_last_not_of(" \t") + 1);
     
     try {
-        y = std::stoi(line);
+        py = std::stoi(line);
     } catch (const std::exception& e) {
         throw std::runtime_error("Error parsing Y coordinate: '" + line + "'");
     }
@@ -152,7 +360,7 @@ void NPC::load(std::istream& is) {
     line.erase(0, line.find_first_not_of(" \t"));
     line.erase(line.find_last_not_of(" \t") + 1);
     
-    name = line;
+    std::string newName = line;
     
     // Читаем состояние alive
     if (!std::getline(is, line)) {
@@ -162,12 +370,23 @@ void NPC::load(std::istream& is) {
     line.erase(0, line.find_first_not_of(" \t"));
     line.erase(line.find_last_not_of(" \t") + 1);
     
+    bool isAlive = false;
     try {
-        alive = (std::stoi(line) != 0);
+        isAlive = (std::stoi(line) != 0);
     } catch (const std::exception& e) {
         throw std::runtime_error("Error parsing alive state: '" + line + "'");
     }
     
+    if (world) {
+        world->setPosition(handle, px, py);
+        world->setName(handle, newName);
+    } else {
+        own->x = px;
+        own->y = py;
+        own->name = newName;
+    }
+    storeAlive(isAlive);
+    
     // Пропускаем возможную пустую строку между записями
     std::streampos pos = is.tellg();
     if (!std::getline(is, line)) {
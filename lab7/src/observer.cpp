@@ -1,45 +1,121 @@
 #include "observer.h"
 #include "npc.h"
+#include <algorithm>
 #include <iostream>
 
+// ObserverRegistry
+ObserverRegistry::ObserverRegistry()
+    : list(std::make_shared<const ObserverList>()) {}
+
+void ObserverRegistry::publish(std::shared_ptr<const ObserverList> updated) {
+    std::atomic_store_explicit(&list, std::move(updated), std::memory_order_release);
+}
+
+void ObserverRegistry::subscribe(const std::shared_ptr<IFightObserver>& observer) {
+    std::lock_guard lock(writeMutex);
+    auto updated = std::make_shared<ObserverList>(*snapshot());
+    updated->push_back(observer);
+    publish(std::move(updated));
+}
+
+void ObserverRegistry::unsubscribe(const std::shared_ptr<IFightObserver>& observer) {
+    std::lock_guard lock(writeMutex);
+    auto updated = std::make_shared<ObserverList>(*snapshot());
+    updated->erase(std::remove(updated->begin(), updated->end(), observer), updated->end());
+    publish(std::move(updated));
+}
+
+void ObserverRegistry::clear() {
+    std::lock_guard lock(writeMutex);
+    publish(std::make_shared<const ObserverList>());
+}
+
+std::shared_ptr<const ObserverList> ObserverRegistry::snapshot() const {
+    return std::atomic_load_explicit(&list, std::memory_order_acquire);
+}
+
+std::size_t ObserverRegistry::size() const {
+    return snapshot()->size();
+}
+
+void ObserverRegistry::notify(const std::shared_ptr<NPC>& attacker,
+                              const std::shared_ptr<NPC>& defender,
+                              bool win) const {
+    auto current = snapshot();
+    for (const auto& observer : *current) {
+        observer->onFight(attacker, defender, win);
+    }
+}
+
 // ConsoleObserver
+ConsoleObserver::ConsoleObserver(std::shared_ptr<FightLog> log)
+    : log(std::move(log)), channel(0) {
+    if (this->log) {
+        channel = this->log->addChannel(fight_format::console, FightLog::CONSOLE_SINK);
+    }
+}
+
 void ConsoleObserver::onFight(const std::shared_ptr<NPC>& attacker,
                              const std::shared_ptr<NPC>& defender,
                              bool win) {
-    if (win) {
-        std::cout << "\nBATTLE RESULT" << std::endl;
-        std::cout << "Attacker: ";
-        attacker->print(std::cout);
-        std::cout << std::endl;
-        std::cout << "Defender: ";
-        defender->print(std::cout);
-        std::cout << " was killed!" << std::endl;
-        std::cout << "\n" << std::endl;
+    if (!win) return;
+    
+    FightEvent event = FightEvent::make(*attacker, *defender, win);
+    if (log) {
+        event.channel = channel;
+        log->push(event);
+        return;
     }
+    
+    // Без лога - сразу, но под общим мьютексом консоли
+    std::string text;
+    fight_format::console(event, text);
+    writeConsole(text);
 }
 
 //FileObserver
-FileObserver::FileObserver(const std::string& filename) {
-    logFile.open(filename, std::ios::app);
-    if (logFile.is_open()) {
-        logFile << "Battle Log" << std::endl;
+FileObserver::FileObserver(const std::string& filename, std::shared_ptr<FightLog> log)
+    : logFile(std::make_shared<std::ofstream>(filename, std::ios::app)),
+      log(std::move(log)), channel(0) {
+    if (logFile->is_open()) {
+        *logFile << "Battle Log" << std::endl;
+    }
+    if (this->log) {
+        auto file = logFile;
+        std::uint32_t sink = this->log->addSink([file](const std::string& block) {
+            if (file->is_open()) {
+                file->write(block.data(), static_cast<std::streamsize>(block.size()));
+                file->flush();
+            }
+        });
+        channel = this->log->addChannel(fight_format::file, sink);
     }
 }
 
 FileObserver::~FileObserver() {
-    if (logFile.is_open()) {
-        logFile.close();
+    // С логом поток дописывает и закрывает приемник FightLog
+    if (!log) {
+        std::lock_guard lock(fileMutex);
+        logFile->flush();
     }
 }
 
 void FileObserver::onFight(const std::shared_ptr<NPC>& attacker,
                           const std::shared_ptr<NPC>& defender,
                           bool win) {
-    if (win && logFile.is_open()) {
-        logFile << "Battle: ";
-        attacker->print(logFile);
-        logFile << " killed ";
-        defender->print(logFile);
-        logFile << std::endl;
-    }
-}
\ No newline at end of file
+    if (!win) return;
+    
+    FightEvent event = FightEvent::make(*attacker, *defender, win);
+    if (log) {
+        event.channel = channel;
+        log->push(event);
+        return;
+    }
+    
+    std::string text;
+    fight_format::file(event, text);
+    std::lock_guard lock(fileMutex);
+    if (logFile->is_open()) {
+        *logFile << text;
+    }
+}
@@ -23,7 +23,7 @@ bool Pegasus::accept(const std::shared_ptr<IFightVisitor>& visitor,
 }
 
 void Pegasus::print(std::ostream& os) const {
-    os << "Pegasus '" << name << "' at (" << x << ", " << y << ")";
+    os << "Pegasus '" << nameRef() << "' at (" << posX() << ", " << posY() << ")";
 }
 
 void Pegasus::save(std::ostream& os) const {
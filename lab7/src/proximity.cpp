@@ -0,0 +1,130 @@
+#include "proximity.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define PROXIMITY_X86 1
+#include <immintrin.h>
+#endif
+
+namespace proximity {
+
+namespace {
+
+std::uint64_t scalarTail(int x, int y, int r2, const int* xs, const int* ys,
+                         std::size_t begin, std::size_t count) {
+    std::uint64_t mask = 0;
+    for (std::size_t i = begin; i < count; ++i) {
+        int dx = xs[i] - x;
+        int dy = ys[i] - y;
+        if (dx * dx + dy * dy <= r2) {
+            mask |= std::uint64_t(1) << i;
+        }
+    }
+    return mask;
+}
+
+std::uint64_t withinRadiusScalar(int x, int y, int radius,
+                                 const int* xs, const int* ys, std::size_t count) {
+    if (count > BLOCK_SIZE) count = BLOCK_SIZE;
+    return scalarTail(x, y, radius * radius, xs, ys, 0, count);
+}
+
+#ifdef PROXIMITY_X86
+
+// Разности dx, dy укладываются в 16 бит, поэтому пара (dx, dy) упаковывается
+// в одно 32-битное слово, и madd_epi16 дает dx*dx + dy*dy за одну инструкцию.
+// SSE2 не умеет умножать 32-битные числа, а так обходимся без этого.
+
+__attribute__((target("sse2")))
+std::uint64_t withinRadiusSse2(int x, int y, int radius,
+                               const int* xs, const int* ys, std::size_t count) {
+    if (count > BLOCK_SIZE) count = BLOCK_SIZE;
+    const __m128i px = _mm_set1_epi32(x);
+    const __m128i py = _mm_set1_epi32(y);
+    const __m128i r2 = _mm_set1_epi32(radius * radius);
+    const __m128i low = _mm_set1_epi32(0xFFFF);
+
+    std::uint64_t mask = 0;
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i dx = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(xs + i)), px);
+        __m128i dy = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ys + i)), py);
+        __m128i pair = _mm_or_si128(_mm_and_si128(dx, low), _mm_slli_epi32(dy, 16));
+        __m128i dist2 = _mm_madd_epi16(pair, pair);
+        __m128i far = _mm_cmpgt_epi32(dist2, r2);
+        unsigned bits = ~static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(far))) & 0xFu;
+        mask |= std::uint64_t(bits) << i;
+    }
+    return mask | scalarTail(x, y, radius * radius, xs, ys, i, count);
+}
+
+__attribute__((target("avx2")))
+std::uint64_t withinRadiusAvx2(int x, int y, int radius,
+                               const int* xs, const int* ys, std::size_t count) {
+    if (count > BLOCK_SIZE) count = BLOCK_SIZE;
+    const __m256i px = _mm256_set1_epi32(x);
+    const __m256i py = _mm256_set1_epi32(y);
+    const __m256i r2 = _mm256_set1_epi32(radius * radius);
+    const __m256i low = _mm256_set1_epi32(0xFFFF);
+
+    std::uint64_t mask = 0;
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i dx = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(xs + i)), px);
+        __m256i dy = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ys + i)), py);
+        __m256i pair = _mm256_or_si256(_mm256_and_si256(dx, low), _mm256_slli_epi32(dy, 16));
+        __m256i dist2 = _mm256_madd_epi16(pair, pair);
+        __m256i far = _mm256_cmpgt_epi32(dist2, r2);
+        unsigned bits = ~static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(far))) & 0xFFu;
+        mask |= std::uint64_t(bits) << i;
+    }
+    return mask | scalarTail(x, y, radius * radius, xs, ys, i, count);
+}
+
+#endif
+
+Isa detectIsa() {
+#ifdef PROXIMITY_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return Isa::Avx2;
+    if (__builtin_cpu_supports("sse2")) return Isa::Sse2;
+#endif
+    return Isa::Scalar;
+}
+
+} // namespace
+
+bool isSupported(Isa isa) {
+    return static_cast<int>(isa) <= static_cast<int>(activeIsa());
+}
+
+Isa activeIsa() {
+    static const Isa isa = detectIsa();
+    return isa;
+}
+
+const char* isaName(Isa isa) {
+    switch (isa) {
+        case Isa::Avx2: return "avx2";
+        case Isa::Sse2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+Kernel kernelFor(Isa isa) {
+    if (!isSupported(isa)) return nullptr;
+    switch (isa) {
+#ifdef PROXIMITY_X86
+        case Isa::Avx2: return withinRadiusAvx2;
+        case Isa::Sse2: return withinRadiusSse2;
+#endif
+        default: return withinRadiusScalar;
+    }
+}
+
+std::uint64_t withinRadius(int x, int y, int radius,
+                           const int* xs, const int* ys, std::size_t count) {
+    static const Kernel kernel = kernelFor(activeIsa());
+    return kernel(x, y, radius, xs, ys, count);
+}
+
+} // namespace proximity
@@ -0,0 +1,125 @@
+#include "recording.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+std::string describe(const FightRecord& fight) {
+    std::ostringstream out;
+    out << "tick " << fight.tick << ": " << fight.attacker << " -> " << fight.defender
+        << (fight.killed ? " killed" : " survived");
+    return out.str();
+}
+
+// Строка заголовка "<ключ> <значения...>"
+std::istringstream field(std::istream& in, const std::string& key, const std::string& path) {
+    std::string line;
+    std::string name;
+    if (!std::getline(in, line)) {
+        throw std::runtime_error("Recording " + path + " is truncated");
+    }
+    std::istringstream values(line);
+    if (!(values >> name) || name != key) {
+        throw std::runtime_error("Recording " + path + ": expected '" + key + "'");
+    }
+    return values;
+}
+
+} // namespace
+
+void Recording::sortFights() {
+    std::sort(fights.begin(), fights.end(), [](const FightRecord& a, const FightRecord& b) {
+        if (a.tick != b.tick) return a.tick < b.tick;
+        if (a.defender != b.defender) return a.defender < b.defender;
+        return a.attacker < b.attacker;
+    });
+}
+
+void Recording::save(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open recording " + path + " for writing");
+    }
+    file << "DNGREC " << VERSION << '\n'
+         << "seed " << seed << '\n'
+         << "map " << mapWidth << ' ' << mapHeight << '\n'
+         << "npcs " << npcCount << '\n'
+         << "ticks " << ticks << '\n'
+         << "fights " << fights.size() << '\n';
+    for (const auto& fight : fights) {
+        file << fight.tick << ' ' << fight.attacker << ' ' << fight.defender << ' '
+             << (fight.killed ? 'K' : 'S') << '\n';
+    }
+    if (!file) {
+        throw std::runtime_error("Cannot write recording " + path);
+    }
+}
+
+Recording Recording::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open recording " + path);
+    }
+
+    Recording recording;
+    std::uint32_t version = 0;
+    if (!(field(file, "DNGREC", path) >> version)) {
+        throw std::runtime_error("Not a recording file: " + path);
+    }
+    if (version != VERSION) {
+        throw std::runtime_error("Unsupported recording version " + std::to_string(version));
+    }
+    std::size_t count = 0;
+    if (!(field(file, "seed", path) >> recording.seed) ||
+        !(field(file, "map", path) >> recording.mapWidth >> recording.mapHeight) ||
+        !(field(file, "npcs", path) >> recording.npcCount) ||
+        !(field(file, "ticks", path) >> recording.ticks) ||
+        !(field(file, "fights", path) >> count)) {
+        throw std::runtime_error("Recording " + path + " has a corrupted header");
+    }
+
+    recording.fights.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        FightRecord fight;
+        char outcome = 0;
+        if (!(file >> fight.tick >> fight.attacker >> fight.defender >> outcome) ||
+            (outcome != 'K' && outcome != 'S')) {
+            throw std::runtime_error("Recording " + path + ": bad fight #" + std::to_string(i + 1));
+        }
+        fight.killed = outcome == 'K';
+        recording.fights.push_back(fight);
+    }
+    return recording;
+}
+
+std::string firstDifference(const Recording& expected, const Recording& actual) {
+    if (expected.seed != actual.seed) {
+        return "seed " + std::to_string(expected.seed) + " != " + std::to_string(actual.seed);
+    }
+    if (expected.mapWidth != actual.mapWidth || expected.mapHeight != actual.mapHeight) {
+        return "map size differs";
+    }
+    if (expected.npcCount != actual.npcCount) {
+        return "NPC count " + std::to_string(expected.npcCount) + " != " +
+               std::to_string(actual.npcCount);
+    }
+
+    std::size_t common = std::min(expected.fights.size(), actual.fights.size());
+    for (std::size_t i = 0; i < common; ++i) {
+        if (expected.fights[i] != actual.fights[i]) {
+            return "fight #" + std::to_string(i + 1) + ": expected " +
+                   describe(expected.fights[i]) + ", got " + describe(actual.fights[i]);
+        }
+    }
+    if (expected.fights.size() > common) {
+        return "missing fight #" + std::to_string(common + 1) + ": " +
+               describe(expected.fights[common]);
+    }
+    if (actual.fights.size() > common) {
+        return "extra fight #" + std::to_string(common + 1) + ": " +
+               describe(actual.fights[common]);
+    }
+    return "";
+}
@@ -0,0 +1,54 @@
+#include "shard_balance.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace shard_balance {
+
+double imbalance(const std::vector<double>& loads) {
+    if (loads.empty()) return 1.0;
+    double total = 0.0;
+    double peak = 0.0;
+    for (double load : loads) {
+        total += load;
+        peak = std::max(peak, load);
+    }
+    if (total <= 0.0) return 1.0;
+    return peak * static_cast<double>(loads.size()) / total;
+}
+
+std::vector<int> split(const std::vector<double>& rowCosts, std::size_t shards) {
+    std::size_t rows = rowCosts.size();
+    if (shards == 0 || rows < shards) {
+        throw std::invalid_argument("shard_balance::split: need at least one row per shard");
+    }
+
+    // prefix[r] - цена строк [0, r)
+    std::vector<double> prefix(rows + 1, 0.0);
+    for (std::size_t r = 0; r < rows; ++r) {
+        prefix[r + 1] = prefix[r] + std::max(0.0, rowCosts[r]);
+    }
+    double total = prefix[rows];
+
+    std::vector<int> firstRows(shards, 0);
+    for (std::size_t s = 1; s < shards; ++s) {
+        std::size_t boundary;
+        if (total <= 0.0) {
+            boundary = rows * s / shards;
+        } else {
+            // Граница, на которой цена слева ближе всего к доле s / shards
+            double target = total * static_cast<double>(s) / static_cast<double>(shards);
+            boundary = static_cast<std::size_t>(
+                std::lower_bound(prefix.begin(), prefix.end(), target) - prefix.begin());
+            if (boundary > 0 && target - prefix[boundary - 1] < prefix[boundary] - target) {
+                --boundary;
+            }
+        }
+        // Каждой полосе - хотя бы одна строка, и слева, и справа
+        std::size_t lowest = static_cast<std::size_t>(firstRows[s - 1]) + 1;
+        std::size_t highest = rows - (shards - s);
+        firstRows[s] = static_cast<int>(std::min(highest, std::max(lowest, boundary)));
+    }
+    return firstRows;
+}
+
+} // namespace shard_balance
@@ -0,0 +1,82 @@
+#include "shard_pool.h"
+#include <stdexcept>
+
+ShardPool::ShardPool(std::size_t shards)
+    : job(nullptr), generation(0), remaining(0), closed(false) {
+    if (shards == 0) {
+        throw std::invalid_argument("ShardPool: at least one shard is required");
+    }
+    for (std::size_t shard = 1; shard < shards; ++shard) {
+        workers.emplace_back(&ShardPool::workerLoop, this, shard);
+    }
+}
+
+ShardPool::~ShardPool() {
+    {
+        std::lock_guard lock(mutex);
+        closed = true;
+    }
+    startCV.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ShardPool::run(const Job& phase) {
+    if (workers.empty()) {
+        phase(0);
+        return;
+    }
+
+    {
+        std::lock_guard lock(mutex);
+        job = &phase;
+        remaining = workers.size();
+        failure = nullptr;
+        ++generation;
+    }
+    startCV.notify_all();
+
+    runShard(0);
+
+    std::unique_lock lock(mutex);
+    doneCV.wait(lock, [this]() { return remaining == 0; });
+    job = nullptr;
+    if (failure) {
+        std::exception_ptr error = failure;
+        failure = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void ShardPool::runShard(std::size_t shard) {
+    try {
+        (*job)(shard);
+    } catch (...) {
+        std::lock_guard lock(mutex);
+        if (!failure) failure = std::current_exception();
+    }
+}
+
+void ShardPool::workerLoop(std::size_t shard) {
+    std::size_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock lock(mutex);
+            startCV.wait(lock, [&]() { return closed || generation != seen; });
+            if (closed) return;
+            seen = generation;
+        }
+
+        runShard(shard);
+
+        std::lock_guard lock(mutex);
+        if (--remaining == 0) {
+            doneCV.notify_one();
+        }
+    }
+}
+
+std::size_t ShardPool::size() const {
+    return workers.size() + 1;
+}
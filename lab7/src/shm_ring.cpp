@@ -0,0 +1,119 @@
+#include "shm_ring.h"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace shm {
+
+namespace {
+
+std::runtime_error systemError(const std::string& what, const std::string& name) {
+    return std::runtime_error(what + " " + name + ": " + std::strerror(errno));
+}
+
+std::atomic<unsigned> segmentCounter{0};
+
+} // namespace
+
+Segment::Segment(std::size_t bytes) : data(nullptr), length(bytes) {
+    if (bytes == 0) {
+        throw std::invalid_argument("Shared memory segment must not be empty");
+    }
+    name = "/dungeon_" + std::to_string(::getpid()) + "_" + std::to_string(segmentCounter++);
+
+    int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        throw systemError("Cannot create shared memory", name);
+    }
+    if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        throw systemError("Cannot size shared memory", name);
+    }
+    void* mapped = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    // Имя больше не нужно: потомки получат отображение через fork()
+    ::shm_unlink(name.c_str());
+    if (mapped == MAP_FAILED) {
+        throw systemError("Cannot map shared memory", name);
+    }
+    data = mapped;
+}
+
+Segment::~Segment() {
+    if (data) {
+        ::munmap(data, length);
+    }
+}
+
+std::size_t Ring::bytes(std::size_t capacity) {
+    return sizeof(Header) + capacity * sizeof(Message);
+}
+
+Ring Ring::create(void* memory, std::size_t capacity) {
+    if (capacity == 0) {
+        throw std::invalid_argument("Ring capacity must be positive");
+    }
+    auto* header = new (memory) Header;
+    header->head.store(0, std::memory_order_relaxed);
+    header->tail.store(0, std::memory_order_relaxed);
+    header->capacity = static_cast<std::uint32_t>(capacity);
+    return attach(memory);
+}
+
+Ring Ring::attach(void* memory) {
+    Ring ring;
+    ring.header = static_cast<Header*>(memory);
+    ring.slots = reinterpret_cast<Message*>(static_cast<char*>(memory) + sizeof(Header));
+    return ring;
+}
+
+bool Ring::tryPush(const Message& message) {
+    std::uint64_t tail = header->tail.load(std::memory_order_relaxed);
+    if (tail - header->head.load(std::memory_order_acquire) >= header->capacity) {
+        return false;
+    }
+    slots[tail % header->capacity] = message;
+    header->tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+bool Ring::tryPop(Message& message) {
+    std::uint64_t head = header->head.load(std::memory_order_relaxed);
+    if (head == header->tail.load(std::memory_order_acquire)) {
+        return false;
+    }
+    message = slots[head % header->capacity];
+    header->head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+std::size_t Ring::size() const {
+    return static_cast<std::size_t>(header->tail.load(std::memory_order_acquire) -
+                                    header->head.load(std::memory_order_acquire));
+}
+
+void Barrier::init(std::uint32_t count) {
+    arrived.store(0, std::memory_order_relaxed);
+    generation.store(0, std::memory_order_relaxed);
+    parties = count;
+}
+
+void backoff(unsigned& spins) {
+    if (++spins < 64) {
+        ::sched_yield();
+        return;
+    }
+    // Долгое ожидание: не отнимаем ядро у процессов, которые работают
+    timespec pause{0, 50000};
+    ::nanosleep(&pause, nullptr);
+}
+
+} // namespace shm
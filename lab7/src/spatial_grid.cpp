@@ -0,0 +1,81 @@
+#include "spatial_grid.h"
+#include <algorithm>
+#include <stdexcept>
+
+SpatialGrid::SpatialGrid(int width, int height, int cellSize)
+    : SpatialGrid(width, height, cellSize, 0, cellSize > 0 ? rowCount(height, cellSize) : 1) {
+}
+
+SpatialGrid::SpatialGrid(int width, int height, int cellSize, int rowBegin, int rowEnd)
+    : cellSize(cellSize), cols(0), rows(0), firstRow(rowBegin), count(0) {
+    if (width <= 0 || height <= 0 || cellSize <= 0) {
+        throw std::invalid_argument("SpatialGrid: size must be positive");
+    }
+    if (rowBegin < 0 || rowBegin >= rowEnd || rowEnd > rowCount(height, cellSize)) {
+        throw std::invalid_argument("SpatialGrid: bad row range");
+    }
+
+    // Координаты на карте лежат в [0, width] x [0, height]
+    cols = width / cellSize + 1;
+    rows = rowEnd - rowBegin;
+    cells.resize(static_cast<std::size_t>(cols) * rows);
+}
+
+int SpatialGrid::cellColumn(int x) const {
+    return std::max(0, std::min(cols - 1, x / cellSize));
+}
+
+int SpatialGrid::cellRow(int y) const {
+    return std::max(0, std::min(rows - 1, y / cellSize - firstRow));
+}
+
+std::vector<std::uint32_t>& SpatialGrid::cellAt(int x, int y) {
+    return cells[cellRow(y) * cols + cellColumn(x)];
+}
+
+void SpatialGrid::insert(std::uint32_t id, int x, int y) {
+    cellAt(x, y).push_back(id);
+    ++count;
+}
+
+void SpatialGrid::remove(std::uint32_t id, int x, int y) {
+    auto& cell = cellAt(x, y);
+    auto it = std::find(cell.begin(), cell.end(), id);
+    if (it == cell.end()) return;
+
+    // Порядок внутри ячейки не важен, удаляем через swap с последним
+    *it = cell.back();
+    cell.pop_back();
+    --count;
+}
+
+void SpatialGrid::move(std::uint32_t id, int oldX, int oldY, int newX, int newY) {
+    if (cellColumn(oldX) == cellColumn(newX) && cellRow(oldY) == cellRow(newY)) {
+        return;
+    }
+    remove(id, oldX, oldY);
+    insert(id, newX, newY);
+}
+
+void SpatialGrid::clearRow(int row) {
+    auto* line = &cells[static_cast<std::size_t>(row - firstRow) * cols];
+    for (int c = 0; c < cols; ++c) {
+        count -= line[c].size();
+        line[c].clear();
+    }
+}
+
+void SpatialGrid::clear() {
+    for (auto& cell : cells) {
+        cell.clear();
+    }
+    count = 0;
+}
+
+int SpatialGrid::getCellSize() const {
+    return cellSize;
+}
+
+std::size_t SpatialGrid::size() const {
+    return count;
+}
@@ -0,0 +1,89 @@
+#include "world.h"
+#include <stdexcept>
+
+World::World(int width, int height)
+    : width(width), height(height), count(0), capacity(0),
+      rowLocks(std::make_unique<RowLock[]>(LOCK_STRIPES)), hasOwnObservers(false) {
+    if (width <= 0 || height <= 0) {
+        throw std::invalid_argument("World: size must be positive");
+    }
+}
+
+void World::reserve(std::size_t n) {
+    if (n <= capacity) return;
+
+    xs.reserve(n);
+    ys.reserve(n);
+    types.reserve(n);
+    moveDistances.reserve(n);
+    killDistances.reserve(n);
+    names.reserve(n);
+
+    // Атомарные флаги нельзя перемещать, поэтому массив копируется вручную
+    auto grownAlive = std::make_unique<std::atomic<std::uint8_t>[]>(n);
+    auto grownPending = std::make_unique<std::atomic<std::uint8_t>[]>(n);
+    for (std::size_t i = 0; i < count; ++i) {
+        grownAlive[i].store(alive[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        grownPending[i].store(pending[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    alive = std::move(grownAlive);
+    pending = std::move(grownPending);
+    capacity = n;
+}
+
+NpcHandle World::add(NpcType type, int x, int y, bool isAlive,
+                     int moveDistance, int killDistance, std::string name) {
+    if (count == capacity) {
+        reserve(capacity == 0 ? 64 : capacity * 2);
+    }
+
+    xs.push_back(x);
+    ys.push_back(y);
+    types.push_back(static_cast<std::uint8_t>(type));
+    moveDistances.push_back(static_cast<std::int16_t>(moveDistance));
+    killDistances.push_back(static_cast<std::int16_t>(killDistance));
+    names.push_back(std::move(name));
+    alive[count].store(isAlive ? 1 : 0, std::memory_order_relaxed);
+    pending[count].store(0, std::memory_order_relaxed);
+
+    return static_cast<NpcHandle>(count++);
+}
+
+void World::clear() {
+    xs.clear();
+    ys.clear();
+    types.clear();
+    moveDistances.clear();
+    killDistances.clear();
+    names.clear();
+    {
+        std::unique_lock lock(observersMutex);
+        observerTable.clear();
+        hasOwnObservers.store(false, std::memory_order_release);
+    }
+    count = 0;
+}
+
+std::shared_ptr<const ObserverList> World::ownObservers(NpcHandle h) const {
+    // Без подписчиков уведомления не трогают общий мьютекс таблицы
+    if (!hasOwnObservers.load(std::memory_order_acquire)) return nullptr;
+    std::shared_lock lock(observersMutex);
+    auto it = observerTable.find(h);
+    return it == observerTable.end() ? nullptr : it->second;
+}
+
+void World::setOwnObservers(NpcHandle h, std::shared_ptr<const ObserverList> list) {
+    std::unique_lock lock(observersMutex);
+    if (list) {
+        observerTable[h] = std::move(list);
+        hasOwnObservers.store(true, std::memory_order_release);
+    } else {
+        observerTable.erase(h);
+    }
+}
+
+void World::clearAllPending() {
+    for (std::size_t i = 0; i < count; ++i) {
+        pending[i].store(0, std::memory_order_release);
+    }
+}
@@ -0,0 +1,81 @@
+#include "world_snapshot.h"
+#include <thread>
+
+std::size_t WorldSnapshot::size() const {
+    return x.size();
+}
+
+void WorldSnapshot::resize(std::size_t count) {
+    x.resize(count);
+    y.resize(count);
+    type.resize(count, NpcType::Unknown);
+    alive.resize(count);
+}
+
+SnapshotBuffer::ReadGuard::ReadGuard(const SnapshotBuffer* owner, int index)
+    : owner(owner), index(index) {}
+
+SnapshotBuffer::ReadGuard::ReadGuard(ReadGuard&& other) noexcept
+    : owner(other.owner), index(other.index) {
+    other.owner = nullptr;
+}
+
+SnapshotBuffer::ReadGuard::~ReadGuard() {
+    if (owner) {
+        owner->readers[index].fetch_sub(1, std::memory_order_release);
+    }
+}
+
+const WorldSnapshot& SnapshotBuffer::ReadGuard::operator*() const {
+    return owner->buffers[index];
+}
+
+const WorldSnapshot* SnapshotBuffer::ReadGuard::operator->() const {
+    return &owner->buffers[index];
+}
+
+SnapshotBuffer::SnapshotBuffer() : front(0) {
+    readers[0] = 0;
+    readers[1] = 0;
+}
+
+WorldSnapshot& SnapshotBuffer::beginWrite() {
+    int current = front.load(std::memory_order_relaxed);
+    int back = 1 - current;
+
+    // Ждем читателей, успевших взять этот буфер до прошлой публикации
+    while (readers[back].load(std::memory_order_seq_cst) != 0) {
+        std::this_thread::yield();
+    }
+
+    WorldSnapshot& snapshot = buffers[back];
+    const WorldSnapshot& previous = buffers[current];
+    snapshot.tick = previous.tick;
+    snapshot.x = previous.x;
+    snapshot.y = previous.y;
+    snapshot.type = previous.type;
+    snapshot.alive = previous.alive;
+    return snapshot;
+}
+
+void SnapshotBuffer::publish() {
+    front.store(1 - front.load(std::memory_order_relaxed), std::memory_order_seq_cst);
+}
+
+SnapshotBuffer::ReadGuard SnapshotBuffer::read() const {
+    for (;;) {
+        int index = front.load(std::memory_order_acquire);
+        readers[index].fetch_add(1, std::memory_order_seq_cst);
+        // Если буфер успели сменить, писатель мог уже начать его перезапись
+        if (front.load(std::memory_order_seq_cst) == index) {
+            return ReadGuard(this, index);
+        }
+        readers[index].fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void SnapshotBuffer::reset(const WorldSnapshot& snapshot) {
+    buffers[0] = snapshot;
+    buffers[1] = snapshot;
+    front.store(0, std::memory_order_seq_cst);
+}
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include "battle_pool.h"
+#include "knight.h"
+#include "dragon.h"
+
+class BattlePoolTest : public ::testing::Test {
+protected:
+    // Ждем, пока обработчик не увидит expected задач
+    static bool waitFor(const std::atomic<int>& counter, int expected) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (counter < expected) {
+            if (std::chrono::steady_clock::now() > deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+};
+
+TEST_F(BattlePoolTest, ProcessesAllTasks) {
+    BattlePool pool(4, 64);
+    std::atomic<int> handled(0);
+    pool.start([&](const BattleTask&) { ++handled; });
+
+    auto attacker = std::make_shared<Knight>(0, 0, "K");
+    for (int i = 0; i < 1000; ++i) {
+        auto defender = std::make_shared<Dragon>(0, 0, "D");
+        defender->setId(static_cast<std::uint32_t>(i));
+        EXPECT_TRUE(pool.submit({attacker, defender}));
+    }
+
+    EXPECT_TRUE(waitFor(handled, 1000));
+    pool.stop();
+    EXPECT_EQ(handled, 1000);
+}
+
+TEST_F(BattlePoolTest, IdleWorkersStealWork) {
+    // Все задачи попадают в одну очередь (один защищающийся),
+    // но выполняются разными потоками
+    BattlePool pool(4, 1024);
+    std::atomic<int> handled(0);
+    std::atomic<int> concurrent(0);
+    std::atomic<int> maxConcurrent(0);
+
+    auto attacker = std::make_shared<Knight>(0, 0, "K");
+    auto defender = std::make_shared<Dragon>(0, 0, "D");
+
+    for (int i = 0; i < 200; ++i) {
+        pool.submit({attacker, defender});
+    }
+
+    pool.start([&](const BattleTask&) {
+        int now = ++concurrent;
+        int prev = maxConcurrent;
+        while (now > prev && !maxConcurrent.compare_exchange_weak(prev, now)) {
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        --concurrent;
+        ++handled;
+    });
+
+    EXPECT_TRUE(waitFor(handled, 200));
+    pool.stop();
+    EXPECT_GT(maxConcurrent, 1);
+}
+
+TEST_F(BattlePoolTest, StopRejectsNewTasks) {
+    BattlePool pool(2, 16);
+    pool.start([](const BattleTask&) {});
+    pool.stop();
+
+    auto npc = std::make_shared<Knight>(0, 0, "K");
+    EXPECT_FALSE(pool.submit({npc, npc}));
+}
+
+TEST_F(BattlePoolTest, DefaultWorkerCount) {
+    BattlePool pool(0, 16);
+    EXPECT_GE(pool.workerCount(), 1);
+}
@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include "binary_snapshot.h"
+#include "dragon.h"
+#include "knight.h"
+#include "pegasus.h"
+#include "game.h"
+
+class BinarySnapshotTest : public ::testing::Test {
+protected:
+    const std::string path = "test_snapshot.bin";
+
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+};
+
+TEST_F(BinarySnapshotTest, ColumnsRoundTrip) {
+    snapshot::Columns columns;
+    columns.seed = 42;
+    columns.tick = 17;
+    columns.mapWidth = 800;
+    columns.mapHeight = 600;
+    columns.add(5, NpcType::Dragon, 10, 20, true, "Smaug");
+    columns.add(9, NpcType::Knight, 799, 0, false, "");
+    columns.add(11, NpcType::Pegasus, 3, 599, true, "Peggy the Pegasus");
+    snapshot::write(path, columns);
+
+    snapshot::MappedSnapshot snap(path);
+    EXPECT_EQ(snap.size(), 3u);
+    EXPECT_EQ(snap.header().seed, 42u);
+    EXPECT_EQ(snap.header().tick, 17u);
+    EXPECT_EQ(snap.header().mapWidth, 800);
+    EXPECT_EQ(snap.ids()[2], 11u);
+    EXPECT_EQ(snap.type(0), NpcType::Dragon);
+    EXPECT_EQ(snap.x()[1], 799);
+    EXPECT_EQ(snap.y()[2], 599);
+    EXPECT_EQ(snap.alive()[1], 0);
+    EXPECT_EQ(snap.name(0), "Smaug");
+    EXPECT_EQ(snap.name(1), "");
+    EXPECT_EQ(snap.name(2), "Peggy the Pegasus");
+}
+
+TEST_F(BinarySnapshotTest, EmptySnapshot) {
+    snapshot::write(path, snapshot::Columns());
+    snapshot::MappedSnapshot snap(path);
+    EXPECT_EQ(snap.size(), 0u);
+}
+
+TEST_F(BinarySnapshotTest, RejectsBadFiles) {
+    EXPECT_THROW(snapshot::MappedSnapshot("missing_snapshot.bin"), std::runtime_error);
+
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "2\n10\n20\nArthur\n1\n\n";
+    }
+    EXPECT_THROW(snapshot::MappedSnapshot snap(path), std::runtime_error);
+
+    // Обрезанный файл: заголовок обещает больше данных, чем есть
+    snapshot::Columns columns;
+    for (int i = 0; i < 100; ++i) {
+        columns.add(i, NpcType::Knight, i, i, true, "Knight_" + std::to_string(i));
+    }
+    snapshot::write(path, columns);
+    {
+        std::ifstream in(path, std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size() / 2));
+    }
+    EXPECT_THROW(snapshot::MappedSnapshot snap(path), std::runtime_error);
+}
+
+TEST_F(BinarySnapshotTest, ConvertsTextFormat) {
+    std::stringstream text;
+    text << "3\n\n";
+    Dragon(10, 20, "Smaug").save(text);
+    Knight knight(30, 40, "Arthur");
+    knight.setAlive(false);
+    knight.save(text);
+    Pegasus(50, 60, "Peggy").save(text);
+
+    EXPECT_EQ(snapshot::convertText(text, path), 3u);
+
+    snapshot::MappedSnapshot snap(path);
+    ASSERT_EQ(snap.size(), 3u);
+    EXPECT_EQ(snap.type(1), NpcType::Knight);
+    EXPECT_EQ(snap.x()[1], 30);
+    EXPECT_EQ(snap.alive()[1], 0);
+    EXPECT_EQ(snap.name(2), "Peggy");
+    EXPECT_EQ(snap.ids()[2], 2u);
+}
+
+TEST_F(BinarySnapshotTest, ConvertsWithoutCountLine) {
+    std::stringstream text;
+    Knight(1, 2, "A").save(text);
+    Knight(3, 4, "B").save(text);
+    EXPECT_EQ(snapshot::convertText(text, path), 2u);
+}
+
+TEST_F(BinarySnapshotTest, RejectsRecordsOutsideMap) {
+    std::stringstream text;
+    text << "2\n\n";
+    Knight(10, 20, "Arthur").save(text);
+    Dragon(900, 700, "Smaug").save(text);
+    try {
+        snapshot::convertText(text, path, 500, 500);
+        FAIL() << "record outside the map was converted";
+    } catch (const std::runtime_error& e) {
+        EXPECT_NE(std::string(e.what()).find("#2 (Smaug)"), std::string::npos) << e.what();
+    }
+    std::ifstream converted(path);
+    EXPECT_FALSE(converted.is_open());
+
+    // Снимок, записанный в обход проверки, не загружается
+    snapshot::Columns columns;
+    columns.add(0, NpcType::Knight, 10, 20, true, "Arthur");
+    columns.add(1, NpcType::Dragon, 499, 500, true, "Smaug");
+    snapshot::write(path, columns);
+    EXPECT_THROW(snapshot::MappedSnapshot snap(path), std::runtime_error);
+
+    GameConfig config;
+    config.headless = true;
+    Game game(config);
+    try {
+        game.loadSnapshot(path);
+        FAIL() << "snapshot with a record outside the map was loaded";
+    } catch (const std::runtime_error& e) {
+        EXPECT_NE(std::string(e.what()).find("record 1"), std::string::npos) << e.what();
+    }
+
+    columns.x[1] = -1;
+    columns.y[1] = 0;
+    snapshot::write(path, columns);
+    EXPECT_THROW(snapshot::MappedSnapshot snap(path), std::runtime_error);
+}
+
+TEST_F(BinarySnapshotTest, GameSaveAndLoad) {
+    GameConfig config;
+    config.headless = true;
+    config.npcCount = 200;
+    config.seed = 99;
+
+    Game original(config);
+    original.initialize();
+    original.movementTick();
+    original.saveSnapshot(path);
+
+    Game restored(config);
+    restored.loadSnapshot(path);
+    EXPECT_EQ(restored.npcCount(), 200u);
+    EXPECT_EQ(restored.getSeed(), 99u);
+
+    // Повторное сохранение дает тот же файл
+    std::string second = path + ".2";
+    restored.saveSnapshot(second);
+    auto read = [](const std::string& file) {
+        std::ifstream in(file, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    };
+    EXPECT_EQ(read(path), read(second));
+    std::remove(second.c_str());
+
+    GameConfig other = config;
+    other.mapWidth = 300;
+    Game mismatched(other);
+    EXPECT_THROW(mismatched.loadSnapshot(path), std::runtime_error);
+}
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+#include "cluster.h"
+#include "game.h"
+
+namespace {
+
+GameConfig clusterConfig() {
+    GameConfig config;
+    config.headless = true;
+    config.record = true;
+    config.mapWidth = 120;
+    config.mapHeight = 120;
+    config.npcCount = 600;
+    config.maxTicks = 40;
+    config.seed = 77;
+    return config;
+}
+
+} // namespace
+
+TEST(ClusterTest, MatchesSingleProcessGame) {
+    GameConfig config = clusterConfig();
+    Game game(config);
+    game.initialize();
+    SimulationStats single = game.runHeadless();
+    Recording expected = game.recording();
+    ASSERT_FALSE(expected.fights.empty());
+
+    for (std::size_t processes : {1u, 2u, 3u, 7u}) {
+        cluster::Options options;
+        options.processes = processes;
+        cluster::Coordinator coordinator(config, options);
+        SimulationStats stats = coordinator.run();
+        Recording actual = coordinator.recording();
+
+        EXPECT_EQ(firstDifference(expected, actual), "") << processes << " processes";
+        EXPECT_EQ(stats.fights, single.fights) << processes << " processes";
+        EXPECT_EQ(stats.kills, single.kills) << processes << " processes";
+        EXPECT_EQ(stats.ticks, config.maxTicks);
+        if (single.ticks == config.maxTicks) {
+            EXPECT_EQ(stats.survivors, single.survivors) << processes << " processes";
+        }
+    }
+}
+
+TEST(ClusterTest, SmallRingsDoNotDeadlock) {
+    GameConfig config = clusterConfig();
+    config.maxTicks = 15;
+
+    cluster::Options wide;
+    wide.processes = 3;
+    cluster::Coordinator reference(config, wide);
+    reference.run();
+
+    // Кольцо на несколько сообщений: отправители ждут, разбирая входящие
+    cluster::Options narrow;
+    narrow.processes = 3;
+    narrow.ringCapacity = 4;
+    cluster::Coordinator coordinator(config, narrow);
+    coordinator.run();
+    EXPECT_EQ(firstDifference(reference.recording(), coordinator.recording()), "");
+}
+
+TEST(ClusterTest, RejectsBadOptions) {
+    GameConfig config = clusterConfig();
+    cluster::Options options;
+    options.processes = 0;
+    EXPECT_THROW(cluster::Coordinator(config, options), std::invalid_argument);
+
+    options.processes = static_cast<std::size_t>(config.mapHeight) + 1;
+    EXPECT_THROW(cluster::Coordinator(config, options), std::invalid_argument);
+
+    options.processes = 2;
+    options.ringCapacity = 0;
+    EXPECT_THROW(cluster::Coordinator(config, options), std::invalid_argument);
+}
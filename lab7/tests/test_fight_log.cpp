@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include "fight_log.h"
+#include "observer.h"
+#include "dragon.h"
+#include "knight.h"
+
+namespace {
+
+// Приемник, собирающий текст; пишет только поток лога
+struct Collector {
+    std::mutex mutex;
+    std::string text;
+    int blocks = 0;
+
+    FightLog::Writer writer() {
+        return [this](const std::string& block) {
+            std::lock_guard lock(mutex);
+            text += block;
+            ++blocks;
+        };
+    }
+
+    std::string get() {
+        std::lock_guard lock(mutex);
+        return text;
+    }
+};
+
+void numbered(const FightEvent& event, std::string& out) {
+    out += std::to_string(event.tick);
+    out += ";";
+}
+
+} // namespace
+
+TEST(FightLogTest, WritesEventsInOrder) {
+    Collector collector;
+    FightLog log(std::chrono::milliseconds(1000));
+    std::uint32_t channel = log.addChannel(numbered, log.addSink(collector.writer()));
+
+    std::string expected;
+    for (std::uint32_t i = 0; i < 1000; ++i) {
+        FightEvent event;
+        event.channel = channel;
+        event.tick = i;
+        ASSERT_TRUE(log.push(event));
+        expected += std::to_string(i) + ";";
+    }
+
+    // flush не ждет интервал сброса
+    auto start = std::chrono::steady_clock::now();
+    log.flush();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(900));
+    EXPECT_EQ(collector.get(), expected);
+    EXPECT_EQ(log.dropped(), 0u);
+}
+
+TEST(FightLogTest, FlushIntervalWritesWithoutStop) {
+    Collector collector;
+    FightLog log(std::chrono::milliseconds(20));
+    std::uint32_t channel = log.addChannel(numbered, log.addSink(collector.writer()));
+
+    FightEvent event;
+    event.channel = channel;
+    event.tick = 7;
+    log.push(event);
+
+    for (int i = 0; i < 200 && collector.get().empty(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(collector.get(), "7;");
+}
+
+TEST(FightLogTest, StopWritesRemainingAndRejectsNew) {
+    Collector collector;
+    FightLog log(std::chrono::milliseconds(10000));
+    std::uint32_t channel = log.addChannel(numbered, log.addSink(collector.writer()));
+
+    FightEvent event;
+    event.channel = channel;
+    for (std::uint32_t i = 0; i < 10; ++i) {
+        event.tick = i;
+        log.push(event);
+    }
+    log.stop();
+    EXPECT_EQ(collector.get(), "0;1;2;3;4;5;6;7;8;9;");
+
+    EXPECT_FALSE(log.push(event));
+    EXPECT_EQ(log.dropped(), 1u);
+}
+
+TEST(FightLogTest, ChannelsShareSinkInOrder) {
+    Collector collector;
+    FightLog log(std::chrono::milliseconds(1000));
+    std::uint32_t sink = log.addSink(collector.writer());
+    std::uint32_t fileChannel = log.addChannel(fight_format::file, sink);
+    std::uint32_t battleChannel = log.addChannel(fight_format::battle, sink);
+
+    Dragon dragon(10, 20, "Smaug");
+    Knight knight(30, 40, "Arthur");
+    FightEvent event = FightEvent::make(knight, dragon, true);
+    event.channel = fileChannel;
+    log.push(event);
+    event.channel = battleChannel;
+    event.attackPower = 6;
+    event.defensePower = 2;
+    log.push(event);
+    log.flush();
+
+    EXPECT_EQ(collector.get(),
+              "Battle: Knight 'Arthur' at (30, 40) killed Dragon 'Smaug' at (10, 20)\n"
+              "Arthur killed Smaug (Attack: 6 vs Defense: 2)\n");
+}
+
+TEST(FightLogTest, LongNamesAreTruncated) {
+    Dragon dragon(0, 0, std::string(100, 'd'));
+    Knight knight(0, 0, "k");
+    FightEvent event = FightEvent::make(dragon, knight, false);
+    EXPECT_EQ(std::string(event.attackerName), std::string(FightEvent::NAME_SIZE - 1, 'd'));
+}
@@ -3,6 +3,7 @@
 #include <chrono>
 #include <atomic>
 #include <fstream>  // Добавляем для std::ofstream
+#include <cstdio>
 #include <memory>
 #include "game.h"
 #include "factory.h"
@@ -192,4 +193,151 @@ TEST_F(GameTest, ThreadCreation) {
     t2.join();
     
     EXPECT_EQ(counter, 3);
-}
\ No newline at end of file
+}
+
+TEST_F(GameTest, HeadlessRunStopsAtTickLimit) {
+    GameConfig config;
+    config.headless = true;
+    config.npcCount = 300;
+    config.maxTicks = 20;
+    config.battleWorkers = 2;
+    config.seed = 7;
+
+    Game game(config);
+    game.initialize();
+    SimulationStats stats = game.runHeadless();
+
+    EXPECT_GT(stats.ticks, 0);
+    EXPECT_LE(stats.ticks, 20);
+    EXPECT_LE(stats.kills, stats.fights);
+    EXPECT_EQ(stats.survivors + stats.kills, 300u);
+}
+
+TEST_F(GameTest, HeadlessRunWritesKillsToFileLog) {
+    std::remove("game_log.txt");
+    GameConfig config;
+    config.headless = true;
+    config.npcCount = 300;
+    config.maxTicks = 20;
+    config.seed = 7;
+
+    SimulationStats stats;
+    {
+        Game game(config);
+        game.initialize();
+        stats = game.runHeadless();
+    }
+    ASSERT_GT(stats.kills, 0u);
+
+    std::ifstream log("game_log.txt");
+    std::size_t kills = 0;
+    std::string line;
+    while (std::getline(log, line)) {
+        if (line.rfind("Battle: ", 0) == 0) ++kills;
+    }
+    EXPECT_EQ(kills, stats.kills);
+}
+
+TEST_F(GameTest, ShardCountDoesNotChangeOutcome) {
+    // Узкая высокая карта: много строк ячеек и переходов между полосами
+    auto run = [](std::size_t shards, SimulationStats& stats) {
+        GameConfig config;
+        config.headless = true;
+        config.record = true;
+        config.mapWidth = 60;
+        config.mapHeight = 400;
+        config.npcCount = 800;
+        config.maxTicks = 40;
+        config.battleWorkers = 2;
+        config.movementShards = shards;
+        config.seed = 11;
+
+        Game game(config);
+        game.initialize();
+        EXPECT_EQ(game.shardCount(), shards);
+        stats = game.runHeadless();
+        return game.recording();
+    };
+
+    SimulationStats single;
+    Recording expected = run(1, single);
+    ASSERT_FALSE(expected.fights.empty());
+    for (std::size_t shards : {2u, 3u, 8u}) {
+        SimulationStats stats;
+        Recording actual = run(shards, stats);
+        EXPECT_EQ(firstDifference(expected, actual), "") << shards << " shards";
+        EXPECT_EQ(stats.survivors, single.survivors);
+    }
+}
+
+TEST_F(GameTest, ShardsAreLimitedByCellRows) {
+    GameConfig config;
+    config.mapHeight = 20;
+    config.movementShards = 64;
+
+    Game game(config);
+    game.initialize(50);
+    EXPECT_GE(game.shardCount(), 1u);
+    EXPECT_LT(game.shardCount(), 64u);
+    EXPECT_GE(game.movementTick(), 0u);
+}
+
+TEST_F(GameTest, HeadlessRunStopsWithoutOpponents) {
+    // Живых типов меньше двух: такты не выполняются
+    GameConfig config;
+    config.headless = true;
+    config.npcCount = 0;
+    config.maxTicks = 1000;
+
+    Game game(config);
+    game.initialize();
+    EXPECT_EQ(game.runHeadless().ticks, 0);
+}
+
+TEST_F(GameTest, OnePendingAttackPerDefender) {
+    // Тесная карта: почти каждая пара в радиусе боя
+    GameConfig config;
+    config.headless = true;
+    config.mapWidth = 20;
+    config.mapHeight = 20;
+    config.npcCount = 200;
+    config.seed = 7;
+
+    Game game(config);
+    game.initialize();
+
+    // Пул не запущен, поэтому задачи остаются в очереди
+    std::size_t first = game.movementTick();
+    EXPECT_GT(first, 0u);
+    EXPECT_LE(first, 200u);
+
+    // Пока бои не разобраны, новые атаки идут только на свободные цели
+    std::size_t total = first;
+    for (int i = 0; i < 5; ++i) {
+        total += game.movementTick();
+    }
+    EXPECT_LE(total, 200u);
+    EXPECT_EQ(game.pendingBattles(), total);
+
+    // После очистки очереди цели снова доступны
+    game.clearBattleTasks();
+    EXPECT_GT(game.movementTick(), 0u);
+}
+
+TEST_F(GameTest, InvalidConfig) {
+    GameConfig config;
+    config.mapWidth = 0;
+    EXPECT_THROW(Game game(config), std::invalid_argument);
+
+    config = GameConfig();
+    config.tickMillis = 0;
+    EXPECT_THROW(Game game(config), std::invalid_argument);
+
+    config = GameConfig();
+    config.viewColumns = MapRenderer::MAX_VIEW_SIZE + 1;
+    EXPECT_THROW(Game game(config), std::invalid_argument);
+
+    config = GameConfig();
+    config.duration = 3;
+    EXPECT_EQ(config.tickLimit(), 30);
+}
@@ -0,0 +1,253 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include "journal.h"
+#include "factory.h"
+#include "game.h"
+#include "binary_snapshot.h"
+
+class JournalTest : public ::testing::Test {
+protected:
+    const std::string path = "test_journal.log";
+    std::vector<std::shared_ptr<NPC>> npcs;
+
+    void SetUp() override {
+        std::remove(path.c_str());
+        const NpcType types[] = {NpcType::Dragon, NpcType::Knight, NpcType::Pegasus};
+        for (std::uint32_t i = 0; i < 3; ++i) {
+            auto npc = NPCFactory::createNPC(types[i], 10 * i, 20 * i, "NPC " + std::to_string(i));
+            npc->setId(i + 5);
+            npcs.push_back(npc);
+        }
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+
+    static std::size_t fileSize(const std::string& file) {
+        std::ifstream in(file, std::ios::binary | std::ios::ate);
+        return static_cast<std::size_t>(in.tellg());
+    }
+};
+
+TEST_F(JournalTest, ReplaysSnapshotAndChanges) {
+    {
+        Journal journal(path);
+        journal.compact(npcs, 77, 3, 500, 500);
+        journal.move(5, 100, 200);
+        journal.kill(6);
+        journal.rename(7, "  Swift Wind ");
+        journal.tick(4);
+        journal.commit();
+    }
+
+    JournalState state = Journal::replay(path);
+    EXPECT_EQ(state.seed, 77u);
+    EXPECT_EQ(state.tick, 4u);
+    EXPECT_EQ(state.records, 4u);
+    EXPECT_FALSE(state.truncated);
+    ASSERT_EQ(state.npcs.size(), 3u);
+
+    EXPECT_EQ(state.npcs[0]->getId(), 5u);
+    EXPECT_EQ(state.npcs[0]->getX(), 100);
+    EXPECT_EQ(state.npcs[0]->getY(), 200);
+    EXPECT_FALSE(state.npcs[1]->isAlive());
+    EXPECT_TRUE(state.npcs[2]->isAlive());
+    EXPECT_EQ(state.npcs[2]->getName(), "Swift Wind");
+    EXPECT_EQ(state.npcs[2]->getType(), NpcType::Pegasus);
+}
+
+TEST_F(JournalTest, AddAfterSnapshot) {
+    Journal journal(path);
+    journal.compact(npcs, 1, 0, 500, 500);
+    auto knight = NPCFactory::createNPC(NpcType::Knight, 3, 4, "Late Knight");
+    knight->setId(2);
+    journal.add(*knight);
+    journal.commit();
+
+    JournalState state = Journal::replay(path);
+    ASSERT_EQ(state.npcs.size(), 4u);
+    EXPECT_EQ(state.npcs[0]->getName(), "Late Knight");
+    EXPECT_EQ(state.npcs[0]->getX(), 3);
+}
+
+TEST_F(JournalTest, UncommittedChangesAreNotWritten) {
+    Journal journal(path);
+    journal.compact(npcs, 1, 0, 500, 500);
+    journal.move(5, 1, 1);
+    EXPECT_GT(journal.changesSize(), 0u);
+    EXPECT_EQ(Journal::replay(path).npcs[0]->getX(), 0);
+}
+
+TEST_F(JournalTest, TornTailIsDropped) {
+    {
+        Journal journal(path);
+        journal.compact(npcs, 1, 0, 500, 500);
+        journal.move(5, 1, 1);
+        journal.commit();
+    }
+    {
+        // Запись, оборванная на середине строки
+        std::ofstream out(path, std::ios::app | std::ios::binary);
+        out << "M 5 9";
+    }
+    JournalState state = Journal::replay(path);
+    EXPECT_TRUE(state.truncated);
+    EXPECT_EQ(state.npcs[0]->getX(), 1);
+    EXPECT_EQ(state.npcs[0]->getY(), 1);
+
+    {
+        std::ofstream out(path, std::ios::app | std::ios::binary);
+        out << "\nX garbage\nK 5\n";
+    }
+    state = Journal::replay(path);
+    EXPECT_TRUE(state.truncated);
+    EXPECT_TRUE(state.npcs[0]->isAlive());
+}
+
+TEST_F(JournalTest, CompactionShrinksFile) {
+    Journal journal(path, 1024);
+    journal.compact(npcs, 1, 0, 500, 500);
+    std::size_t snapshot = fileSize(path);
+
+    for (int i = 0; i < 200 && !journal.needsCompaction(); ++i) {
+        journal.move(5, i, i);
+        journal.commit();
+    }
+    EXPECT_TRUE(journal.needsCompaction());
+    EXPECT_GT(fileSize(path), snapshot);
+
+    npcs[0]->setPosition(42, 43);
+    journal.compact(npcs, 1, 9, 500, 500);
+    EXPECT_EQ(fileSize(path), journal.snapshotSize());
+    EXPECT_EQ(journal.changesSize(), 0u);
+
+    JournalState state = Journal::replay(path);
+    EXPECT_EQ(state.records, 0u);
+    EXPECT_EQ(state.tick, 9u);
+    EXPECT_EQ(state.npcs[0]->getX(), 42);
+}
+
+TEST_F(JournalTest, RejectsOtherFiles) {
+    EXPECT_THROW(Journal::replay("missing_journal.log"), std::runtime_error);
+    {
+        std::ofstream out(path);
+        out << "3\n\n";
+    }
+    EXPECT_THROW(Journal::replay(path), std::runtime_error);
+
+    // Журнал старой версии, без размеров карты
+    {
+        std::ofstream out(path, std::ios::trunc);
+        out << "J 1 77 3\n";
+    }
+    EXPECT_THROW(Journal::replay(path), std::runtime_error);
+}
+
+TEST_F(JournalTest, RecordsOutsideMapAreCorruption) {
+    {
+        Journal journal(path);
+        journal.compact(npcs, 1, 0, 100, 100);
+        journal.move(5, 99, 99);
+        journal.move(5, 100, 50);
+        journal.kill(6);
+        journal.commit();
+    }
+    JournalState state = Journal::replay(path);
+    EXPECT_EQ(state.mapWidth, 100);
+    EXPECT_EQ(state.mapHeight, 100);
+    EXPECT_TRUE(state.truncated);
+    EXPECT_EQ(state.records, 1u);
+    EXPECT_EQ(state.npcs[0]->getX(), 99);
+    EXPECT_EQ(state.npcs[0]->getY(), 99);
+    EXPECT_TRUE(state.npcs[1]->isAlive());
+
+    // Добавление за краем карты
+    {
+        Journal journal(path);
+        journal.compact(npcs, 1, 0, 100, 100);
+        auto knight = NPCFactory::createNPC(NpcType::Knight, 30, -1, "Lost Knight");
+        knight->setId(2);
+        journal.add(*knight);
+        journal.commit();
+    }
+    state = Journal::replay(path);
+    EXPECT_TRUE(state.truncated);
+    EXPECT_EQ(state.npcs.size(), 3u);
+}
+
+TEST_F(JournalTest, GameRecoversFromJournal) {
+    GameConfig config;
+    config.headless = true;
+    config.npcCount = 300;
+    config.seed = 1234;
+    config.maxTicks = 20;
+    config.journalPath = path;
+
+    std::map<std::uint32_t, std::pair<int, int>> expected;
+    {
+        Game game(config);
+        game.initialize();
+        SimulationStats stats = game.runHeadless();
+        EXPECT_GT(stats.kills, 0u);
+        game.saveSnapshot(path + ".bin");
+    }
+    snapshot::MappedSnapshot snap(path + ".bin");
+    for (std::size_t i = 0; i < snap.size(); ++i) {
+        expected[snap.ids()[i]] = {snap.x()[i], snap.y()[i]};
+    }
+
+    GameConfig recoverConfig = config;
+    recoverConfig.journalPath.clear();
+    Game recovered(recoverConfig);
+    EXPECT_FALSE(recovered.recoverJournal(path));
+    EXPECT_EQ(recovered.getSeed(), 1234u);
+    recovered.saveSnapshot(path + ".bin");
+
+    // Выжившие совпадают по id и позициям
+    snapshot::MappedSnapshot restored(path + ".bin");
+    std::size_t alive = 0;
+    for (std::size_t i = 0; i < restored.size(); ++i) {
+        if (!restored.alive()[i]) continue;
+        ++alive;
+        auto found = expected.find(restored.ids()[i]);
+        ASSERT_NE(found, expected.end());
+        EXPECT_EQ(found->second.first, restored.x()[i]);
+        EXPECT_EQ(found->second.second, restored.y()[i]);
+    }
+    EXPECT_EQ(alive, expected.size());
+    std::remove((path + ".bin").c_str());
+}
+
+TEST_F(JournalTest, GameRefusesJournalOfOtherMap) {
+    GameConfig config;
+    config.headless = true;
+    config.npcCount = 200;
+    config.mapWidth = 2000;
+    config.mapHeight = 2000;
+    config.maxTicks = 5;
+    config.journalPath = path;
+    {
+        Game game(config);
+        game.initialize();
+        game.runHeadless();
+    }
+    std::string before;
+    {
+        std::ifstream in(path, std::ios::binary);
+        before.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    // Журнал карты 2000x2000 на карте по умолчанию не восстанавливается
+    // и не переписывается
+    GameConfig smaller;
+    smaller.headless = true;
+    smaller.journalPath = path;
+    Game game(smaller);
+    EXPECT_THROW(game.recoverJournal(path), std::runtime_error);
+    std::ifstream in(path, std::ios::binary);
+    std::string after((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(after, before);
+}
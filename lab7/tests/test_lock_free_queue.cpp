@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "lock_free_queue.h"
+
+TEST(LockFreeQueueTest, FifoOrder) {
+    LockFreeQueue<int> queue(8);
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_TRUE(queue.tryPush(i));
+    }
+    EXPECT_EQ(queue.size(), 5);
+
+    int value = -1;
+    for (int i = 0; i < 5; ++i) {
+        ASSERT_TRUE(queue.tryPop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(queue.tryPop(value));
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(LockFreeQueueTest, BoundedCapacity) {
+    LockFreeQueue<int> queue(4);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(queue.tryPush(i));
+    }
+    EXPECT_FALSE(queue.tryPush(4));
+
+    // Кольцо переиспользует освободившиеся ячейки
+    int value = 0;
+    ASSERT_TRUE(queue.tryPop(value));
+    EXPECT_TRUE(queue.tryPush(4));
+}
+
+TEST(LockFreeQueueTest, InvalidCapacity) {
+    EXPECT_THROW(LockFreeQueue<int>(3), std::invalid_argument);
+    EXPECT_THROW(LockFreeQueue<int>(0), std::invalid_argument);
+}
+
+TEST(LockFreeQueueTest, MultipleProducers) {
+    LockFreeQueue<int> queue(64);
+    const int producers = 4;
+    const int perProducer = 10000;
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&queue]() {
+            for (int i = 1; i <= perProducer; ++i) {
+                queue.push(i);
+            }
+        });
+    }
+
+    long long sum = 0;
+    int received = 0;
+    int value = 0;
+    while (received < producers * perProducer) {
+        if (queue.waitPop(value)) {
+            sum += value;
+            ++received;
+        }
+    }
+
+    for (auto& t : threads) t.join();
+    EXPECT_EQ(sum, static_cast<long long>(producers) * perProducer * (perProducer + 1) / 2);
+}
+
+TEST(LockFreeQueueTest, WaitPopWakesOnPush) {
+    LockFreeQueue<int> queue(8);
+    std::atomic<int> result(0);
+
+    std::thread consumer([&]() {
+        int value = 0;
+        if (queue.waitPop(value)) result = value;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    queue.push(42);
+    consumer.join();
+    EXPECT_EQ(result, 42);
+}
+
+TEST(LockFreeQueueTest, CloseReleasesWaiters) {
+    LockFreeQueue<int> queue(8);
+    std::atomic<bool> returned(false);
+
+    std::thread consumer([&]() {
+        int value = 0;
+        EXPECT_FALSE(queue.waitPop(value));
+        returned = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    queue.close();
+    consumer.join();
+    EXPECT_TRUE(returned);
+    EXPECT_FALSE(queue.push(1));
+}
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "map_renderer.h"
+
+class MapRendererTest : public ::testing::Test {
+protected:
+    WorldSnapshot snapshot;
+
+    void add(NpcType type, int x, int y, bool alive = true) {
+        snapshot.x.push_back(x);
+        snapshot.y.push_back(y);
+        snapshot.type.push_back(type);
+        snapshot.alive.push_back(alive ? 1 : 0);
+    }
+
+    static std::size_t count(const std::string& text, const std::string& part) {
+        std::size_t found = 0;
+        for (std::size_t pos = text.find(part); pos != std::string::npos; pos = text.find(part, pos + 1)) {
+            ++found;
+        }
+        return found;
+    }
+};
+
+TEST_F(MapRendererTest, PlainFrameKeepsConsoleFormat) {
+    add(NpcType::Dragon, 0, 0);
+    add(NpcType::Knight, 99, 99);
+    add(NpcType::Pegasus, 50, 0, false);
+
+    MapRenderer renderer(100, 100, 2, 2);
+    renderer.rasterize(snapshot);
+    EXPECT_EQ(renderer.compose(), "\n=== CURRENT MAP ===\n|D . |\n|. K |\nAlive: 2\n");
+
+    // Без режима Ansi каждый кадр целиком
+    EXPECT_EQ(renderer.compose(), "\n=== CURRENT MAP ===\n|D . |\n|. K |\nAlive: 2\n");
+}
+
+TEST_F(MapRendererTest, ScalesWorldToView) {
+    add(NpcType::Dragon, 0, 0);
+    add(NpcType::Knight, 499, 0);
+    add(NpcType::Pegasus, 250, 999);
+    // Координаты вне карты прижимаются к краю
+    add(NpcType::Knight, -5, 5000);
+
+    MapRenderer renderer(500, 1000, 500, 500);
+    renderer.rasterize(snapshot);
+    EXPECT_EQ(renderer.cell(0, 0), 'D');
+    EXPECT_EQ(renderer.cell(499, 0), 'K');
+    EXPECT_EQ(renderer.cell(250, 499), 'P');
+    EXPECT_EQ(renderer.cell(0, 499), 'K');
+    EXPECT_EQ(renderer.cell(1, 1), '.');
+    EXPECT_EQ(renderer.aliveCount(), 4u);
+
+    // 500 строк по 500 клеток и рамка
+    const std::string& frame = renderer.compose();
+    EXPECT_EQ(count(frame, "\n|"), 500u);
+    EXPECT_EQ(frame.size(), std::string("\n=== CURRENT MAP ===\n").size() +
+                            500 * (2 * 500 + 3) + std::string("Alive: 4\n").size());
+}
+
+TEST_F(MapRendererTest, AnsiRedrawsOnlyChangedCells) {
+    add(NpcType::Dragon, 0, 0);
+    add(NpcType::Knight, 9, 9);
+
+    MapRenderer renderer(10, 10, 10, 10, RenderMode::Ansi);
+    renderer.rasterize(snapshot);
+    std::string first = renderer.compose();
+    EXPECT_EQ(first.rfind("\x1b[2J", 0), 0u);
+    EXPECT_NE(first.find("\x1b[13r"), std::string::npos);
+
+    // Без изменений кадр пуст
+    renderer.rasterize(snapshot);
+    EXPECT_EQ(renderer.compose(), "");
+
+    // Дракон сдвинулся на клетку вправо: старая клетка стирается,
+    // новая рисуется без второго перемещения курсора
+    snapshot.x[0] = 1;
+    renderer.rasterize(snapshot);
+    std::string diff = renderer.compose();
+    EXPECT_EQ(diff, "\x1b" "7" "\x1b[2;2H. D " "\x1b[12;1HAlive: 2\x1b[K" "\x1b" "8");
+
+    // Гибель меняет клетку и счетчик
+    snapshot.alive[1] = 0;
+    renderer.rasterize(snapshot);
+    diff = renderer.compose();
+    EXPECT_NE(diff.find("\x1b[11;20H. "), std::string::npos);
+    EXPECT_NE(diff.find("Alive: 1"), std::string::npos);
+
+    EXPECT_EQ(renderer.finish(), "\x1b" "7" "\x1b[r" "\x1b" "8");
+
+    // После reset кадр снова целиком
+    renderer.reset();
+    EXPECT_EQ(renderer.compose().rfind("\x1b[2J", 0), 0u);
+}
+
+TEST_F(MapRendererTest, RejectsBadSize) {
+    EXPECT_THROW(MapRenderer(100, 100, 0, 10), std::invalid_argument);
+    EXPECT_THROW(MapRenderer(100, 100, 10, MapRenderer::MAX_VIEW_SIZE + 1), std::invalid_argument);
+    EXPECT_THROW(MapRenderer(0, 100, 10, 10), std::invalid_argument);
+    EXPECT_THROW(MapRenderer(100, 100, 10, 10).cell(10, 0), std::out_of_range);
+}
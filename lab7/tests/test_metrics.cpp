@@ -0,0 +1,247 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "metrics.h"
+#include "game.h"
+
+namespace {
+
+const std::string METRICS_PATH = "test_metrics.prom";
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+// Значение строки "name value" из выгрузки, -1 если строки нет
+double sample(const std::string& text, const std::string& name) {
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line)) {
+        if (line.compare(0, name.size() + 1, name + " ") == 0) {
+            return std::stod(line.substr(name.size() + 1));
+        }
+    }
+    return -1.0;
+}
+
+} // namespace
+
+TEST(MetricsTest, BucketsArePowersOfTwo) {
+    // Время: корзины по 1, 2, 4... мкс
+    EXPECT_EQ(metrics::bucketOf(metrics::TickTotal, 0), 0u);
+    EXPECT_EQ(metrics::bucketOf(metrics::TickTotal, 1000), 0u);
+    EXPECT_EQ(metrics::bucketOf(metrics::TickTotal, 1001), 1u);
+    EXPECT_EQ(metrics::bucketOf(metrics::TickTotal, 2000), 1u);
+    EXPECT_EQ(metrics::bucketOf(metrics::TickTotal, 2001), 2u);
+    EXPECT_EQ(metrics::bucketOf(metrics::TickTotal, 1ull << 62), metrics::BUCKETS);
+
+    // Счеты: корзины по 1, 2, 4... штук
+    EXPECT_EQ(metrics::bucketOf(metrics::QueueDepth, 0), 0u);
+    EXPECT_EQ(metrics::bucketOf(metrics::QueueDepth, 1), 0u);
+    EXPECT_EQ(metrics::bucketOf(metrics::QueueDepth, 2), 1u);
+    EXPECT_EQ(metrics::bucketOf(metrics::QueueDepth, 3), 2u);
+    EXPECT_EQ(metrics::bucketOf(metrics::QueueDepth, 4), 2u);
+    EXPECT_EQ(metrics::bucketOf(metrics::QueueDepth, 5), 3u);
+}
+
+TEST(MetricsTest, SumsCountersOfAllThreads) {
+    constexpr int THREADS = 4;
+    constexpr int ADDS = 10000;
+    metrics::Snapshot before = metrics::collect();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([] {
+            for (int i = 0; i < ADDS; ++i) {
+                metrics::add(metrics::LockWaits);
+            }
+            metrics::observe(metrics::QueueDepth, 3);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Счетчики завершившихся потоков не теряются
+    metrics::Snapshot after = metrics::collect();
+    EXPECT_EQ(after.counters[metrics::LockWaits] - before.counters[metrics::LockWaits],
+              static_cast<std::uint64_t>(THREADS * ADDS));
+    const auto& depthBefore = before.histograms[metrics::QueueDepth];
+    const auto& depthAfter = after.histograms[metrics::QueueDepth];
+    EXPECT_EQ(depthAfter.buckets[2] - depthBefore.buckets[2], static_cast<std::uint64_t>(THREADS));
+    EXPECT_EQ(depthAfter.count - depthBefore.count, static_cast<std::uint64_t>(THREADS));
+    EXPECT_EQ(depthAfter.sum - depthBefore.sum, static_cast<std::uint64_t>(3 * THREADS));
+}
+
+TEST(MetricsTest, CountsAllocations) {
+    std::uint64_t before = metrics::allocations();
+    {
+        auto value = std::make_unique<int>(7);
+        std::vector<int> values(100);
+        EXPECT_EQ(*value + values[0], 7);
+    }
+    EXPECT_GE(metrics::allocations() - before, 2u);
+}
+
+TEST(MetricsTest, CountsAlignedAllocations) {
+    struct alignas(64) Wide {
+        char bytes[64];
+    };
+    std::uint64_t before = metrics::allocations();
+    {
+        auto single = std::make_unique<Wide>();
+        std::unique_ptr<Wide[]> array(new (std::nothrow) Wide[3]);
+        ASSERT_NE(array, nullptr);
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(single.get()) % 64, 0u);
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(array.get()) % 64, 0u);
+    }
+    EXPECT_EQ(metrics::allocations() - before, 2u);
+}
+
+TEST(MetricsTest, ReusesSlotsOfFinishedThreads) {
+    // Потоков за время работы больше, чем слотов, но живут они по одному
+    constexpr int THREADS = static_cast<int>(metrics::MAX_THREADS) + 44;
+    metrics::Snapshot before = metrics::collect();
+    std::size_t slots = metrics::threadSlots();
+    for (int t = 0; t < THREADS; ++t) {
+        std::thread([] { metrics::add(metrics::LockWaits); }).join();
+    }
+    EXPECT_LE(metrics::threadSlots(), slots + 1);
+
+    metrics::Snapshot after = metrics::collect();
+    EXPECT_EQ(after.counters[metrics::LockWaits] - before.counters[metrics::LockWaits],
+              static_cast<std::uint64_t>(THREADS));
+}
+
+TEST(MetricsTest, FormatsPrometheusText) {
+    metrics::Snapshot snapshot;
+    auto& depth = snapshot.histograms[metrics::QueueDepth];
+    depth.buckets[0] = 2;
+    depth.buckets[3] = 1;
+    depth.count = 3;
+    depth.sum = 7;
+    auto& move = snapshot.histograms[metrics::MovePhase];
+    move.buckets[1] = 1;
+    move.count = 1;
+    move.sum = 1500;
+    snapshot.counters[metrics::Fights] = 42;
+    snapshot.counters[metrics::LockWaitNanos] = 2500000000ull;
+    snapshot.gauges[metrics::AliveNpcs] = 17;
+    snapshot.gauges[metrics::ShardImbalance] = 1.25;
+
+    std::string text = metrics::formatPrometheus(snapshot, 12.5, 0.0);
+    EXPECT_NE(text.find("# TYPE dungeon_battle_queue_depth histogram\n"), std::string::npos);
+    // Корзины накопленные
+    EXPECT_NE(text.find("dungeon_battle_queue_depth_bucket{le=\"1\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("dungeon_battle_queue_depth_bucket{le=\"4\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("dungeon_battle_queue_depth_bucket{le=\"8\"} 3\n"), std::string::npos);
+    EXPECT_NE(text.find("dungeon_battle_queue_depth_bucket{le=\"+Inf\"} 3\n"), std::string::npos);
+    EXPECT_EQ(sample(text, "dungeon_battle_queue_depth_sum"), 7.0);
+    EXPECT_EQ(sample(text, "dungeon_battle_queue_depth_count"), 3.0);
+
+    // Время - в секундах, фазы различаются меткой
+    EXPECT_NE(text.find("dungeon_tick_phase_seconds_bucket{phase=\"move\",le=\"2e-06\"} 1\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("dungeon_tick_phase_seconds_sum{phase=\"move\"} 1.5e-06\n"),
+              std::string::npos);
+    EXPECT_EQ(text.find("# TYPE dungeon_tick_phase_seconds"),
+              text.rfind("# TYPE dungeon_tick_phase_seconds"));
+
+    EXPECT_EQ(sample(text, "dungeon_fights_total"), 42.0);
+    EXPECT_EQ(sample(text, "dungeon_npc_lock_wait_seconds_total"), 2.5);
+    EXPECT_EQ(sample(text, "dungeon_alive_npcs"), 17.0);
+    EXPECT_EQ(sample(text, "dungeon_shard_imbalance"), 1.25);
+    EXPECT_EQ(sample(text, "dungeon_fights_per_second"), 12.5);
+}
+
+TEST(MetricsTest, ExporterReplacesFile) {
+    std::remove(METRICS_PATH.c_str());
+    EXPECT_THROW(metrics::Exporter("", std::chrono::milliseconds(10)), std::invalid_argument);
+    EXPECT_THROW(metrics::Exporter(METRICS_PATH, std::chrono::milliseconds(0)),
+                 std::invalid_argument);
+
+    {
+        metrics::Exporter exporter(METRICS_PATH, std::chrono::milliseconds(5));
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        EXPECT_NE(readFile(METRICS_PATH).find("# TYPE dungeon_tick_seconds histogram"),
+                  std::string::npos);
+        metrics::add(metrics::Kills, 5);
+        exporter.exportNow();
+        EXPECT_GE(sample(readFile(METRICS_PATH), "dungeon_kills_total"), 5.0);
+    }
+    std::ifstream temporary(METRICS_PATH + ".tmp");
+    EXPECT_FALSE(temporary.is_open());
+    std::remove(METRICS_PATH.c_str());
+}
+
+TEST(MetricsTest, GameRecordsEveryTick) {
+    std::remove(METRICS_PATH.c_str());
+    GameConfig config;
+    config.headless = true;
+    config.mapWidth = 60;
+    config.mapHeight = 60;
+    config.npcCount = 400;
+    config.maxTicks = 30;
+    config.seed = 11;
+    config.metricsPath = METRICS_PATH;
+
+    metrics::Snapshot before = metrics::collect();
+    SimulationStats stats;
+    {
+        Game game(config);
+        game.initialize();
+        stats = game.runHeadless();
+    }
+    metrics::Snapshot after = metrics::collect();
+
+    auto delta = [&](metrics::Counter counter) {
+        return after.counters[counter] - before.counters[counter];
+    };
+    EXPECT_EQ(delta(metrics::Ticks), static_cast<std::uint64_t>(stats.ticks));
+    EXPECT_EQ(delta(metrics::Fights), stats.fights);
+    EXPECT_EQ(delta(metrics::Kills), stats.kills);
+    EXPECT_GT(delta(metrics::Allocations), 0u);
+    for (metrics::Histogram phase : {metrics::MovePhase, metrics::MigratePhase, metrics::DetectPhase,
+                                     metrics::BattlePhase, metrics::TickTotal,
+                                     metrics::QueueDepth, metrics::TickAllocations}) {
+        EXPECT_EQ(after.histograms[phase].count - before.histograms[phase].count,
+                  static_cast<std::uint64_t>(stats.ticks)) << "histogram " << phase;
+    }
+    EXPECT_EQ(after.gauges[metrics::AliveNpcs], static_cast<double>(stats.survivors));
+
+    // Итоговая выгрузка при остановке игры
+    std::string text = readFile(METRICS_PATH);
+    EXPECT_EQ(sample(text, "dungeon_ticks_total"), static_cast<double>(after.counters[metrics::Ticks]));
+    std::remove(METRICS_PATH.c_str());
+}
+
+TEST(MetricsTest, GameExportsShardImbalance) {
+    GameConfig config;
+    config.npcCount = 300;
+    config.movementShards = 2;
+    config.rebalanceTicks = 0;  // полосы не меняются, метрика все равно считается
+    config.seed = 5;
+    Game game(config);
+    // До первого окна шарды считаются равными
+    metrics::set(metrics::ShardImbalance, 0.0);
+    game.initialize();
+    ASSERT_EQ(game.shardCount(), 2u);
+    EXPECT_DOUBLE_EQ(metrics::collect().gauges[metrics::ShardImbalance], 1.0);
+
+    // Первый шард втрое дороже второго: самый долгий / средний = 3 / 2
+    game.setShardCost([](std::size_t shard, std::size_t) { return shard == 0 ? 3.0 : 1.0; });
+    // Окно метрики без балансировки - 50 тактов
+    for (int tick = 0; tick < 50; ++tick) {
+        game.movementTick();
+        game.clearBattleTasks();
+    }
+    EXPECT_DOUBLE_EQ(game.shardBalance().imbalance, 1.5);
+    EXPECT_DOUBLE_EQ(metrics::collect().gauges[metrics::ShardImbalance], 1.5);
+}
@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include <memory>
 #include <sstream>
+#include <thread>
+#include <atomic>
 #include "npc.h"
 #include "dragon.h"
 #include "knight.h"
@@ -115,3 +117,63 @@ TEST_F(NPCTest, StreamOutput) {
     EXPECT_NE(ss.str().find("Dragon"), std::string::npos);
     EXPECT_NE(ss.str().find("Smaug"), std::string::npos);
 }
+
+TEST_F(NPCTest, FightKillsDefender) {
+    auto victim = std::make_shared<Dragon>(100, 200, "Victim");
+    knight->setId(1);
+    victim->setId(2);
+
+    EXPECT_EQ(knight->fight(*victim, 2, 5), FightOutcome::Survived);
+    EXPECT_TRUE(victim->isAlive());
+
+    EXPECT_EQ(knight->fight(*victim, 6, 1), FightOutcome::Killed);
+    EXPECT_FALSE(victim->isAlive());
+    EXPECT_TRUE(knight->isAlive());
+
+    // Мертвого второй раз не убивают
+    EXPECT_EQ(knight->fight(*victim, 6, 1), FightOutcome::Skipped);
+}
+
+TEST_F(NPCTest, FightsOfOneTickAreSimultaneous) {
+    auto knight = std::make_shared<Knight>(0, 0, "Knight");
+    auto dragon = std::make_shared<Dragon>(0, 0, "Dragon");
+    auto pegasus = std::make_shared<Pegasus>(0, 0, "Pegasus");
+    knight->setId(1);
+    dragon->setId(2);
+    pegasus->setId(3);
+
+    // Дракон убит на такте 5, но на этом же такте еще атакует
+    EXPECT_EQ(knight->fight(*dragon, 6, 1, 5), FightOutcome::Killed);
+    EXPECT_EQ(dragon->fight(*pegasus, 6, 1, 5), FightOutcome::Killed);
+    EXPECT_FALSE(pegasus->isAlive());
+
+    // На следующем такте он уже мертв
+    auto other = std::make_shared<Pegasus>(0, 0, "Other");
+    other->setId(4);
+    EXPECT_EQ(dragon->fight(*other, 6, 1, 6), FightOutcome::Skipped);
+    EXPECT_TRUE(other->isAlive());
+
+    // Убитый вне тактов не атакует никогда
+    dragon->setAlive(true);
+    dragon->setAlive(false);
+    EXPECT_EQ(dragon->fight(*other, 6, 1, 0), FightOutcome::Skipped);
+}
+
+TEST_F(NPCTest, ConcurrentOpposingFights) {
+    // Встречные бои из двух потоков: без взаимоблокировки и ровно одна смерть
+    for (int round = 0; round < 200; ++round) {
+        auto a = std::make_shared<Dragon>(0, 0, "A");
+        auto b = std::make_shared<Dragon>(0, 0, "B");
+        a->setId(1);
+        b->setId(2);
+
+        std::atomic<int> kills(0);
+        std::thread t1([&]() { if (a->fight(*b, 6, 1) == FightOutcome::Killed) ++kills; });
+        FightOutcome second = b->fight(*a, 6, 1);
+        t1.join();
+        if (second == FightOutcome::Killed) ++kills;
+
+        EXPECT_EQ(kills, 1);
+        EXPECT_NE(a->isAlive(), b->isAlive());
+    }
+}
@@ -2,6 +2,8 @@
 #include <sstream>
 #include <fstream>
 #include <memory>
+#include <atomic>
+#include <thread>
 #include "observer.h"
 #include "dragon.h"
 #include "knight.h"
@@ -135,4 +137,88 @@ TEST_F(ObserverTest, FileObserverConstructorDestructor) {
     EXPECT_NE(content.find("TestDragon"), std::string::npos);
     EXPECT_NE(content.find("TestKnight"), std::string::npos);
     logFile.close();
-}
\ No newline at end of file
+}
+
+TEST_F(ObserverTest, FileObserverThroughFightLog) {
+    auto log = std::make_shared<FightLog>(std::chrono::milliseconds(1000));
+    {
+        FileObserver observer("test_log.txt", log);
+        observer.onFight(knight, dragon, true);
+        observer.onFight(dragon, knight, false);
+    }
+    // Наблюдатель уже удален, запись завершает поток лога
+    log->flush();
+    
+    std::ifstream logFile("test_log.txt");
+    std::string content((std::istreambuf_iterator<char>(logFile)),
+                        std::istreambuf_iterator<char>());
+    EXPECT_NE(content.find("Battle: Knight 'TestKnight' at (0, 0) killed Dragon 'TestDragon'"),
+              std::string::npos);
+    EXPECT_EQ(content.find("killed Knight"), std::string::npos);
+}
+
+TEST_F(ObserverTest, RegistrySharedByNpcs) {
+    auto registry = std::make_shared<ObserverRegistry>();
+    registry->subscribe(mockObserver);
+    dragon->setObserverRegistry(registry);
+    knight->setObserverRegistry(registry);
+    
+    dragon->notifyFight(knight, true);
+    knight->notifyFight(dragon, false);
+    EXPECT_EQ(mockObserver->fightCount, 2);
+    EXPECT_EQ(mockObserver->lastAttacker, knight);
+    
+    // Собственный наблюдатель NPC добавляется к общим
+    auto own = std::make_shared<MockObserver>();
+    dragon->subscribe(own);
+    dragon->notifyFight(knight, true);
+    EXPECT_EQ(mockObserver->fightCount, 3);
+    EXPECT_EQ(own->fightCount, 1);
+    
+    registry->unsubscribe(mockObserver);
+    EXPECT_EQ(registry->size(), 0u);
+    knight->notifyFight(dragon, true);
+    EXPECT_EQ(mockObserver->fightCount, 3);
+}
+
+TEST_F(ObserverTest, RegistrySnapshotOutlivesChanges) {
+    ObserverRegistry registry;
+    registry.subscribe(mockObserver);
+    
+    // Читатель держит старый список, запись его не меняет
+    auto snapshot = registry.snapshot();
+    registry.subscribe(std::make_shared<MockObserver>());
+    registry.clear();
+    
+    EXPECT_EQ(snapshot->size(), 1u);
+    EXPECT_EQ(registry.size(), 0u);
+}
+
+TEST_F(ObserverTest, RegistryConcurrentNotifyAndSubscribe) {
+    // Счетчик атомарный: проверяем, что запись в реестр не теряет уведомления
+    class CountingObserver : public IFightObserver {
+    public:
+        std::atomic<int> count{0};
+        void onFight(const std::shared_ptr<NPC>&, const std::shared_ptr<NPC>&, bool) override {
+            ++count;
+        }
+    };
+    auto registry = std::make_shared<ObserverRegistry>();
+    auto counter = std::make_shared<CountingObserver>();
+    registry->subscribe(counter);
+    dragon->setObserverRegistry(registry);
+    
+    std::thread writer([&]() {
+        for (int i = 0; i < 200; ++i) {
+            auto extra = std::make_shared<CountingObserver>();
+            registry->subscribe(extra);
+            registry->unsubscribe(extra);
+        }
+    });
+    for (int i = 0; i < 1000; ++i) {
+        dragon->notifyFight(knight, true);
+    }
+    writer.join();
+    
+    EXPECT_EQ(counter->count, 1000);
+}
@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <thread>
+#include "philox.h"
+#include "dragon.h"
+#include "knight.h"
+
+// Контрольные значения из набора тестов Random123 (kat_vectors)
+TEST(PhiloxTest, KnownAnswers) {
+    EXPECT_EQ(philox::generate({0, 0, 0, 0}, {0, 0}),
+              (philox::Counter{0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u}));
+
+    EXPECT_EQ(philox::generate({0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu},
+                               {0xffffffffu, 0xffffffffu}),
+              (philox::Counter{0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu}));
+
+    EXPECT_EQ(philox::generate({0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u},
+                               {0xa4093822u, 0x299f31d0u}),
+              (philox::Counter{0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u}));
+}
+
+TEST(PhiloxTest, DiceAreUniform) {
+    std::array<int, 7> counts{};
+    for (std::uint32_t tick = 0; tick < 60000; ++tick) {
+        int roll = philox::rollDie(123, tick, 7, 9, philox::Attack);
+        ASSERT_GE(roll, 1);
+        ASSERT_LE(roll, 6);
+        ++counts[roll];
+    }
+    for (int face = 1; face <= 6; ++face) {
+        EXPECT_NEAR(counts[face], 10000, 500);
+    }
+}
+
+TEST(PhiloxTest, RollsAreReproducible) {
+    auto dragon = std::make_shared<Dragon>(0, 0, "D");
+    auto knight = std::make_shared<Knight>(0, 0, "K");
+    dragon->setId(1);
+    knight->setId(2);
+
+    // Один и тот же ключ дает один и тот же бросок в любом потоке
+    int attack = knight->rollAttack(99, 5, dragon->getId());
+    int fromThread = 0;
+    std::thread t([&]() { fromThread = knight->rollAttack(99, 5, dragon->getId()); });
+    t.join();
+    EXPECT_EQ(attack, fromThread);
+
+    // Разные такты и seed дают разные последовательности
+    int differences = 0;
+    for (std::uint32_t tick = 0; tick < 100; ++tick) {
+        if (knight->rollAttack(1, tick, 1) != knight->rollAttack(2, tick, 1)) ++differences;
+    }
+    EXPECT_GT(differences, 50);
+}
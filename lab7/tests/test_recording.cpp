@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include "recording.h"
+#include "game.h"
+
+class RecordingTest : public ::testing::Test {
+protected:
+    const std::string path = "test_recording.rec";
+
+    void SetUp() override {
+        std::remove(path.c_str());
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+
+    static Recording run(std::size_t workers) {
+        GameConfig config;
+        config.headless = true;
+        config.record = true;
+        config.mapWidth = 40;
+        config.mapHeight = 40;
+        config.npcCount = 400;
+        config.maxTicks = 60;
+        config.battleWorkers = workers;
+        config.seed = 2024;
+
+        Game game(config);
+        game.initialize();
+        game.runHeadless();
+        return game.recording();
+    }
+};
+
+TEST_F(RecordingTest, SavesAndLoads) {
+    Recording recording;
+    recording.seed = 12345678901234ULL;
+    recording.mapWidth = 300;
+    recording.mapHeight = 200;
+    recording.npcCount = 50;
+    recording.ticks = 17;
+    recording.fights = {{3, 1, 2, true}, {3, 7, 4, false}, {16, 9, 8, true}};
+    recording.save(path);
+
+    Recording loaded = Recording::load(path);
+    EXPECT_EQ(loaded.seed, recording.seed);
+    EXPECT_EQ(loaded.mapWidth, 300);
+    EXPECT_EQ(loaded.mapHeight, 200);
+    EXPECT_EQ(loaded.npcCount, 50);
+    EXPECT_EQ(loaded.ticks, 17);
+    EXPECT_EQ(loaded.fights, recording.fights);
+    EXPECT_EQ(firstDifference(recording, loaded), "");
+}
+
+TEST_F(RecordingTest, RejectsDamagedFile) {
+    EXPECT_THROW(Recording::load("no_such_recording.rec"), std::runtime_error);
+
+    {
+        std::ofstream file(path);
+        file << "DNGREC 1\nseed 1\nmap 10 10\nnpcs 2\nticks 5\nfights 2\n0 1 0 K\n";
+    }
+    EXPECT_THROW(Recording::load(path), std::runtime_error);
+
+    {
+        std::ofstream file(path);
+        file << "DNGREC 1\nseed 1\nmap 10 10\nnpcs 2\nticks 5\nfights 1\n0 1 0 X\n";
+    }
+    EXPECT_THROW(Recording::load(path), std::runtime_error);
+}
+
+TEST_F(RecordingTest, ReportsFirstDifference) {
+    Recording expected;
+    expected.seed = 1;
+    expected.fights = {{0, 1, 2, true}, {1, 3, 4, false}};
+
+    Recording actual = expected;
+    EXPECT_EQ(firstDifference(expected, actual), "");
+
+    // Число тактов не сравнивается
+    actual.ticks = 100;
+    EXPECT_EQ(firstDifference(expected, actual), "");
+
+    actual.fights[1].killed = true;
+    EXPECT_NE(firstDifference(expected, actual).find("fight #2"), std::string::npos);
+
+    actual.fights.pop_back();
+    EXPECT_NE(firstDifference(expected, actual).find("missing fight #2"), std::string::npos);
+
+    actual = expected;
+    actual.fights.push_back({2, 5, 6, false});
+    EXPECT_NE(firstDifference(expected, actual).find("extra fight #3"), std::string::npos);
+
+    actual = expected;
+    actual.seed = 2;
+    EXPECT_NE(firstDifference(expected, actual).find("seed"), std::string::npos);
+}
+
+TEST_F(RecordingTest, SortsFightsCanonically) {
+    Recording recording;
+    recording.fights = {{2, 1, 5, false}, {1, 9, 3, true}, {2, 0, 5, true}, {1, 2, 4, false}};
+    recording.sortFights();
+
+    std::vector<FightRecord> sorted = {{1, 9, 3, true}, {1, 2, 4, false},
+                                       {2, 0, 5, true}, {2, 1, 5, false}};
+    EXPECT_EQ(recording.fights, sorted);
+}
+
+TEST_F(RecordingTest, SameSeedGivesSameWorld) {
+    GameConfig config;
+    config.npcCount = 100;
+    config.seed = 99;
+
+    Game first(config);
+    Game second(config);
+    first.initialize();
+    second.initialize();
+    first.saveSnapshot(path);
+    std::string firstBytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        firstBytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    second.saveSnapshot(path);
+    std::ifstream in(path, std::ios::binary);
+    std::string secondBytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(firstBytes, secondBytes);
+}
+
+TEST_F(RecordingTest, ReplayMatchesAcrossThreadCounts) {
+    Recording single = run(1);
+    EXPECT_EQ(single.seed, 2024u);
+    EXPECT_EQ(single.npcCount, 400);
+    EXPECT_GT(single.ticks, 0);
+    ASSERT_FALSE(single.fights.empty());
+
+    // Повтор с тем же и с другим числом потоков боя
+    for (std::size_t workers : {1u, 4u}) {
+        Recording again = run(workers);
+        EXPECT_EQ(firstDifference(single, again), "") << workers << " workers";
+        EXPECT_EQ(again.ticks, single.ticks);
+    }
+}
+
+TEST_F(RecordingTest, NothingRecordedWhenDisabled) {
+    GameConfig config;
+    config.headless = true;
+    config.mapWidth = 40;
+    config.mapHeight = 40;
+    config.npcCount = 400;
+    config.maxTicks = 20;
+    config.seed = 2024;
+
+    Game game(config);
+    game.initialize();
+    game.runHeadless();
+    Recording recording = game.recording();
+    EXPECT_GT(recording.ticks, 0);
+    EXPECT_TRUE(recording.fights.empty());
+}
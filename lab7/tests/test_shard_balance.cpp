@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+#include "shard_balance.h"
+#include "binary_snapshot.h"
+#include "game.h"
+
+TEST(ShardBalanceTest, Imbalance) {
+    EXPECT_DOUBLE_EQ(shard_balance::imbalance({}), 1.0);
+    EXPECT_DOUBLE_EQ(shard_balance::imbalance({0.0, 0.0}), 1.0);
+    EXPECT_DOUBLE_EQ(shard_balance::imbalance({2.0, 2.0, 2.0}), 1.0);
+    EXPECT_DOUBLE_EQ(shard_balance::imbalance({3.0, 1.0}), 1.5);
+    EXPECT_DOUBLE_EQ(shard_balance::imbalance({4.0, 0.0, 0.0, 0.0}), 4.0);
+}
+
+TEST(ShardBalanceTest, SplitsByCost) {
+    // Вся цена в первых строках - полосы там узкие
+    std::vector<double> costs = {4, 4, 4, 4, 0, 0, 0, 0, 0, 0};
+    EXPECT_EQ(shard_balance::split(costs, 4), (std::vector<int>{0, 1, 2, 3}));
+
+    std::vector<double> even(12, 1.0);
+    EXPECT_EQ(shard_balance::split(even, 3), (std::vector<int>{0, 4, 8}));
+
+    // Без цены - поровну
+    std::vector<double> zero(8, 0.0);
+    EXPECT_EQ(shard_balance::split(zero, 4), (std::vector<int>{0, 2, 4, 6}));
+}
+
+TEST(ShardBalanceTest, EveryStripGetsARow) {
+    // Вся цена в одной строке: остальные полосы получают по строке
+    std::vector<double> costs = {0, 0, 100, 0, 0};
+    std::vector<int> rows = shard_balance::split(costs, 4);
+    ASSERT_EQ(rows.size(), 4u);
+    EXPECT_EQ(rows[0], 0);
+    for (std::size_t s = 1; s < rows.size(); ++s) {
+        EXPECT_GT(rows[s], rows[s - 1]);
+    }
+    EXPECT_LT(rows.back(), 5);
+
+    EXPECT_EQ(shard_balance::split(costs, 5), (std::vector<int>{0, 1, 2, 3, 4}));
+    EXPECT_THROW(shard_balance::split(costs, 6), std::invalid_argument);
+    EXPECT_THROW(shard_balance::split(costs, 0), std::invalid_argument);
+}
+
+TEST(ShardBalanceTest, GameRebalancesSkewedMap) {
+    // Все NPC в верхней десятой части карты
+    const std::string path = "test_shard_balance.dsnp";
+    snapshot::Columns columns;
+    const NpcType types[] = {NpcType::Dragon, NpcType::Knight, NpcType::Pegasus};
+    for (std::uint32_t i = 0; i < 3000; ++i) {
+        columns.add(i, types[i % 3], static_cast<int>(i * 7 % 500), static_cast<int>(i * 13 % 50),
+                    true, "NPC");
+    }
+    snapshot::write(path, columns);
+
+    GameConfig config;
+    config.movementShards = 4;
+    config.rebalanceTicks = 5;
+    config.seed = 21;
+    Game game(config);
+    // Цена шарда - число его NPC: замер процессорного времени шумит,
+    // а исход теста не должен от него зависеть
+    game.setShardCost([](std::size_t, std::size_t npcs) { return static_cast<double>(npcs); });
+    game.loadSnapshot(path);
+    std::remove(path.c_str());
+    ASSERT_EQ(game.shardCount(), 4u);
+
+    // Статичные полосы поровну: почти все NPC у первого шарда
+    ShardBalance before = game.shardBalance();
+    ASSERT_EQ(before.npcs.size(), 4u);
+    EXPECT_GT(before.npcs[0], 2900u);
+
+    for (int tick = 0; tick < 21; ++tick) {
+        game.movementTick();
+        game.clearBattleTasks();
+    }
+
+    ShardBalance after = game.shardBalance();
+    EXPECT_GE(after.rebalances, 1u);
+    EXPECT_GT(after.imbalance, 0.0);
+    ASSERT_EQ(after.firstRows.size(), 4u);
+    EXPECT_NE(after.firstRows, before.firstRows);
+
+    std::size_t peak = 0;
+    std::size_t total = 0;
+    for (std::size_t count : after.npcs) {
+        peak = std::max(peak, count);
+        total += count;
+    }
+    EXPECT_LT(static_cast<double>(peak) * after.npcs.size() / total, 1.5);
+}
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "shard_pool.h"
+
+TEST(ShardPoolTest, RunsEveryShardOncePerPhase) {
+    ShardPool pool(4);
+    EXPECT_EQ(pool.size(), 4u);
+
+    std::vector<int> calls(4, 0);
+    for (int phase = 0; phase < 100; ++phase) {
+        pool.run([&](std::size_t shard) { ++calls[shard]; });
+    }
+    EXPECT_EQ(calls, (std::vector<int>{100, 100, 100, 100}));
+}
+
+TEST(ShardPoolTest, PhasesDoNotOverlap) {
+    ShardPool pool(3);
+    std::vector<int> values(3, 0);
+    std::atomic<int> mismatches(0);
+
+    for (int phase = 1; phase <= 200; ++phase) {
+        pool.run([&](std::size_t shard) { values[shard] = phase; });
+        // Следующая фаза видит записи всех шардов прошлой фазы
+        pool.run([&](std::size_t shard) {
+            if (values[(shard + 1) % values.size()] != phase) ++mismatches;
+        });
+    }
+    EXPECT_EQ(mismatches, 0);
+}
+
+TEST(ShardPoolTest, SameShardSameThread) {
+    ShardPool pool(3);
+    std::vector<std::thread::id> owners(3);
+    pool.run([&](std::size_t shard) { owners[shard] = std::this_thread::get_id(); });
+    EXPECT_EQ(owners[0], std::this_thread::get_id());
+
+    int moved = 0;
+    for (int phase = 0; phase < 50; ++phase) {
+        std::vector<std::thread::id> now(3);
+        pool.run([&](std::size_t shard) { now[shard] = std::this_thread::get_id(); });
+        if (now != owners) ++moved;
+    }
+    EXPECT_EQ(moved, 0);
+}
+
+TEST(ShardPoolTest, RethrowsJobErrors) {
+    ShardPool pool(2);
+    EXPECT_THROW(pool.run([](std::size_t shard) {
+        if (shard == 1) throw std::runtime_error("shard failed");
+    }), std::runtime_error);
+
+    // Пул продолжает работать после ошибки
+    std::atomic<int> calls(0);
+    pool.run([&](std::size_t) { ++calls; });
+    EXPECT_EQ(calls, 2);
+
+    EXPECT_THROW(ShardPool(0), std::invalid_argument);
+}
@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <new>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "shm_ring.h"
+
+namespace {
+
+shm::Message numbered(std::uint32_t n) {
+    shm::Message m;
+    m.kind = shm::Message::Migrant;
+    m.id = n;
+    m.x = static_cast<std::int32_t>(n) * 2;
+    m.y = -static_cast<std::int32_t>(n);
+    return m;
+}
+
+// Ждет потомка и возвращает его код выхода
+int waitChild(pid_t pid) {
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+} // namespace
+
+TEST(ShmRingTest, PushesAndPopsInOrderAcrossWrap) {
+    shm::Segment segment(shm::Ring::bytes(4));
+    shm::Ring ring = shm::Ring::create(segment.get(), 4);
+
+    shm::Message m;
+    EXPECT_FALSE(ring.tryPop(m));
+
+    // Несколько кругов по кольцу на 4 слота
+    std::uint32_t next = 0;
+    std::uint32_t expected = 0;
+    for (int round = 0; round < 5; ++round) {
+        while (ring.tryPush(numbered(next))) ++next;
+        EXPECT_EQ(ring.size(), 4u);
+        for (int i = 0; i < 3; ++i) {
+            ASSERT_TRUE(ring.tryPop(m));
+            EXPECT_EQ(m.id, expected);
+            EXPECT_EQ(m.x, static_cast<std::int32_t>(expected) * 2);
+            EXPECT_EQ(m.y, -static_cast<std::int32_t>(expected));
+            ++expected;
+        }
+    }
+    while (ring.tryPop(m)) {
+        EXPECT_EQ(m.id, expected++);
+    }
+    EXPECT_EQ(expected, next);
+    EXPECT_EQ(ring.size(), 0u);
+}
+
+TEST(ShmRingTest, RejectsBadSizes) {
+    EXPECT_THROW(shm::Segment(0), std::invalid_argument);
+    shm::Segment segment(shm::Ring::bytes(1));
+    EXPECT_THROW(shm::Ring::create(segment.get(), 0), std::invalid_argument);
+}
+
+TEST(ShmRingTest, CarriesMessagesBetweenProcesses) {
+    constexpr std::uint32_t COUNT = 100000;
+    shm::Segment segment(shm::Ring::bytes(64));
+    shm::Ring ring = shm::Ring::create(segment.get(), 64);
+
+    pid_t pid = ::fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        unsigned spins = 0;
+        for (std::uint32_t n = 0; n < COUNT; ++n) {
+            while (!ring.tryPush(numbered(n))) shm::backoff(spins);
+        }
+        ::_exit(0);
+    }
+
+    // Кольцо маленькое: писатель много раз упирается в полное
+    std::uint32_t expected = 0;
+    bool ordered = true;
+    unsigned spins = 0;
+    shm::Message m;
+    while (expected < COUNT) {
+        if (!ring.tryPop(m)) {
+            shm::backoff(spins);
+            continue;
+        }
+        ordered = ordered && m.id == expected && m.x == static_cast<std::int32_t>(expected) * 2;
+        ++expected;
+    }
+    EXPECT_TRUE(ordered);
+    EXPECT_EQ(waitChild(pid), 0);
+}
+
+TEST(ShmRingTest, BarrierHoldsUntilAllArrive) {
+    constexpr int PROCESSES = 3;
+    constexpr std::uint32_t ROUNDS = 50;
+
+    struct Shared {
+        shm::Barrier barrier;
+        std::atomic<std::uint32_t> counter;
+        std::atomic<std::uint32_t> errors;
+    };
+    shm::Segment segment(sizeof(Shared));
+    auto* shared = new (segment.get()) Shared;
+    shared->barrier.init(PROCESSES + 1);
+    shared->counter = 0;
+    shared->errors = 0;
+
+    auto poll = [] { return true; };
+    std::vector<pid_t> children;
+    for (int p = 0; p < PROCESSES; ++p) {
+        pid_t pid = ::fork();
+        ASSERT_GE(pid, 0);
+        if (pid == 0) {
+            for (std::uint32_t round = 0; round < ROUNDS; ++round) {
+                shared->counter.fetch_add(1);
+                shared->barrier.arriveAndWait(poll);
+                // Все участники уже отметились в этом круге
+                if (shared->counter.load() < (round + 1) * (PROCESSES + 1)) {
+                    shared->errors.fetch_add(1);
+                }
+                shared->barrier.arriveAndWait(poll);
+            }
+            ::_exit(0);
+        }
+        children.push_back(pid);
+    }
+
+    for (std::uint32_t round = 0; round < ROUNDS; ++round) {
+        shared->counter.fetch_add(1);
+        shared->barrier.arriveAndWait(poll);
+        shared->barrier.arriveAndWait(poll);
+    }
+    for (pid_t pid : children) {
+        EXPECT_EQ(waitChild(pid), 0);
+    }
+    EXPECT_EQ(shared->errors.load(), 0u);
+    EXPECT_EQ(shared->counter.load(), ROUNDS * (PROCESSES + 1));
+}
+
+TEST(ShmRingTest, BarrierWaitStopsWhenPollFails) {
+    shm::Segment segment(sizeof(shm::Barrier));
+    auto* barrier = new (segment.get()) shm::Barrier;
+    barrier->init(2);
+
+    int calls = 0;
+    EXPECT_FALSE(barrier->arriveAndWait([&] { return ++calls < 3; }));
+    EXPECT_EQ(calls, 3);
+}
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <vector>
+#include "spatial_grid.h"
+
+class SpatialGridTest : public ::testing::Test {
+protected:
+    SpatialGrid grid{500, 500, 30};
+
+    std::vector<std::uint32_t> near(int x, int y, int radius) const {
+        std::vector<std::uint32_t> result;
+        grid.forEachNear(x, y, radius, [&](std::uint32_t id) { result.push_back(id); });
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+};
+
+TEST_F(SpatialGridTest, InsertAndQuery) {
+    grid.insert(1, 100, 100);
+    grid.insert(2, 110, 105);
+    grid.insert(3, 400, 400);
+
+    EXPECT_EQ(grid.size(), 3);
+    EXPECT_EQ(near(100, 100, 30), (std::vector<std::uint32_t>{1, 2}));
+    EXPECT_EQ(near(400, 400, 30), (std::vector<std::uint32_t>{3}));
+}
+
+TEST_F(SpatialGridTest, NeighbourCellsAreVisited) {
+    // Соседи по разные стороны границы ячейки (граница на x = 60)
+    grid.insert(1, 59, 10);
+    grid.insert(2, 61, 10);
+
+    EXPECT_EQ(near(59, 10, 30), (std::vector<std::uint32_t>{1, 2}));
+    EXPECT_EQ(near(61, 10, 30), (std::vector<std::uint32_t>{1, 2}));
+}
+
+TEST_F(SpatialGridTest, MoveBetweenCells) {
+    grid.insert(7, 10, 10);
+    grid.move(7, 10, 10, 300, 300);
+
+    EXPECT_EQ(grid.size(), 1);
+    EXPECT_TRUE(near(10, 10, 30).empty());
+    EXPECT_EQ(near(300, 300, 30), (std::vector<std::uint32_t>{7}));
+
+    // Перемещение внутри ячейки ничего не ломает
+    grid.move(7, 300, 300, 301, 301);
+    EXPECT_EQ(near(301, 301, 30), (std::vector<std::uint32_t>{7}));
+}
+
+TEST_F(SpatialGridTest, RemoveAndClear) {
+    grid.insert(1, 0, 0);
+    grid.insert(2, 500, 500);
+
+    grid.remove(1, 0, 0);
+    EXPECT_EQ(grid.size(), 1);
+    EXPECT_TRUE(near(0, 0, 30).empty());
+    EXPECT_EQ(near(500, 500, 30), (std::vector<std::uint32_t>{2}));
+
+    grid.clear();
+    EXPECT_EQ(grid.size(), 0);
+}
+
+TEST_F(SpatialGridTest, InvalidSize) {
+    EXPECT_THROW(SpatialGrid(500, 500, 0), std::invalid_argument);
+}
+
+TEST(SpatialGridStripTest, StoresOnlyItsRows) {
+    // Строки ячеек 5..9 карты 500x500 с ячейкой 30: y в [150, 300)
+    SpatialGrid strip(500, 500, 30, 5, 10);
+    EXPECT_EQ(strip.rowOf(150), 5);
+    EXPECT_EQ(SpatialGrid::rowCount(500, 30), 17);
+
+    strip.insert(1, 10, 150);
+    strip.insert(2, 40, 299);
+    strip.insert(3, 400, 200);
+    EXPECT_EQ(strip.size(), 3u);
+
+    std::vector<std::uint32_t> found;
+    strip.forEachNear(20, 160, 30, [&](std::uint32_t id) { found.push_back(id); });
+    std::sort(found.begin(), found.end());
+    EXPECT_EQ(found, (std::vector<std::uint32_t>{1}));
+
+    std::vector<std::uint32_t> row;
+    strip.forEachInRow(9, [&](std::uint32_t id) { row.push_back(id); });
+    EXPECT_EQ(row, (std::vector<std::uint32_t>{2}));
+
+    strip.clearRow(9);
+    EXPECT_EQ(strip.size(), 2u);
+
+    EXPECT_THROW(SpatialGrid(500, 500, 30, 10, 5), std::invalid_argument);
+    EXPECT_THROW(SpatialGrid(500, 500, 30, 0, 18), std::invalid_argument);
+}
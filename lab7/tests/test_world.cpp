@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include "world.h"
+#include "dragon.h"
+#include "knight.h"
+#include "observer.h"
+
+TEST(WorldTest, AddStoresColumns) {
+    World world(1000, 800);
+    NpcHandle a = world.add(NpcType::Dragon, 10, 20, true, 50, 30);
+    NpcHandle b = world.add(NpcType::Knight, 30, 40, false, 30, 10);
+
+    EXPECT_EQ(a, 0u);
+    EXPECT_EQ(b, 1u);
+    EXPECT_EQ(world.size(), 2u);
+    EXPECT_EQ(world.x(b), 30);
+    EXPECT_EQ(world.y(b), 40);
+    EXPECT_EQ(world.type(a), NpcType::Dragon);
+    EXPECT_EQ(world.moveDistance(a), 50);
+    EXPECT_EQ(world.killDistance(b), 10);
+    EXPECT_TRUE(world.isAlive(a));
+    EXPECT_FALSE(world.isAlive(b));
+}
+
+TEST(WorldTest, GrowsPastInitialCapacity) {
+    World world;
+    for (int i = 0; i < 1000; ++i) {
+        world.add(NpcType::Knight, i % 500, i % 300, i % 2 == 0, 30, 10);
+    }
+    // После перевыделения значения и флаги сохраняются
+    EXPECT_EQ(world.size(), 1000u);
+    EXPECT_EQ(world.x(999), 499);
+    EXPECT_TRUE(world.isAlive(998));
+    EXPECT_FALSE(world.isAlive(999));
+}
+
+TEST(WorldTest, InvalidSize) {
+    EXPECT_THROW(World(0, 100), std::invalid_argument);
+    EXPECT_THROW(World(100, -1), std::invalid_argument);
+}
+
+TEST(WorldTest, AttachedNpcIsViewOfRow) {
+    World world(2000, 2000);
+    auto dragon = std::make_shared<Dragon>(100, 200, "Smaug");
+    dragon->attach(world);
+
+    EXPECT_EQ(dragon->getWorld(), &world);
+    NpcHandle h = dragon->getHandle();
+
+    // Запись через NPC видна в колонках и наоборот
+    dragon->setPosition(1500, 1800);
+    EXPECT_EQ(world.x(h), 1500);
+    EXPECT_EQ(world.y(h), 1800);
+
+    world.setAlive(h, false);
+    EXPECT_FALSE(dragon->isAlive());
+
+    // Координаты за пределами мира не принимаются
+    dragon->setPosition(2500, 10);
+    EXPECT_EQ(dragon->getX(), 1500);
+    EXPECT_EQ(dragon->getY(), 10);
+}
+
+TEST(WorldTest, DetachKeepsState) {
+    World world;
+    auto knight = std::make_shared<Knight>(10, 20, "Arthur");
+    knight->attach(world);
+    knight->setPosition(40, 50);
+    knight->setAlive(false);
+
+    knight->detach();
+    world.clear();
+
+    EXPECT_EQ(knight->getWorld(), nullptr);
+    EXPECT_EQ(knight->getX(), 40);
+    EXPECT_EQ(knight->getY(), 50);
+    EXPECT_FALSE(knight->isAlive());
+}
+
+TEST(WorldTest, FightAndSaveUseWorldState) {
+    World world;
+    auto dragon = std::make_shared<Dragon>(100, 100, "Smaug");
+    auto knight = std::make_shared<Knight>(105, 100, "Arthur");
+    dragon->setId(1);
+    knight->setId(2);
+    dragon->attach(world);
+    knight->attach(world);
+
+    EXPECT_EQ(knight->fight(*dragon, 6, 1), FightOutcome::Killed);
+    EXPECT_FALSE(world.isAlive(dragon->getHandle()));
+
+    knight->setPosition(300, 400);
+    std::stringstream ss;
+    knight->save(ss);
+    EXPECT_EQ(ss.str(), "2\n300\n400\nArthur\n1\n\n");
+}
+
+namespace {
+
+class CountingObserver : public IFightObserver {
+public:
+    int fights = 0;
+
+    void onFight(const std::shared_ptr<NPC>&, const std::shared_ptr<NPC>&, bool) override {
+        ++fights;
+    }
+};
+
+} // namespace
+
+TEST(WorldTest, ColdDataMovesWithNpc) {
+    World world;
+    auto registry = std::make_shared<ObserverRegistry>();
+    auto shared = std::make_shared<CountingObserver>();
+    auto own = std::make_shared<CountingObserver>();
+    registry->subscribe(shared);
+
+    auto dragon = std::make_shared<Dragon>(10, 20, "Smaug");
+    dragon->setObserverRegistry(registry);
+    dragon->subscribe(own);
+    dragon->attach(world);
+
+    // Имя и наблюдатели теперь в боковых таблицах мира
+    NpcHandle h = dragon->getHandle();
+    EXPECT_EQ(world.name(h), "Smaug");
+    EXPECT_EQ(world.observerRegistry(), registry);
+    ASSERT_NE(world.ownObservers(h), nullptr);
+    EXPECT_EQ(world.ownObservers(h)->size(), 1u);
+
+    dragon->setName("Glaurung");
+    EXPECT_EQ(world.name(h), "Glaurung");
+    dragon->notifyFight(dragon, true);
+
+    dragon->detach();
+    world.clear();
+    EXPECT_EQ(dragon->getName(), "Glaurung");
+    dragon->notifyFight(dragon, true);
+    EXPECT_EQ(shared->fights, 2);
+    EXPECT_EQ(own->fights, 2);
+}
+
+TEST(WorldTest, FightBetweenNpcsSharingLockStripe) {
+    World world;
+    std::vector<std::shared_ptr<NPC>> npcs;
+    for (std::size_t i = 0; i <= World::LOCK_STRIPES; ++i) {
+        auto knight = std::make_shared<Knight>(0, 0, "Knight");
+        knight->setId(static_cast<std::uint32_t>(i));
+        knight->attach(world);
+        npcs.push_back(knight);
+    }
+    NPC& first = *npcs.front();
+    NPC& last = *npcs.back();
+    ASSERT_EQ(&world.rowMutex(first.getHandle()), &world.rowMutex(last.getHandle()));
+
+    // Общий мьютекс берется один раз, а не дважды
+    EXPECT_EQ(first.fight(last, 6, 1, 3), FightOutcome::Killed);
+    EXPECT_FALSE(last.isAlive());
+    EXPECT_EQ(last.fight(first, 6, 1, 4), FightOutcome::Skipped);
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include "world_snapshot.h"
+
+TEST(WorldSnapshotTest, PublishSwapsBuffers) {
+    SnapshotBuffer buffer;
+    WorldSnapshot initial;
+    initial.resize(2);
+    initial.x = {1, 2};
+    buffer.reset(initial);
+
+    WorldSnapshot& back = buffer.beginWrite();
+    // Задний буфер начинается с копии переднего
+    EXPECT_EQ(back.x, (std::vector<int>{1, 2}));
+    back.x[0] = 10;
+    back.tick = 1;
+
+    // До публикации читатели видят старый снимок
+    EXPECT_EQ(buffer.read()->x[0], 1);
+
+    buffer.publish();
+    auto snap = buffer.read();
+    EXPECT_EQ(snap->tick, 1u);
+    EXPECT_EQ(snap->x[0], 10);
+    EXPECT_EQ(snap->x[1], 2);
+}
+
+TEST(WorldSnapshotTest, ReadersSeeConsistentSnapshots) {
+    // Писатель заполняет весь снимок номером такта; читатель никогда
+    // не должен увидеть смесь двух тактов
+    const std::size_t count = 1000;
+    SnapshotBuffer buffer;
+    WorldSnapshot initial;
+    initial.resize(count);
+    buffer.reset(initial);
+
+    std::atomic<bool> done(false);
+    std::atomic<int> torn(0);
+    std::atomic<int> reads(0);
+
+    std::thread reader([&]() {
+        while (!done) {
+            auto snap = buffer.read();
+            for (std::size_t i = 0; i < count; ++i) {
+                if (snap->x[i] != static_cast<int>(snap->tick)) {
+                    ++torn;
+                    break;
+                }
+            }
+            ++reads;
+        }
+    });
+
+    while (reads == 0) {
+        std::this_thread::yield();
+    }
+    for (std::uint32_t tick = 1; tick <= 300; ++tick) {
+        WorldSnapshot& back = buffer.beginWrite();
+        back.tick = tick;
+        for (std::size_t i = 0; i < count; ++i) {
+            back.x[i] = static_cast<int>(tick);
+        }
+        buffer.publish();
+        if (tick % 10 == 0) std::this_thread::yield();
+    }
+    done = true;
+    reader.join();
+
+    EXPECT_EQ(torn, 0);
+    EXPECT_GT(reads, 0);
+}